@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Renders accuracy_bench JSON output as markdown tables.
+
+    accuracy_bench --benchmark_out=accuracy.json --benchmark_out_format=json
+    accuracy_report.py accuracy.json > accuracy.md
+
+One table per (benchmark, n, distribution, precision) with the swept parameter (depth or
+cutoff) as rows and time, GFLOPS, normwise and componentwise forward error as columns.
+Depth 0 rows are the classical algorithm and serve as the accuracy baseline.
+"""
+
+import json
+import sys
+
+
+def parse_args(name):
+    """'BM_AccuracyDepth/n:512/depth:2/dist:1/precision:0/real_time' -> family, {n: 512, ...}."""
+    parts = name.split("/")
+    values = {}
+    for part in parts[1:]:
+        if ":" in part:
+            key, value = part.split(":", 1)
+            values[key] = int(value)
+    return parts[0], values
+
+
+def to_ms(run):
+    scale = {"ns": 1e-6, "us": 1e-3, "ms": 1.0, "s": 1e3}[run.get("time_unit", "ns")]
+    return run["real_time"] * scale
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: accuracy_report.py <accuracy_bench.json>")
+    with open(sys.argv[1]) as f:
+        data = json.load(f)
+
+    tables = {}
+    for run in data.get("benchmarks", []):
+        if run.get("run_type") == "aggregate":
+            continue
+        family, args = parse_args(run.get("run_name", run["name"]))
+        swept = "depth" if "depth" in args else "cutoff"
+        key = (family, swept, args["n"], run.get("label", ""))
+        tables.setdefault(key, []).append((args[swept], run))
+
+    print("# Strassen accuracy versus speed\n")
+    print("Errors are measured against a compensated (Dot2) reference product of the same inputs. "
+          "`err_norm` = ||C - Cref||_F / (||A||_F ||B||_F); "
+          "`err_comp` = max |C - Cref| / (|A||B|), elementwise.\n")
+    for (family, swept, n, label), rows in sorted(tables.items()):
+        print("## %s, n = %d, %s\n" % (family[3:], n, label))
+        print("| %s | Time | GFLOPS | err_norm | err_comp |" % swept.capitalize())
+        print("| :--- | ---: | ---: | ---: | ---: |")
+        for value, run in sorted(rows, key=lambda r: r[0]):
+            print("| %d | %.3g ms | %.2f | %.2e | %.2e |" % (
+                value, to_ms(run), run.get("GFLOPS", 0.0),
+                run.get("err_norm", float("nan")), run.get("err_comp", float("nan"))))
+        print()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,262 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include "Matrix.hpp"
+#include "Product.hpp"
+#include "Random.hpp"
+
+/**
+ * Accuracy-versus-speed suite for Strassen's algorithm.
+ *
+ * Each run multiplies two n x n matrices and reports, besides the time:
+ *   err_norm  normwise error  ||C - Cref||_F / (||A||_F ||B||_F)
+ *   err_comp  componentwise error  max_ij |C - Cref|_ij / (|A| |B|)_ij
+ * Cref is computed from the same (possibly float-rounded) inputs with compensated dot
+ * products (Ogita-Rump-Oishi Dot2: TwoSum + FMA-based TwoProduct), which is accurate to
+ * about twice double precision on every platform, including those where long double is
+ * just double.
+ *
+ * Swept parameters: recursion depth (with a small cutoff so depth is binding), cutoff
+ * (with unlimited depth), input distribution and precision mode. Turn the JSON output into
+ * markdown tables with accuracy_report.py.
+ */
+
+namespace {
+
+    enum Distribution { Uniform01, UniformSigned, Normal, Graded, DistributionCount };
+    enum Precision { FP64, FP32, FP32StorageFP64Compute, PrecisionCount };
+
+    const char *distributionName(int d)
+    {
+        static const char *names[] = {"uniform[0,1]", "uniform[-1,1]", "normal", "graded"};
+        return names[d];
+    }
+
+    const char *precisionName(int p)
+    {
+        static const char *names[] = {"fp64", "fp32", "fp32-storage/fp64-compute"};
+        return names[p];
+    }
+
+    /**
+     * @brief Test matrices. "graded" scales row i of A and column j of B by 2^(+-e) with
+     * e up to 20, the badly scaled case where Strassen is known to lose componentwise
+     * accuracy while the classical algorithm does not.
+     */
+    Matrix<double> generate(int n, int distribution, unsigned seed, bool scaleRows)
+    {
+        switch (distribution)
+        {
+        case Uniform01: return rng::uniform<double>(n, n, seed);
+        case UniformSigned: return rng::uniform<double>(n, n, seed, -1.0, 1.0);
+        case Normal: return rng::normal<double>(n, n, seed);
+        default:
+        {
+            Matrix<double> M = rng::uniform<double>(n, n, seed, -1.0, 1.0);
+            for (int i = 0; i < n; ++i)
+            {
+                for (int j = 0; j < n; ++j)
+                {
+                    int index = scaleRows ? i : j;
+                    double exponent = 20.0 * (2.0 * index / std::max(1, n - 1) - 1.0);
+                    M(i, j) *= std::ldexp(1.0, static_cast<int>(exponent));
+                }
+            }
+            return M;
+        }
+        }
+    }
+
+    Matrix<double> roundToFloat(const Matrix<double> &M)
+    {
+        Matrix<double> R(M.getRows(), M.getCols());
+        for (int i = 0; i < M.getRows(); ++i)
+            for (int j = 0; j < M.getCols(); ++j)
+                R(i, j) = static_cast<float>(M(i, j));
+        return R;
+    }
+
+    template <typename To, typename From>
+    Matrix<To> convert(const Matrix<From> &M)
+    {
+        Matrix<To> R(M.getRows(), M.getCols());
+        for (int i = 0; i < M.getRows(); ++i)
+            for (int j = 0; j < M.getCols(); ++j)
+                R(i, j) = static_cast<To>(M(i, j));
+        return R;
+    }
+
+    /**
+     * @brief Reference product with Dot2 compensated dot products.
+     */
+    Matrix<double> referenceProduct(const Matrix<double> &A, const Matrix<double> &B)
+    {
+        int n = A.getRows(), m = A.getCols(), p = B.getCols();
+        Matrix<double> Bt = B.transpose();
+        Matrix<double> C(n, p);
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < p; ++j)
+            {
+                double sum = 0.0, compensation = 0.0;
+                for (int k = 0; k < m; ++k)
+                {
+                    double product = A(i, k) * Bt(j, k);
+                    double productError = std::fma(A(i, k), Bt(j, k), -product);
+                    double t = sum + product;
+                    double z = t - sum;
+                    double sumError = (sum - (t - z)) + (product - z);
+                    sum = t;
+                    compensation += sumError + productError;
+                }
+                C(i, j) = sum + compensation;
+            }
+        }
+        return C;
+    }
+
+    struct Problem
+    {
+        Matrix<double> A, B;   // inputs exactly as seen by the kernel
+        Matrix<double> C;      // reference product of those inputs
+        Matrix<double> absAB;  // |A| |B| for componentwise errors
+        double normA, normB;
+    };
+
+    double frobenius(const Matrix<double> &M)
+    {
+        double s = 0.0;
+        for (int i = 0; i < M.getRows(); ++i)
+            for (int j = 0; j < M.getCols(); ++j)
+                s += M(i, j) * M(i, j);
+        return std::sqrt(s);
+    }
+
+    const Problem &problem(int n, int distribution, bool floatInputs)
+    {
+        static std::map<std::tuple<int, int, bool>, Problem> cache;
+        auto key = std::make_tuple(n, distribution, floatInputs);
+        auto it = cache.find(key);
+        if (it != cache.end())
+            return it->second;
+
+        Problem p;
+        p.A = generate(n, distribution, 1000u + n, true);
+        p.B = generate(n, distribution, 2000u + n, false);
+        if (floatInputs)
+        {
+            p.A = roundToFloat(p.A);
+            p.B = roundToFloat(p.B);
+        }
+        p.C = referenceProduct(p.A, p.B);
+        Matrix<double> absA(n, n), absB(n, n);
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j)
+            {
+                absA(i, j) = std::abs(p.A(i, j));
+                absB(i, j) = std::abs(p.B(i, j));
+            }
+        p.absAB = matrixMultiply(absA, absB);
+        p.normA = frobenius(p.A);
+        p.normB = frobenius(p.B);
+        return cache.emplace(key, std::move(p)).first->second;
+    }
+
+    void reportErrors(benchmark::State &state, const Problem &p, const Matrix<double> &C)
+    {
+        double diff = 0.0, componentwise = 0.0;
+        for (int i = 0; i < C.getRows(); ++i)
+        {
+            for (int j = 0; j < C.getCols(); ++j)
+            {
+                double e = std::abs(C(i, j) - p.C(i, j));
+                diff += e * e;
+                if (p.absAB(i, j) > 0)
+                    componentwise = std::max(componentwise, e / p.absAB(i, j));
+            }
+        }
+        state.counters["err_norm"] = std::sqrt(diff) / (p.normA * p.normB);
+        state.counters["err_comp"] = componentwise;
+    }
+
+    /**
+     * @brief Times one configuration and attaches its forward errors.
+     */
+    void runAccuracy(benchmark::State &state, int n, int cutoff, int depth, int distribution, int precision)
+    {
+        const Problem &p = problem(n, distribution, precision != FP64);
+        Matrix<double> result;
+
+        if (precision == FP32)
+        {
+            Matrix<float> A = convert<float>(p.A), B = convert<float>(p.B);
+            Matrix<float> C;
+            for (auto _ : state)
+            {
+                C = strassenMultiply(A, B, cutoff, depth);
+                benchmark::DoNotOptimize(C);
+            }
+            result = convert<double>(C);
+        }
+        else
+        {
+            Matrix<double> C;
+            for (auto _ : state)
+            {
+                C = strassenMultiply(p.A, p.B, cutoff, depth);
+                benchmark::DoNotOptimize(C);
+            }
+            // Mixed mode stores the result in float as well.
+            result = precision == FP32StorageFP64Compute ? roundToFloat(C) : C;
+        }
+
+        reportErrors(state, p, result);
+        state.counters["GFLOPS"] = benchmark::Counter(2.0 * n * n * n * 1e-9, benchmark::Counter::kIsIterationInvariantRate);
+        state.SetLabel(std::string(distributionName(distribution)) + " " + precisionName(precision));
+    }
+
+} // namespace
+
+/**
+ * @brief Error and time versus recursion depth (depth 0 is the classical product).
+ */
+static void BM_AccuracyDepth(benchmark::State &state)
+{
+    runAccuracy(state, state.range(0), 8, state.range(1), state.range(2), state.range(3));
+}
+
+/**
+ * @brief Error and time versus cutoff with unlimited depth.
+ */
+static void BM_AccuracyCutoff(benchmark::State &state)
+{
+    runAccuracy(state, state.range(0), state.range(1), -1, state.range(2), state.range(3));
+}
+
+static void DepthArgs(benchmark::internal::Benchmark *b)
+{
+    for (int n : {256, 512})
+        for (int d = 0; d < DistributionCount; ++d)
+            for (int p = 0; p < PrecisionCount; ++p)
+                for (int depth = 0; depth <= 5; ++depth)
+                    b->Args({n, depth, d, p});
+    b->ArgNames({"n", "depth", "dist", "precision"})->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+static void CutoffArgs(benchmark::internal::Benchmark *b)
+{
+    for (int n : {256, 512})
+        for (int d = 0; d < DistributionCount; ++d)
+            for (int p = 0; p < PrecisionCount; ++p)
+                for (int cutoff : {16, 32, 64, 128, 256})
+                    b->Args({n, cutoff, d, p});
+    b->ArgNames({"n", "cutoff", "dist", "precision"})->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+BENCHMARK(BM_AccuracyDepth)->Apply(DepthArgs);
+BENCHMARK(BM_AccuracyCutoff)->Apply(CutoffArgs);
+
+BENCHMARK_MAIN();
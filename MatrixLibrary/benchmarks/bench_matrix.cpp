@@ -1,28 +1,22 @@
 #include <benchmark/benchmark.h>
 #include <vector>
-#include <random>
 
 #include "Matrix.hpp"
 #include "LinearSolver.hpp"
 #include "Product.hpp"
+#include "Random.hpp"
+#include "Semiring.hpp"
 
 /**
- * @brief Benchmark for Classical Matrix Multiplication (ikj).
+ * @brief Benchmark for Classical Matrix Multiplication (cache-blocked GEMM).
  * We call matrixMultiply directly to bypass the threshold logic in operator*.
  */
 static void BM_ClassicalProduct(benchmark::State &state)
 {
     int n = state.range(0);
 
-    Matrix<double> A(n, n), B(n, n);
-    for (int i = 0; i < n; ++i)
-    {
-        for (int j = 0; j < n; ++j)
-        {
-            A(i, j) = (double)rand() / RAND_MAX;
-            B(i, j) = (double)rand() / RAND_MAX;
-        }
-    }
+    Matrix<double> A = rng::uniform<double>(n, n, 1);
+    Matrix<double> B = rng::uniform<double>(n, n, 2);
 
     for (auto _ : state)
     {
@@ -39,15 +33,8 @@ static void BM_StrassenProduct(benchmark::State &state)
 {
     int n = state.range(0);
 
-    Matrix<double> A(n, n), B(n, n);
-    for (int i = 0; i < n; ++i)
-    {
-        for (int j = 0; j < n; ++j)
-        {
-            A(i, j) = (double)rand() / RAND_MAX;
-            B(i, j) = (double)rand() / RAND_MAX;
-        }
-    }
+    Matrix<double> A = rng::uniform<double>(n, n, 1);
+    Matrix<double> B = rng::uniform<double>(n, n, 2);
 
     for (auto _ : state)
     {
@@ -64,17 +51,10 @@ static void BM_LUSolver(benchmark::State &state)
 {
     int n = state.range(0);
 
-    Matrix<double> A(n, n);
-    std::vector<double> b(n);
-    for (int i = 0; i < n; ++i)
-    {
-        for (int j = 0; j < n; ++j)
-        {
-            A(i, j) = 1.0 + (double)rand() / RAND_MAX;
-        }
-        b[i] = 1.0 + (double)rand() / RAND_MAX;
-        A(i, i) += n; // Diagonally dominant to ensure it's not singular
-    }
+    // Diagonally dominant to ensure it's not singular
+    Matrix<double> A = rng::diagonallyDominant<double>(n, 3);
+    Matrix<double> rhs = rng::uniform<double>(n, 1, 4, 1.0, 2.0);
+    std::vector<double> b(rhs.data(), rhs.data() + n);
 
     for (auto _ : state)
     {
@@ -84,9 +64,29 @@ static void BM_LUSolver(benchmark::State &state)
     }
 }
 
+/**
+ * @brief Benchmark for the tropical (min, +) product, one squaring step of all-pairs
+ * shortest paths, on the blocked semiring GEMM.
+ */
+static void BM_MinPlusProduct(benchmark::State &state)
+{
+    int n = state.range(0);
+
+    Matrix<double> A = rng::uniform<double>(n, n, 1);
+    Matrix<double> B = rng::uniform<double>(n, n, 2);
+
+    for (auto _ : state)
+    {
+        Matrix<double> C = semiring::multiply<semiring::MinPlus<double>>(A, B);
+        benchmark::DoNotOptimize(C);
+    }
+}
+
+
 
 BENCHMARK(BM_ClassicalProduct)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_StrassenProduct)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond);
 BENCHMARK(BM_LUSolver)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MinPlusProduct)->RangeMultiplier(2)->Range(64, 2048)->Unit(benchmark::kMillisecond);
 
 BENCHMARK_MAIN();
\ No newline at end of file
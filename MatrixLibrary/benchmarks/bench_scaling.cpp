@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "LinearSolver.hpp"
+#include "Product.hpp"
+#include "Parallel.hpp"
+#include "Random.hpp"
+
+/**
+ * Thread-scaling suite for the parallel kernels.
+ *
+ * Every benchmark takes (n, threads, affinity) arguments and sweeps threads over
+ * 1, 2, 4, ... up to all cores for each pinning policy. Besides the usual timings, each run
+ * reports the counters
+ *   speedup    = time(1 thread) / time(threads)
+ *   efficiency = speedup / threads
+ * relative to the single-thread, unpinned run of the same kernel and size, which is
+ * registered first. Use run_scaling.sh to repeat the sweep under numactl placements.
+ */
+
+namespace {
+
+    void configurePool(int threads, parallel::Affinity affinity)
+    {
+        static int currentThreads = -1;
+        static parallel::Affinity currentAffinity = parallel::Affinity::None;
+        if (threads != currentThreads || affinity != currentAffinity)
+        {
+            parallel::configure(threads, affinity);
+            currentThreads = threads;
+            currentAffinity = affinity;
+        }
+    }
+
+    /**
+     * @brief Times `op` for the benchmark's (n, threads, affinity) and reports scaling.
+     */
+    template <typename Setup, typename Op>
+    void runScaling(benchmark::State &state, const char *kernel, Setup setup, Op op)
+    {
+        int n = state.range(0);
+        int threads = state.range(1);
+        auto affinity = static_cast<parallel::Affinity>(state.range(2));
+
+        auto input = setup(n);
+        configurePool(threads, affinity);
+
+        double seconds = 0.0;
+        for (auto _ : state)
+        {
+            auto start = std::chrono::steady_clock::now();
+            auto result = op(input);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            benchmark::DoNotOptimize(result);
+        }
+        double perIteration = seconds / state.iterations();
+
+        static std::map<std::string, double> singleThread;
+        std::string key = std::string(kernel) + "/" + std::to_string(n);
+        if (threads == 1 && affinity == parallel::Affinity::None)
+        {
+            singleThread[key] = perIteration;
+        }
+        if (singleThread.count(key))
+        {
+            double speedup = singleThread[key] / perIteration;
+            state.counters["speedup"] = speedup;
+            state.counters["efficiency"] = speedup / threads;
+        }
+        state.counters["threads"] = threads;
+        state.SetLabel(parallel::affinityName(affinity));
+    }
+
+    struct GemmInput { Matrix<double> A, B; };
+
+    GemmInput gemmInput(int n) { return {rng::uniform<double>(n, n, 1), rng::uniform<double>(n, n, 2)}; }
+
+} // namespace
+
+static void BM_ScalingGemm(benchmark::State &state)
+{
+    runScaling(state, "gemm", gemmInput,
+               [](const GemmInput &in) { return matrixMultiply(in.A, in.B); });
+}
+
+static void BM_ScalingStrassen(benchmark::State &state)
+{
+    runScaling(state, "strassen", gemmInput,
+               [](const GemmInput &in) { return strassenMultiply(in.A, in.B); });
+}
+
+static void BM_ScalingLU(benchmark::State &state)
+{
+    runScaling(state, "lu", [](int n) { return rng::diagonallyDominant<double>(n, 3); },
+               [](const Matrix<double> &A) { return decomposeLU(A); });
+}
+
+static void BM_ScalingElementwise(benchmark::State &state)
+{
+    runScaling(state, "elementwise", gemmInput,
+               [](const GemmInput &in) { return in.A + in.B; });
+}
+
+static void BM_ScalingParse(benchmark::State &state)
+{
+    runScaling(state, "parse",
+               [](int n) {
+                   std::string path = (std::filesystem::temp_directory_path() /
+                                       ("linearcpp_scaling_" + std::to_string(n) + ".txt")).string();
+                   Matrix<double> A = rng::uniform<double>(n, n, 1);
+                   std::ofstream file(path);
+                   file << n << " " << n << "\n" << std::setprecision(17);
+                   for (int i = 0; i < n; ++i)
+                   {
+                       for (int j = 0; j < n; ++j)
+                       {
+                           file << A(i, j) << " ";
+                       }
+                       file << "\n";
+                   }
+                   return path;
+               },
+               [](const std::string &path) { return Matrix<double>::fromFile(path); });
+}
+
+/**
+ * @brief Registers (n, threads, affinity) for threads = 1, 2, 4, ... and all cores.
+ */
+static void ScalingArgs(benchmark::internal::Benchmark *b, std::vector<int> sizes)
+{
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> threadCounts;
+    for (int t = 1; t < cores; t *= 2)
+    {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(cores);
+
+    for (int n : sizes)
+    {
+        for (auto affinity : {parallel::Affinity::None, parallel::Affinity::Compact, parallel::Affinity::Scatter})
+        {
+            for (int t : threadCounts)
+            {
+                if (t == 1 && affinity != parallel::Affinity::None)
+                    continue; // pinning does not affect the single-thread run
+                b->Args({n, t, static_cast<int>(affinity)});
+            }
+        }
+    }
+    b->ArgNames({"n", "threads", "affinity"})->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+BENCHMARK(BM_ScalingGemm)->Apply([](auto *b) { ScalingArgs(b, {512, 1024}); });
+BENCHMARK(BM_ScalingStrassen)->Apply([](auto *b) { ScalingArgs(b, {512, 1024}); });
+BENCHMARK(BM_ScalingLU)->Apply([](auto *b) { ScalingArgs(b, {512, 1024}); });
+BENCHMARK(BM_ScalingElementwise)->Apply([](auto *b) { ScalingArgs(b, {2048, 4096}); });
+BENCHMARK(BM_ScalingParse)->Apply([](auto *b) { ScalingArgs(b, {1024, 2048}); });
+
+BENCHMARK_MAIN();
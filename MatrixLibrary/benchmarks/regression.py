@@ -0,0 +1,340 @@
+#!/usr/bin/env python3
+"""Performance regression harness for matrix_bench.
+
+Runs the Google Benchmark executable with repetitions, stores the JSON output as a
+baseline keyed by a host fingerprint, compares later runs against that baseline and
+renders the markdown tables of results.md.
+
+Typical use:
+    regression.py record --bench build/matrix_bench          # store baseline for this host
+    regression.py check  --bench build/matrix_bench          # exit 1 on regression
+    regression.py report --input run.json > results.md       # markdown tables
+
+A benchmark counts as regressed when its median time grows by more than --threshold
+percent AND the difference is statistically significant: the Mann-Whitney U test over
+the repetitions rejects equality at --alpha and the 95% confidence intervals of the two
+medians do not overlap. Only the Python standard library is required.
+"""
+
+import argparse
+import hashlib
+import json
+import math
+import os
+import platform
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_BASELINE_DIR = os.path.join(HERE, "baselines")
+
+
+# --- Running ----------------------------------------------------------------------------
+
+def run_benchmark(bench, repetitions, bench_filter, min_time):
+    """Runs matrix_bench and returns its parsed JSON output."""
+    with tempfile.NamedTemporaryFile(suffix=".json", delete=False) as tmp:
+        out_path = tmp.name
+    cmd = [
+        bench,
+        "--benchmark_format=console",
+        "--benchmark_out_format=json",
+        "--benchmark_out=" + out_path,
+        "--benchmark_repetitions=%d" % repetitions,
+        "--benchmark_enable_random_interleaving=true",
+    ]
+    if bench_filter:
+        cmd.append("--benchmark_filter=" + bench_filter)
+    if min_time:
+        cmd.append("--benchmark_min_time=%s" % min_time)
+    try:
+        subprocess.run(cmd, check=True, stdout=sys.stderr)
+        with open(out_path) as f:
+            return json.load(f)
+    finally:
+        os.unlink(out_path)
+
+
+def load_or_run(args):
+    if args.input:
+        with open(args.input) as f:
+            return json.load(f)
+    if not args.bench:
+        sys.exit("error: either --bench or --input is required")
+    return run_benchmark(args.bench, args.repetitions, args.filter, args.min_time)
+
+
+# --- Host fingerprint -------------------------------------------------------------------
+
+def cpu_model():
+    if os.path.exists("/proc/cpuinfo"):
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name") or line.startswith("Model"):
+                    return line.split(":", 1)[1].strip()
+    if platform.system() == "Darwin":
+        try:
+            return subprocess.check_output(
+                ["sysctl", "-n", "machdep.cpu.brand_string"], text=True).strip()
+        except (OSError, subprocess.CalledProcessError):
+            pass
+    return platform.processor() or platform.machine()
+
+
+def host_fingerprint(data):
+    """Stable identifier of the machine and build that produced a run.
+
+    Built from the CPU model, core count, cache hierarchy and library build type reported
+    in the benchmark context, so baselines from different hosts are never compared.
+    """
+    context = data.get("context", {})
+    caches = ",".join(
+        "L%d%s:%d" % (c.get("level", 0), c.get("type", "")[:1], c.get("size", 0))
+        for c in context.get("caches", []))
+    key = "|".join([
+        cpu_model(),
+        platform.machine(),
+        str(context.get("num_cpus", os.cpu_count())),
+        caches,
+        context.get("library_build_type", ""),
+    ])
+    slug = re.sub(r"[^a-z0-9]+", "-", cpu_model().lower()).strip("-")[:40]
+    return "%s-%s" % (slug or "host", hashlib.sha1(key.encode()).hexdigest()[:10])
+
+
+# --- Statistics -------------------------------------------------------------------------
+
+def collect(data):
+    """Groups per-repetition real times (in ms) by benchmark name."""
+    samples = {}
+    for b in data.get("benchmarks", []):
+        if b.get("run_type") == "aggregate":
+            continue
+        scale = {"ns": 1e-6, "us": 1e-3, "ms": 1.0, "s": 1e3}[b.get("time_unit", "ns")]
+        name = b.get("run_name", b["name"])
+        samples.setdefault(name, []).append(b["real_time"] * scale)
+    return samples
+
+
+def median(values):
+    s = sorted(values)
+    n = len(s)
+    return s[n // 2] if n % 2 else 0.5 * (s[n // 2 - 1] + s[n // 2])
+
+
+def median_ci(values, confidence=0.95):
+    """Distribution-free confidence interval of the median from order statistics."""
+    s = sorted(values)
+    n = len(s)
+    if n < 3:
+        return s[0], s[-1]
+    z = normal_quantile(0.5 + confidence / 2)
+    half = z * math.sqrt(n) / 2
+    lo = max(0, int(math.floor(n / 2 - half)))
+    hi = min(n - 1, int(math.ceil(n / 2 + half)) - 1)
+    return s[lo], s[hi]
+
+
+def normal_quantile(p):
+    # Bisection on erf; only called with a handful of fixed probabilities.
+    lo, hi = -10.0, 10.0
+    for _ in range(100):
+        mid = 0.5 * (lo + hi)
+        if 0.5 * (1 + math.erf(mid / math.sqrt(2))) < p:
+            lo = mid
+        else:
+            hi = mid
+    return 0.5 * (lo + hi)
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test (normal approximation, tie-corrected)."""
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    pooled = sorted([(v, 0) for v in a] + [(v, 1) for v in b])
+    ranks = [0.0] * len(pooled)
+    tie_term = 0.0
+    i = 0
+    while i < len(pooled):
+        j = i
+        while j + 1 < len(pooled) and pooled[j + 1][0] == pooled[i][0]:
+            j += 1
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        t = j - i + 1
+        tie_term += t ** 3 - t
+        i = j + 1
+    r1 = sum(r for r, (_, g) in zip(ranks, pooled) if g == 0)
+    u1 = r1 - n1 * (n1 + 1) / 2.0
+    mu = n1 * n2 / 2.0
+    n = n1 + n2
+    sigma = math.sqrt(n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1))))
+    if sigma == 0:
+        return 1.0
+    z = (abs(u1 - mu) - 0.5) / sigma
+    return max(0.0, min(1.0, 2 * (1 - 0.5 * (1 + math.erf(z / math.sqrt(2))))))
+
+
+# --- Commands ---------------------------------------------------------------------------
+
+def baseline_path(args, data):
+    return os.path.join(args.baseline_dir, host_fingerprint(data) + ".json")
+
+
+def cmd_record(args):
+    data = load_or_run(args)
+    path = baseline_path(args, data)
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    with open(path, "w") as f:
+        json.dump(data, f, indent=1)
+    print("Baseline stored in %s" % path)
+    return 0
+
+
+def cmd_check(args):
+    data = load_or_run(args)
+    path = args.baseline or baseline_path(args, data)
+    if not os.path.exists(path):
+        print("No baseline for this host (%s); run 'record' first." % path, file=sys.stderr)
+        return 2
+    with open(path) as f:
+        base = collect(json.load(f))
+    new = collect(data)
+
+    if args.save:
+        with open(args.save, "w") as f:
+            json.dump(data, f, indent=1)
+
+    print("| Benchmark | Baseline median (ms) | New median (ms) | 95% CI (ms) | Change | p-value | Status |")
+    print("| :--- | ---: | ---: | :---: | ---: | ---: | :--- |")
+    regressions = 0
+    for name in sorted(new):
+        if name not in base:
+            continue
+        b, n = base[name], new[name]
+        mb, mn = median(b), median(n)
+        blo, bhi = median_ci(b)
+        nlo, nhi = median_ci(n)
+        change = 100.0 * (mn - mb) / mb if mb > 0 else 0.0
+        p = mann_whitney_p(b, n)
+        significant = p < args.alpha and (nlo > bhi or nhi < blo)
+        if significant and change > args.threshold:
+            status = "REGRESSION"
+            regressions += 1
+        elif significant and change < -args.threshold:
+            status = "improved"
+        else:
+            status = "ok"
+        print("| %s | %.3f | %.3f | %.3f - %.3f | %+.1f%% | %.3f | %s |"
+              % (name, mb, mn, nlo, nhi, change, p, status))
+
+    missing = sorted(set(base) - set(new))
+    if missing and not args.filter:
+        print("\nNot run (present in baseline): " + ", ".join(missing))
+    if regressions:
+        print("\n%d benchmark(s) regressed by more than %.1f%%." % (regressions, args.threshold))
+        return 1
+    return 0
+
+
+def split_name(name):
+    """'BM_StrassenProduct/1024' -> ('StrassenProduct', 1024)."""
+    parts = name.split("/")
+    family = parts[0][3:] if parts[0].startswith("BM_") else parts[0]
+    size = int(parts[1]) if len(parts) > 1 and parts[1].isdigit() else None
+    return family, size
+
+
+def cmd_report(args):
+    data = load_or_run(args)
+    samples = collect(data)
+    context = data.get("context", {})
+
+    families = {}
+    for name, values in samples.items():
+        family, size = split_name(name)
+        families.setdefault(family, {})[size] = values
+
+    out = []
+    out.append("# Performance Analysis\n")
+    out.append("Generated by `benchmarks/regression.py report` on **%s** (%s CPUs, host fingerprint `%s`), "
+               "%d repetitions per benchmark. Times are medians of real time.\n"
+               % (cpu_model(), context.get("num_cpus", "?"), host_fingerprint(data),
+                  max((len(v) for v in samples.values()), default=0)))
+
+    classical = families.get("ClassicalProduct", {})
+    strassen = families.get("StrassenProduct", {})
+    shared = sorted(s for s in classical if s in strassen and s is not None)
+    if shared:
+        out.append("## Matrix Multiplication: Classical vs. Strassen\n")
+        out.append("| Dimensions | Classical (Median) | Strassen (Median) | Improvement |")
+        out.append("| :--- | :--- | :--- | :--- |")
+        for s in shared:
+            c, st = median(classical[s]), median(strassen[s])
+            out.append("| %d x %d | %s | %s | %+.0f%% |" % (s, s, fmt_ms(c), fmt_ms(st), 100.0 * (c - st) / c))
+        out.append("")
+
+    for family in sorted(families):
+        if family in ("ClassicalProduct", "StrassenProduct") and shared:
+            continue
+        out.append("## %s\n" % family)
+        out.append("| Dimensions | Median | 95% CI | Repetitions |")
+        out.append("| :--- | :--- | :--- | :--- |")
+        for size in sorted(families[family], key=lambda s: -1 if s is None else s):
+            values = families[family][size]
+            lo, hi = median_ci(values)
+            dims = "%d x %d" % (size, size) if size is not None else "-"
+            out.append("| %s | %s | %s - %s | %d |" % (dims, fmt_ms(median(values)), fmt_ms(lo), fmt_ms(hi), len(values)))
+        out.append("")
+
+    text = "\n".join(out)
+    if args.output:
+        with open(args.output, "w") as f:
+            f.write(text)
+    else:
+        print(text)
+    return 0
+
+
+def fmt_ms(ms):
+    return "%.3g ms" % ms if ms < 1000 else "%.0f ms" % ms
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="command", required=True)
+
+    def common(p):
+        p.add_argument("--bench", help="path to the matrix_bench executable")
+        p.add_argument("--input", help="use an existing benchmark JSON instead of running")
+        p.add_argument("--repetitions", type=int, default=10)
+        p.add_argument("--filter", help="benchmark regex passed to --benchmark_filter")
+        p.add_argument("--min-time", help="per-repetition minimum time, e.g. 0.2s")
+        p.add_argument("--baseline-dir", default=DEFAULT_BASELINE_DIR)
+
+    p = sub.add_parser("record", help="run and store the baseline for this host")
+    common(p)
+    p.set_defaults(func=cmd_record)
+
+    p = sub.add_parser("check", help="run and compare against the stored baseline")
+    common(p)
+    p.add_argument("--baseline", help="explicit baseline file (default: keyed by host fingerprint)")
+    p.add_argument("--threshold", type=float, default=5.0, help="allowed slowdown in percent")
+    p.add_argument("--alpha", type=float, default=0.01, help="significance level")
+    p.add_argument("--save", help="also write the new run's JSON to this file")
+    p.set_defaults(func=cmd_check)
+
+    p = sub.add_parser("report", help="render markdown tables in the style of results.md")
+    common(p)
+    p.add_argument("--output", help="markdown file to write (default: stdout)")
+    p.set_defaults(func=cmd_report)
+
+    args = parser.parse_args()
+    sys.exit(args.func(args))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,24 @@
+#!/usr/bin/env sh
+# Runs scaling_bench once per NUMA placement and stores one JSON file per placement.
+#
+#   run_scaling.sh <path/to/scaling_bench> [output_dir] [extra benchmark flags...]
+#
+# Placements (numactl is used when available, otherwise only "default" runs):
+#   default     no external binding; thread pinning comes from the affinity argument
+#   node0       CPUs and memory bound to NUMA node 0 (single-socket curve)
+#   interleave  all CPUs, pages interleaved across nodes (bandwidth-bound kernels)
+set -eu
+
+BENCH=${1:?usage: run_scaling.sh <scaling_bench> [output_dir] [flags...]}
+OUT=${2:-scaling_results}
+shift $(( $# >= 2 ? 2 : 1 ))
+mkdir -p "$OUT"
+
+"$BENCH" --benchmark_out="$OUT/default.json" --benchmark_out_format=json "$@"
+
+if command -v numactl >/dev/null 2>&1 && [ "$(numactl --hardware | awk '/available:/ {print $2}')" -gt 1 ]; then
+    numactl --cpunodebind=0 --membind=0 "$BENCH" --benchmark_out="$OUT/node0.json" --benchmark_out_format=json "$@"
+    numactl --interleave=all "$BENCH" --benchmark_out="$OUT/interleave.json" --benchmark_out_format=json "$@"
+else
+    echo "numactl not found or single NUMA node: skipping node0/interleave placements" >&2
+fi
@@ -13,7 +13,7 @@
  * 2. Strassen matrix multiplication.
  * 3. LU Decomposition with partial pivoting.
  * 4. Solving linear systems Ax = b.
- * 5. Numerical verification of the results.
+ * 5. Numerical verification of the results (backward error of the solution).
  */
 
 int main(int argc, char *argv[])
@@ -73,10 +73,7 @@ int main(int argc, char *argv[])
         // --- 5. Final Verification ---
         std::cout << "\n--- Verifying Result (A * x == b) ---" << std::endl;
 
-        Matrix<double> x_mat(x, true);
-        Matrix<double> b_mat(b, true);
-
-        check(matA, x_mat, b_mat);
+        checkSolution(matA, x, b);
     }
     catch (const std::exception &e)
     {
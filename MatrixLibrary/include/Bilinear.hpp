@@ -0,0 +1,663 @@
+#ifndef BILINEAR_HPP
+#define BILINEAR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "Trace.hpp"
+#include "Tuning.hpp"
+
+/**
+ * @brief Fast matrix multiplication from bilinear <m,k,n;r> schemes.
+ * * A scheme multiplies an (m x k)-block matrix by a (k x n)-block matrix with r block
+ * products instead of m*k*n. Product t multiplies sum_e u[t][e] A_e by sum_e v[t][e] B_e,
+ * and C block e receives w[t][e] times it. Schemes are plain coefficient tables; the code
+ * that forms the operand sums and scatters the products is generated from them at compile
+ * time (one fused loop per product, with zero coefficients dropped), and every table is
+ * checked against the Brent equations by a static_assert.
+ *
+ * The dispatcher picks a scheme per level and per shape, or the classical blocked GEMM,
+ * from a cost model over the multiplications and block additions, and recurses on the
+ * block products. Dimensions that do not divide evenly leave the last blocks partially
+ * filled; they are handled in place, with no padded copy of the operands.
+ */
+namespace bilinear {
+
+    /**
+     * @brief Coefficient table of an <M,K,N;R> scheme. Blocks are numbered row-major:
+     * A(i, p) is u[t][i * K + p], B(p, j) is v[t][p * N + j] and C(i, j) is w[t][i * N + j].
+     */
+    template <int M, int K, int N, int R>
+    struct Table {
+        static constexpr int m = M, k = K, n = N, rank = R;
+        int8_t u[R][M * K];
+        int8_t v[R][K * N];
+        int8_t w[R][M * N];
+    };
+
+    namespace detail {
+
+        /**
+         * @brief True if the table computes C = A B: for all blocks,
+         * sum_t u[t](i, p) v[t](q, j) w[t](x, y) = [p == q][i == x][j == y].
+         */
+        template <int M, int K, int N, int R>
+        constexpr bool satisfiesBrent(const Table<M, K, N, R>& t) {
+            for (int i = 0; i < M; ++i)
+                for (int p = 0; p < K; ++p)
+                    for (int q = 0; q < K; ++q)
+                        for (int j = 0; j < N; ++j)
+                            for (int x = 0; x < M; ++x)
+                                for (int y = 0; y < N; ++y) {
+                                    int sum = 0;
+                                    for (int r = 0; r < R; ++r) {
+                                        sum += t.u[r][i * K + p] * t.v[r][q * N + j] * t.w[r][x * N + y];
+                                    }
+                                    if (sum != ((p == q && i == x && j == y) ? 1 : 0)) return false;
+                                }
+            return true;
+        }
+
+        /**
+         * @brief The classical <M,K,N;MKN> scheme, one product per (i, p, j).
+         */
+        template <int M, int K, int N>
+        constexpr Table<M, K, N, M * K * N> classical() {
+            Table<M, K, N, M * K * N> t{};
+            for (int i = 0; i < M; ++i)
+                for (int p = 0; p < K; ++p)
+                    for (int j = 0; j < N; ++j) {
+                        const int r = (i * K + p) * N + j;
+                        t.u[r][i * K + p] = 1;
+                        t.v[r][p * N + j] = 1;
+                        t.w[r][i * N + j] = 1;
+                    }
+            return t;
+        }
+
+        /**
+         * @brief Two levels in one: the <M1 M2, K1 K2, N1 N2; R1 R2> tensor product, where
+         * `outer` splits into blocks and `inner` splits each of those again.
+         */
+        template <int M1, int K1, int N1, int R1, int M2, int K2, int N2, int R2>
+        constexpr Table<M1 * M2, K1 * K2, N1 * N2, R1 * R2> kron(const Table<M1, K1, N1, R1>& outer,
+                                                                  const Table<M2, K2, N2, R2>& inner) {
+            Table<M1 * M2, K1 * K2, N1 * N2, R1 * R2> t{};
+            auto index = [](int a1, int b1, int a2, int b2, int rows2, int cols1, int cols2) {
+                return (a1 * rows2 + a2) * (cols1 * cols2) + b1 * cols2 + b2;
+            };
+            for (int r1 = 0; r1 < R1; ++r1)
+                for (int r2 = 0; r2 < R2; ++r2) {
+                    const int r = r1 * R2 + r2;
+                    for (int i1 = 0; i1 < M1; ++i1)
+                        for (int i2 = 0; i2 < M2; ++i2)
+                            for (int p1 = 0; p1 < K1; ++p1)
+                                for (int p2 = 0; p2 < K2; ++p2)
+                                    t.u[r][index(i1, p1, i2, p2, M2, K1, K2)] =
+                                        outer.u[r1][i1 * K1 + p1] * inner.u[r2][i2 * K2 + p2];
+                    for (int p1 = 0; p1 < K1; ++p1)
+                        for (int p2 = 0; p2 < K2; ++p2)
+                            for (int j1 = 0; j1 < N1; ++j1)
+                                for (int j2 = 0; j2 < N2; ++j2)
+                                    t.v[r][index(p1, j1, p2, j2, K2, N1, N2)] =
+                                        outer.v[r1][p1 * N1 + j1] * inner.v[r2][p2 * N2 + j2];
+                    for (int i1 = 0; i1 < M1; ++i1)
+                        for (int i2 = 0; i2 < M2; ++i2)
+                            for (int j1 = 0; j1 < N1; ++j1)
+                                for (int j2 = 0; j2 < N2; ++j2)
+                                    t.w[r][index(i1, j1, i2, j2, M2, N1, N2)] =
+                                        outer.w[r1][i1 * N1 + j1] * inner.w[r2][i2 * N2 + j2];
+                }
+            return t;
+        }
+
+        /**
+         * @brief <M, K, N1 + N2; R1 + R2>: `left` computes the first N1 block columns of C and
+         * `right` the remaining N2.
+         */
+        template <int M, int K, int N1, int R1, int N2, int R2>
+        constexpr Table<M, K, N1 + N2, R1 + R2> concatColumns(const Table<M, K, N1, R1>& left,
+                                                               const Table<M, K, N2, R2>& right) {
+            constexpr int N = N1 + N2;
+            Table<M, K, N, R1 + R2> t{};
+            for (int r = 0; r < R1 + R2; ++r) {
+                const bool first = r < R1;
+                const int s = first ? r : r - R1;
+                const int offset = first ? 0 : N1;
+                const int width = first ? N1 : N2;
+                for (int e = 0; e < M * K; ++e) t.u[r][e] = first ? left.u[s][e] : right.u[s][e];
+                for (int p = 0; p < K; ++p)
+                    for (int j = 0; j < width; ++j)
+                        t.v[r][p * N + offset + j] = first ? left.v[s][p * N1 + j] : right.v[s][p * N2 + j];
+                for (int i = 0; i < M; ++i)
+                    for (int j = 0; j < width; ++j)
+                        t.w[r][i * N + offset + j] = first ? left.w[s][i * N1 + j] : right.w[s][i * N2 + j];
+            }
+            return t;
+        }
+
+        /**
+         * @brief <M, K1 + K2, N; R1 + R2>: the two schemes cover the first K1 and the last K2
+         * blocks of the shared dimension and both accumulate into C.
+         */
+        template <int M, int K1, int N, int R1, int K2, int R2>
+        constexpr Table<M, K1 + K2, N, R1 + R2> concatInner(const Table<M, K1, N, R1>& front,
+                                                             const Table<M, K2, N, R2>& back) {
+            constexpr int K = K1 + K2;
+            Table<M, K, N, R1 + R2> t{};
+            for (int r = 0; r < R1 + R2; ++r) {
+                const bool first = r < R1;
+                const int s = first ? r : r - R1;
+                const int offset = first ? 0 : K1;
+                const int depth = first ? K1 : K2;
+                for (int i = 0; i < M; ++i)
+                    for (int p = 0; p < depth; ++p)
+                        t.u[r][i * K + offset + p] = first ? front.u[s][i * K1 + p] : back.u[s][i * K2 + p];
+                for (int p = 0; p < depth; ++p)
+                    for (int j = 0; j < N; ++j)
+                        t.v[r][(offset + p) * N + j] = first ? front.v[s][p * N + j] : back.v[s][p * N + j];
+                for (int e = 0; e < M * N; ++e) t.w[r][e] = first ? front.w[s][e] : back.w[s][e];
+            }
+            return t;
+        }
+
+        /**
+         * @brief <N,K,M;R> from <M,K,N;R> through C^T = B^T A^T.
+         */
+        template <int M, int K, int N, int R>
+        constexpr Table<N, K, M, R> transpose(const Table<M, K, N, R>& s) {
+            Table<N, K, M, R> t{};
+            for (int r = 0; r < R; ++r) {
+                for (int i = 0; i < M; ++i)
+                    for (int p = 0; p < K; ++p) t.v[r][p * M + i] = s.u[r][i * K + p];
+                for (int p = 0; p < K; ++p)
+                    for (int j = 0; j < N; ++j) t.u[r][j * K + p] = s.v[r][p * N + j];
+                for (int i = 0; i < M; ++i)
+                    for (int j = 0; j < N; ++j) t.w[r][j * M + i] = s.w[r][i * N + j];
+            }
+            return t;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Strassen's <2,2,2;7>.
+     */
+    struct Strassen {
+        static constexpr const char* name = "strassen<2,2,2;7>";
+        static constexpr Table<2, 2, 2, 7> table = {
+            {{1, 0, 0, 1}, {0, 0, 1, 1}, {1, 0, 0, 0}, {0, 0, 0, 1}, {1, 1, 0, 0}, {-1, 0, 1, 0}, {0, 1, 0, -1}},
+            {{1, 0, 0, 1}, {1, 0, 0, 0}, {0, 1, 0, -1}, {-1, 0, 1, 0}, {0, 0, 0, 1}, {1, 1, 0, 0}, {0, 0, 1, 1}},
+            {{1, 0, 0, 1}, {0, 0, 1, -1}, {0, 1, 0, 1}, {1, 0, 1, 0}, {-1, 1, 0, 0}, {0, 0, 0, 1}, {1, 0, 0, 0}},
+        };
+    };
+
+    /**
+     * @brief Laderman's <3,3,3;23> (1976).
+     */
+    struct Laderman {
+        static constexpr const char* name = "laderman<3,3,3;23>";
+        static constexpr Table<3, 3, 3, 23> table = {
+            {
+                { 1,  1,  1, -1, -1,  0,  0, -1, -1}, { 1,  0,  0, -1,  0,  0,  0,  0,  0},
+                { 0,  0,  0,  0,  1,  0,  0,  0,  0}, {-1,  0,  0,  1,  1,  0,  0,  0,  0},
+                { 0,  0,  0,  1,  1,  0,  0,  0,  0}, { 1,  0,  0,  0,  0,  0,  0,  0,  0},
+                {-1,  0,  0,  0,  0,  0,  1,  1,  0}, {-1,  0,  0,  0,  0,  0,  1,  0,  0},
+                { 0,  0,  0,  0,  0,  0,  1,  1,  0}, { 1,  1,  1,  0, -1, -1, -1, -1,  0},
+                { 0,  0,  0,  0,  0,  0,  0,  1,  0}, { 0,  0, -1,  0,  0,  0,  0,  1,  1},
+                { 0,  0,  1,  0,  0,  0,  0,  0, -1}, { 0,  0,  1,  0,  0,  0,  0,  0,  0},
+                { 0,  0,  0,  0,  0,  0,  0,  1,  1}, { 0,  0, -1,  0,  1,  1,  0,  0,  0},
+                { 0,  0,  1,  0,  0, -1,  0,  0,  0}, { 0,  0,  0,  0,  1,  1,  0,  0,  0},
+                { 0,  1,  0,  0,  0,  0,  0,  0,  0}, { 0,  0,  0,  0,  0,  1,  0,  0,  0},
+                { 0,  0,  0,  1,  0,  0,  0,  0,  0}, { 0,  0,  0,  0,  0,  0,  1,  0,  0},
+                { 0,  0,  0,  0,  0,  0,  0,  0,  1},
+            },
+            {
+                { 0,  0,  0,  0,  1,  0,  0,  0,  0}, { 0, -1,  0,  0,  1,  0,  0,  0,  0},
+                {-1,  1,  0,  1, -1, -1, -1,  0,  1}, { 1, -1,  0,  0,  1,  0,  0,  0,  0},
+                {-1,  1,  0,  0,  0,  0,  0,  0,  0}, { 1,  0,  0,  0,  0,  0,  0,  0,  0},
+                { 1,  0, -1,  0,  0,  1,  0,  0,  0}, { 0,  0,  1,  0,  0, -1,  0,  0,  0},
+                {-1,  0,  1,  0,  0,  0,  0,  0,  0}, { 0,  0,  0,  0,  0,  1,  0,  0,  0},
+                {-1,  0,  1,  1, -1, -1, -1,  1,  0}, { 0,  0,  0,  0,  1,  0,  1, -1,  0},
+                { 0,  0,  0,  0,  1,  0,  0, -1,  0}, { 0,  0,  0,  0,  0,  0,  1,  0,  0},
+                { 0,  0,  0,  0,  0,  0, -1,  1,  0}, { 0,  0,  0,  0,  0,  1,  1,  0, -1},
+                { 0,  0,  0,  0,  0,  1,  0,  0, -1}, { 0,  0,  0,  0,  0,  0, -1,  0,  1},
+                { 0,  0,  0,  1,  0,  0,  0,  0,  0}, { 0,  0,  0,  0,  0,  0,  0,  1,  0},
+                { 0,  0,  1,  0,  0,  0,  0,  0,  0}, { 0,  1,  0,  0,  0,  0,  0,  0,  0},
+                { 0,  0,  0,  0,  0,  0,  0,  0,  1},
+            },
+            {
+                { 0,  1,  0,  0,  0,  0,  0,  0,  0}, { 0,  0,  0,  1,  1,  0,  0,  0,  0},
+                { 0,  0,  0,  1,  0,  0,  0,  0,  0}, { 0,  1,  0,  1,  1,  0,  0,  0,  0},
+                { 0,  1,  0,  0,  1,  0,  0,  0,  0}, { 1,  1,  1,  1,  1,  0,  1,  0,  1},
+                { 0,  0,  1,  0,  0,  0,  1,  0,  1}, { 0,  0,  0,  0,  0,  0,  1,  0,  1},
+                { 0,  0,  1,  0,  0,  0,  0,  0,  1}, { 0,  0,  1,  0,  0,  0,  0,  0,  0},
+                { 0,  0,  0,  0,  0,  0,  1,  0,  0}, { 0,  1,  0,  0,  0,  0,  1,  1,  0},
+                { 0,  0,  0,  0,  0,  0,  1,  1,  0}, { 1,  1,  1,  1,  0,  1,  1,  1,  0},
+                { 0,  1,  0,  0,  0,  0,  0,  1,  0}, { 0,  0,  1,  1,  0,  1,  0,  0,  0},
+                { 0,  0,  0,  1,  0,  1,  0,  0,  0}, { 0,  0,  1,  0,  0,  1,  0,  0,  0},
+                { 1,  0,  0,  0,  0,  0,  0,  0,  0}, { 0,  0,  0,  0,  1,  0,  0,  0,  0},
+                { 0,  0,  0,  0,  0,  1,  0,  0,  0}, { 0,  0,  0,  0,  0,  0,  0,  1,  0},
+                { 0,  0,  0,  0,  0,  0,  0,  0,  1},
+            },
+        };
+    };
+
+    /**
+     * @brief <4,4,4;49>: two Strassen levels fused into one table, so each of the 49 products
+     * forms its operands from the 16 blocks in a single pass.
+     */
+    struct StrassenSquared {
+        static constexpr const char* name = "strassen^2<4,4,4;49>";
+        static constexpr auto table = detail::kron(Strassen::table, Strassen::table);
+    };
+
+    /**
+     * @brief <2,2,3;11>: Strassen on the first two block columns, classical on the third.
+     */
+    struct Strassen223 {
+        static constexpr const char* name = "strassen<2,2,3;11>";
+        static constexpr auto table = detail::concatColumns(Strassen::table, detail::classical<2, 2, 1>());
+    };
+
+    /**
+     * @brief <3,2,2;11>, the transpose of <2,2,3;11>.
+     */
+    struct Strassen322 {
+        static constexpr const char* name = "strassen<3,2,2;11>";
+        static constexpr auto table = detail::transpose(Strassen223::table);
+    };
+
+    /**
+     * @brief <2,3,2;11>: Strassen on the first two blocks of the shared dimension.
+     */
+    struct Strassen232 {
+        static constexpr const char* name = "strassen<2,3,2;11>";
+        static constexpr auto table = detail::concatInner(Strassen::table, detail::classical<2, 1, 2>());
+    };
+
+    static_assert(detail::satisfiesBrent(Strassen::table), "Invalid Strassen table.");
+    static_assert(detail::satisfiesBrent(Laderman::table), "Invalid Laderman table.");
+    static_assert(detail::satisfiesBrent(StrassenSquared::table), "Invalid <4,4,4;49> table.");
+    static_assert(detail::satisfiesBrent(Strassen223::table), "Invalid <2,2,3;11> table.");
+    static_assert(detail::satisfiesBrent(Strassen322::table), "Invalid <3,2,2;11> table.");
+    static_assert(detail::satisfiesBrent(Strassen232::table), "Invalid <2,3,2;11> table.");
+
+    /**
+     * @brief The schemes the dispatcher chooses from.
+     */
+    using Schemes = std::tuple<Strassen, Laderman, StrassenSquared, Strassen223, Strassen322, Strassen232>;
+
+    namespace detail {
+
+        /**
+         * @brief Cost of one element of a block addition, in units of one multiply-add of the
+         * blocked GEMM. Additions stream through memory while the GEMM runs from registers.
+         */
+        constexpr double additionCost = 4.0;
+
+        // Coefficient row t of u (Which = 0), v (1) or w (2) of scheme S, with its block grid.
+        template <typename S, int t, int Which>
+        struct Row {
+            static constexpr int rows = Which == 0 ? S::table.m : (Which == 1 ? S::table.k : S::table.m);
+            static constexpr int cols = Which == 0 ? S::table.k : S::table.n;
+            static constexpr int at(int e) {
+                if constexpr (Which == 0) return S::table.u[t][e];
+                else if constexpr (Which == 1) return S::table.v[t][e];
+                else return S::table.w[t][e];
+            }
+            static constexpr int count() {
+                int c = 0;
+                for (int e = 0; e < rows * cols; ++e) c += at(e) != 0;
+                return c;
+            }
+            // Block indices with nonzero coefficients.
+            static constexpr std::array<int, count()> terms() {
+                std::array<int, count()> result{};
+                int c = 0;
+                for (int e = 0; e < rows * cols; ++e) {
+                    if (at(e) != 0) result[c++] = e;
+                }
+                return result;
+            }
+        };
+
+        template <int C, typename T>
+        T scaled(const T& x) {
+            if constexpr (C == 1) return x;
+            else if constexpr (C == -1) return -x;
+            else return T(C) * x;
+        }
+
+        // out = sum of the coefficient-scaled full blocks, in one pass (the fold is generated
+        // from the table, so each product gets its own loop with only its terms).
+        template <typename Rw, typename T, size_t... I>
+        void fusedSum(std::index_sequence<I...>, const T* const* blocks, int ld, int rows, int cols, T* out) {
+            static constexpr auto terms = Rw::terms();
+            for (int i = 0; i < rows; ++i) {
+                for (int j = 0; j < cols; ++j) {
+                    out[size_t(i) * cols + j] = (scaled<Rw::at(terms[I])>(blocks[I][size_t(i) * ld + j]) + ...);
+                }
+            }
+        }
+
+        /**
+         * @brief A block-level view: data with leading dimension and the extent that is
+         * actually inside the matrix (the rest of the block is zero).
+         */
+        template <typename T>
+        struct Grid {
+            const T* data;
+            int ld;
+            int rows, cols;          // of the whole operand
+            int blockRows, blockCols;
+
+            const T* block(int bi, int bj) const { return data + size_t(bi) * blockRows * ld + size_t(bj) * blockCols; }
+            int rowsIn(int bi) const { return std::max(0, std::min(blockRows, rows - bi * blockRows)); }
+            int colsIn(int bj) const { return std::max(0, std::min(blockCols, cols - bj * blockCols)); }
+        };
+
+        template <typename T>
+        struct Operand {
+            const T* data;
+            int ld;
+            T scale;
+        };
+
+        /**
+         * @brief The operand sum of row Rw over the blocks of g: a view of the block itself when
+         * it is a single full block, otherwise the sum formed into `buffer`.
+         */
+        template <typename Rw, typename T>
+        Operand<T> formOperand(const Grid<T>& g, std::vector<T>& buffer) {
+            static constexpr auto terms = Rw::terms();
+            const int br = g.blockRows, bc = g.blockCols;
+            bool full = true;
+            for (int e : terms) {
+                full = full && g.rowsIn(e / Rw::cols) == br && g.colsIn(e % Rw::cols) == bc;
+            }
+            if constexpr (terms.size() == 1) {
+                if (full && (Rw::at(terms[0]) == 1 || Rw::at(terms[0]) == -1)) {
+                    return {g.block(terms[0] / Rw::cols, terms[0] % Rw::cols), g.ld, T(Rw::at(terms[0]))};
+                }
+            }
+            buffer.resize(size_t(br) * bc);
+            if (full) {
+                const T* blocks[terms.size()];
+                for (size_t s = 0; s < terms.size(); ++s) {
+                    blocks[s] = g.block(terms[s] / Rw::cols, terms[s] % Rw::cols);
+                }
+                fusedSum<Rw>(std::make_index_sequence<terms.size()>(), blocks, g.ld, br, bc, buffer.data());
+            } else {
+                std::fill(buffer.begin(), buffer.end(), T(0));
+                for (int e : terms) {
+                    const int bi = e / Rw::cols, bj = e % Rw::cols;
+                    const T* block = g.block(bi, bj);
+                    const T c = T(Rw::at(e));
+                    for (int i = 0; i < g.rowsIn(bi); ++i) {
+                        for (int j = 0; j < g.colsIn(bj); ++j) {
+                            buffer[size_t(i) * bc + j] += c * block[size_t(i) * g.ld + j];
+                        }
+                    }
+                }
+            }
+            return {buffer.data(), bc, T(1)};
+        }
+
+        /**
+         * @brief Per-product operation counts of a scheme, for the cost model.
+         */
+        template <typename S, size_t... I>
+        constexpr std::array<std::array<int, 3>, S::table.rank> termCounts(std::index_sequence<I...>) {
+            return {{{Row<S, int(I), 0>::count(), Row<S, int(I), 1>::count(), Row<S, int(I), 2>::count()}...}};
+        }
+
+        /**
+         * @brief Choice of the dispatcher for one shape: a scheme index into Schemes, or -1 for
+         * the classical GEMM, with its estimated cost.
+         */
+        struct Choice {
+            double cost;
+            int scheme;
+        };
+
+        inline int ceilDiv(int a, int b) { return (a + b - 1) / b; }
+
+        /**
+         * @brief Memoized cost model: the cheapest way to run an m x k by k x n product.
+         * * Schemes are only considered while all blocks stay at least `minBlock` wide, and
+         * at most `maxDepth` levels deep (negative means unlimited).
+         */
+        class Planner {
+            private:
+                std::map<std::array<int, 4>, Choice> m_memo;
+                int m_minBlock;
+                int m_maxDepth;
+                int m_forced;
+
+                template <typename S>
+                double schemeCost(int m, int n, int k, int depth) {
+                    constexpr auto counts = termCounts<S>(std::make_index_sequence<S::table.rank>());
+                    const int bm = ceilDiv(m, S::table.m), bk = ceilDiv(k, S::table.k), bn = ceilDiv(n, S::table.n);
+                    if (std::min({bm, bk, bn}) < m_minBlock) return -1.0;
+                    const bool fullA = m % S::table.m == 0 && k % S::table.k == 0;
+                    const bool fullB = k % S::table.k == 0 && n % S::table.n == 0;
+                    const bool fullC = m % S::table.m == 0 && n % S::table.n == 0;
+                    double additions = 0.0;
+                    for (const auto& c : counts) {
+                        if (c[0] > 1 || !fullA) additions += double(c[0]) * bm * bk;
+                        if (c[1] > 1 || !fullB) additions += double(c[1]) * bk * bn;
+                        if (c[2] > 1 || !fullC) additions += double(c[2] + 1) * bm * bn;
+                    }
+                    return S::table.rank * best(bm, bn, bk, depth + 1).cost + additionCost * additions;
+                }
+
+                template <size_t... I>
+                void consider(std::index_sequence<I...>, int m, int n, int k, int depth, Choice& choice) {
+                    auto visit = [&](double cost, int index) {
+                        if (cost < 0.0) return;
+                        if (index == m_forced || (m_forced < 0 && cost < choice.cost)) choice = {cost, index};
+                    };
+                    (visit(schemeCost<std::tuple_element_t<I, Schemes>>(m, n, k, depth), int(I)), ...);
+                }
+
+            public:
+                /**
+                 * @param forced If non-negative, the scheme to use at every level it fits,
+                 * down to maxDepth.
+                 */
+                Planner(int minBlock, int maxDepth, int forced = -1)
+                    : m_minBlock(std::max(1, minBlock)), m_maxDepth(maxDepth), m_forced(forced) {}
+
+                Choice best(int m, int n, int k, int depth = 0) {
+                    auto key = std::array<int, 4>{m, n, k, depth};
+                    auto found = m_memo.find(key);
+                    if (found != m_memo.end()) return found->second;
+                    Choice choice{double(m) * n * k, -1};
+                    if (m_maxDepth < 0 || depth < m_maxDepth) {
+                        consider(std::make_index_sequence<std::tuple_size<Schemes>::value>(), m, n, k, depth, choice);
+                    }
+                    m_memo[key] = choice;
+                    return choice;
+                }
+        };
+
+        template <typename T>
+        void run(Planner& planner, int depth, int m, int n, int k, T alpha,
+                 const T* A, int lda, const T* B, int ldb, T* C, int ldc);
+
+        // Product t of scheme S: form both operands, multiply recursively, scatter into C.
+        template <typename S, int t, typename T>
+        void product(Planner& planner, int depth, const Grid<T>& a, const Grid<T>& b, T alpha, T* C, int ldc,
+                     int m, int n, std::vector<T> (&buffers)[3]) {
+            using Out = Row<S, t, 2>;
+            static constexpr auto outTerms = Out::terms();
+            const int bm = a.blockRows, bk = a.blockCols, bn = b.blockCols;
+            Operand<T> left = formOperand<Row<S, t, 0>>(a, buffers[0]);
+            Operand<T> right = formOperand<Row<S, t, 1>>(b, buffers[1]);
+            const T scale = alpha * left.scale * right.scale;
+            auto rowsIn = [&](int bi) { return std::max(0, std::min(bm, m - bi * bm)); };
+            auto colsIn = [&](int bj) { return std::max(0, std::min(bn, n - bj * bn)); };
+            if constexpr (outTerms.size() == 1) {
+                const int bi = outTerms[0] / Out::cols, bj = outTerms[0] % Out::cols;
+                if (rowsIn(bi) == bm && colsIn(bj) == bn) {
+                    run(planner, depth + 1, bm, bn, bk, scale * T(Out::at(outTerms[0])),
+                        left.data, left.ld, right.data, right.ld, C + size_t(bi) * bm * ldc + size_t(bj) * bn, ldc);
+                    return;
+                }
+            }
+            std::vector<T>& P = buffers[2];
+            P.assign(size_t(bm) * bn, T(0));
+            run(planner, depth + 1, bm, bn, bk, T(1), left.data, left.ld, right.data, right.ld, P.data(), bn);
+            for (int e : outTerms) {
+                const int bi = e / Out::cols, bj = e % Out::cols;
+                const T c = scale * T(Out::at(e));
+                T* target = C + size_t(bi) * bm * ldc + size_t(bj) * bn;
+                for (int i = 0; i < rowsIn(bi); ++i) {
+                    for (int j = 0; j < colsIn(bj); ++j) {
+                        target[size_t(i) * ldc + j] += c * P[size_t(i) * bn + j];
+                    }
+                }
+            }
+        }
+
+        template <typename S, typename T, size_t... I>
+        void applyScheme(std::index_sequence<I...>, Planner& planner, int depth, int m, int n, int k, T alpha,
+                         const T* A, int lda, const T* B, int ldb, T* C, int ldc) {
+            LINEARCPP_TRACE_SCOPE("bilinear", "kernel", m);
+            const int bm = ceilDiv(m, S::table.m), bk = ceilDiv(k, S::table.k), bn = ceilDiv(n, S::table.n);
+            const Grid<T> a{A, lda, m, k, bm, bk};
+            const Grid<T> b{B, ldb, k, n, bk, bn};
+            // Buffers for the left operand, the right operand and the product, reused by all
+            // products of this level.
+            std::vector<T> buffers[3];
+            (product<S, int(I)>(planner, depth, a, b, alpha, C, ldc, m, n, buffers), ...);
+        }
+
+        template <typename T, size_t... I>
+        void dispatch(std::index_sequence<I...>, int scheme, Planner& planner, int depth, int m, int n, int k,
+                      T alpha, const T* A, int lda, const T* B, int ldb, T* C, int ldc) {
+            ((scheme == int(I)
+                  ? applyScheme<std::tuple_element_t<I, Schemes>>(
+                        std::make_index_sequence<std::tuple_element_t<I, Schemes>::table.rank>(),
+                        planner, depth, m, n, k, alpha, A, lda, B, ldb, C, ldc)
+                  : void()), ...);
+        }
+
+        template <typename T>
+        void run(Planner& planner, int depth, int m, int n, int k, T alpha,
+                 const T* A, int lda, const T* B, int ldb, T* C, int ldc) {
+            if (m == 0 || n == 0 || k == 0) return;
+            Choice choice = planner.best(m, n, k, depth);
+            if (choice.scheme < 0) {
+                gemm::multiplyAdd(m, n, k, alpha, A, lda, B, ldb, C, ldc);
+                return;
+            }
+            dispatch(std::make_index_sequence<std::tuple_size<Schemes>::value>(), choice.scheme, planner, depth,
+                     m, n, k, alpha, A, lda, B, ldb, C, ldc);
+        }
+
+        template <size_t... I>
+        const char* schemeName(std::index_sequence<I...>, int scheme) {
+            const char* names[] = {std::tuple_element_t<I, Schemes>::name...};
+            return names[scheme];
+        }
+
+        template <typename S, size_t... I>
+        constexpr int indexOf(std::index_sequence<I...>) {
+            int index = -1;
+            ((std::is_same<S, std::tuple_element_t<I, Schemes>>::value ? (index = int(I)) : 0), ...);
+            return index;
+        }
+
+        // Block dimensions of an m x k by k x n product under scheme `scheme`.
+        template <size_t... I>
+        void shrink(std::index_sequence<I...>, int scheme, int& m, int& n, int& k) {
+            auto apply = [&](int gm, int gk, int gn) {
+                m = ceilDiv(m, gm);
+                k = ceilDiv(k, gk);
+                n = ceilDiv(n, gn);
+            };
+            ((scheme == int(I) ? apply(std::tuple_element_t<I, Schemes>::table.m,
+                                       std::tuple_element_t<I, Schemes>::table.k,
+                                       std::tuple_element_t<I, Schemes>::table.n) : void()), ...);
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Computes C += alpha * A * B for row-major operands, choosing a fast scheme and
+     * the recursion depth for the shape.
+     * @param maxDepth Maximum number of scheme levels; negative lets the cost model decide.
+     * @param minBlock Smallest block dimension a scheme may produce; 0 uses the Strassen
+     * cutoff of the host tuning profile.
+     */
+    template <typename T>
+    void multiplyAdd(int m, int n, int k, T alpha, const T* A, int lda, const T* B, int ldb, T* C, int ldc,
+                     int maxDepth = -1, int minBlock = 0) {
+        detail::Planner planner(minBlock > 0 ? minBlock : tuning::profile().strassenCutoff, maxDepth);
+        detail::run(planner, 0, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+    }
+
+    /**
+     * @brief A * B with the scheme and depth picked per shape by the dispatcher.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename T>
+    Matrix<T> multiply(const Matrix<T>& A, const Matrix<T>& B, int maxDepth = -1, int minBlock = 0) {
+        if (A.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        Matrix<T> C(A.getRows(), B.getCols());
+        multiplyAdd(A.getRows(), B.getCols(), A.getCols(), T(1), A.data(), A.getCols(),
+                    B.data(), B.getCols(), C.data(), C.getCols(), maxDepth, minBlock);
+        return C;
+    }
+
+    /**
+     * @brief A * B with scheme S at each of the first `levels` levels (where the blocks stay
+     * at least minBlock wide) and the classical GEMM below, bypassing the cost model.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename S, typename T>
+    Matrix<T> multiplyWith(const Matrix<T>& A, const Matrix<T>& B, int levels = 1, int minBlock = 1) {
+        if (A.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        constexpr int index = detail::indexOf<S>(std::make_index_sequence<std::tuple_size<Schemes>::value>());
+        static_assert(index >= 0, "The scheme must be listed in bilinear::Schemes.");
+        detail::Planner planner(minBlock, levels, index);
+        Matrix<T> C(A.getRows(), B.getCols());
+        detail::run(planner, 0, A.getRows(), B.getCols(), A.getCols(), T(1), A.data(), A.getCols(),
+                    B.data(), B.getCols(), C.data(), C.getCols());
+        return C;
+    }
+
+    /**
+     * @brief Describes the dispatcher's plan for an m x k by k x n product, one scheme per
+     * level, e.g. "laderman<3,3,3;23> > strassen<2,2,2;7> > gemm".
+     */
+    inline std::string describe(int m, int n, int k, int maxDepth = -1, int minBlock = 0) {
+        detail::Planner planner(minBlock > 0 ? minBlock : tuning::profile().strassenCutoff, maxDepth);
+        std::string plan;
+        for (int depth = 0;; ++depth) {
+            detail::Choice choice = planner.best(m, n, k, depth);
+            if (choice.scheme < 0) return plan + "gemm";
+            plan += detail::schemeName(std::make_index_sequence<std::tuple_size<Schemes>::value>(), choice.scheme);
+            plan += " > ";
+            detail::shrink(std::make_index_sequence<std::tuple_size<Schemes>::value>(), choice.scheme, m, n, k);
+        }
+    }
+
+} // namespace bilinear
+
+#endif // BILINEAR_HPP
@@ -0,0 +1,389 @@
+#ifndef BIT_MATRIX_HPP
+#define BIT_MATRIX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Matrix.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+
+namespace detail {
+
+    inline int popcount64(uint64_t x) {
+#if defined(__GNUC__)
+        return __builtin_popcountll(x);
+#else
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return static_cast<int>((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    inline int countTrailingZeros64(uint64_t x) {
+#if defined(__GNUC__)
+        return __builtin_ctzll(x);
+#else
+        return popcount64((x & (0 - x)) - 1);
+#endif
+    }
+
+} // namespace detail
+
+/**
+ * @brief Bit-packed boolean matrices and their products over (or, and) and GF(2).
+ * * Each row is stored as ceil(cols / 64) 64-bit words (bit j % 64 of word j / 64 holds
+ * column j), so a BitMatrix takes 1/64 of the memory of Matrix<uint8_t> and row operations
+ * process 64 entries per instruction. Bits past the last column are kept zero.
+ *
+ * Products use the "Method of Four Russians" (M4RM, Arlazarov et al. 1970; Albrecht, Bard
+ * and Hart 2010): for every group of 8 rows of B, a table of all 256 OR / XOR combinations
+ * of those rows is built once, and each row of C then takes one table lookup per group
+ * instead of up to 8 row operations. multiplyTransposed uses AND + popcount dot products
+ * against B^T instead, which suits few columns or a B^T that is already at hand.
+ */
+class BitMatrix {
+    private:
+        int m_rows;
+        int m_cols;
+        int m_words;
+        std::vector<uint64_t> m_data;
+
+        // Words of storage for rows x cols, validated before any member is built from it.
+        static size_t storageWords(int rows, int cols) {
+            if (rows < 0 || cols < 0) {
+                throw std::invalid_argument("Error: Invalid matrix dimensions.");
+            }
+            return size_t(rows) * ((cols + 63) / 64);
+        }
+    public:
+        /**
+         * @brief Constructs a rows x cols matrix of zeros.
+         * @throws std::invalid_argument If a dimension is negative.
+         */
+        BitMatrix(int rows, int cols)
+            : m_rows(rows), m_cols(cols), m_words((cols + 63) / 64), m_data(storageWords(rows, cols), 0) {}
+        BitMatrix() : BitMatrix(0, 0) {}
+
+        static BitMatrix identity(int n) {
+            BitMatrix I(n, n);
+            for (int i = 0; i < n; ++i) {
+                I.set(i, i, true);
+            }
+            return I;
+        }
+
+        /**
+         * @brief Packs a Matrix, mapping nonzero entries to 1.
+         */
+        template <typename T>
+        static BitMatrix fromMatrix(const Matrix<T>& M) {
+            BitMatrix B(M.getRows(), M.getCols());
+            for (int i = 0; i < M.getRows(); ++i) {
+                for (int j = 0; j < M.getCols(); ++j) {
+                    if (M(i, j) != T(0)) B.set(i, j, true);
+                }
+            }
+            return B;
+        }
+
+        /**
+         * @brief Unpacks into a Matrix of 0/1 entries.
+         */
+        template <typename T = uint8_t>
+        Matrix<T> toMatrix() const {
+            Matrix<T> M(m_rows, m_cols);
+            for (int i = 0; i < m_rows; ++i) {
+                for (int j = 0; j < m_cols; ++j) {
+                    M(i, j) = get(i, j) ? T(1) : T(0);
+                }
+            }
+            return M;
+        }
+
+        int getRows() const { return m_rows; }
+        int getCols() const { return m_cols; }
+
+        /**
+         * @brief Number of 64-bit words per row (the stride between consecutive row() pointers).
+         */
+        int wordsPerRow() const { return m_words; }
+
+        uint64_t* row(int i) { return m_data.data() + size_t(i) * m_words; }
+        const uint64_t* row(int i) const { return m_data.data() + size_t(i) * m_words; }
+
+        bool get(int i, int j) const {
+            return (row(i)[j >> 6] >> (j & 63)) & 1u;
+        }
+
+        void set(int i, int j, bool value) {
+            uint64_t mask = uint64_t(1) << (j & 63);
+            if (value) row(i)[j >> 6] |= mask;
+            else row(i)[j >> 6] &= ~mask;
+        }
+
+        void flip(int i, int j) {
+            row(i)[j >> 6] ^= uint64_t(1) << (j & 63);
+        }
+
+        void swapRows(int a, int b) {
+            std::swap_ranges(row(a), row(a) + m_words, row(b));
+        }
+
+        /**
+         * @brief Number of set entries.
+         */
+        long long count() const;
+
+        BitMatrix transpose() const {
+            BitMatrix T(m_cols, m_rows);
+            for (int i = 0; i < m_rows; ++i) {
+                const uint64_t* r = row(i);
+                for (int w = 0; w < m_words; ++w) {
+                    for (uint64_t bits = r[w]; bits; bits &= bits - 1) {
+                        T.set(w * 64 + detail::countTrailingZeros64(bits), i, true);
+                    }
+                }
+            }
+            return T;
+        }
+
+        bool operator==(const BitMatrix& other) const {
+            return m_rows == other.m_rows && m_cols == other.m_cols && m_data == other.m_data;
+        }
+
+        bool operator!=(const BitMatrix& other) const {
+            return !(*this == other);
+        }
+};
+
+/**
+ * @brief Semiring of a bit-packed product: (or, and) for reachability, (xor, and) for GF(2).
+ */
+enum class BitSemiring { OrAnd, GF2 };
+
+namespace detail {
+
+    /**
+     * @brief Reduces M in place to (reduced) row echelon form over GF(2), choosing pivots in
+     * the first `pivotCols` columns only.
+     * @return The pivot column of each of the first rank rows.
+     */
+    inline std::vector<int> eliminateGF2(BitMatrix& M, int pivotCols, bool reduced) {
+        const int rows = M.getRows(), words = M.wordsPerRow();
+        std::vector<int> pivots;
+        int r = 0;
+        for (int c = 0; c < pivotCols && r < rows; ++c) {
+            const int w = c >> 6;
+            const uint64_t bit = uint64_t(1) << (c & 63);
+            int pivot = r;
+            while (pivot < rows && !(M.row(pivot)[w] & bit)) ++pivot;
+            if (pivot == rows) continue;
+            if (pivot != r) M.swapRows(pivot, r);
+            const uint64_t* source = M.row(r);
+            // Words left of w are zero in the pivot row, so updates start at word w.
+            int grain = parallel::grainFor(words - w);
+            parallel::parallelFor(0, rows, grain, [&](int rowBegin, int rowEnd) {
+                for (int i = rowBegin; i < rowEnd; ++i) {
+                    if (i == r || (!reduced && i < r)) continue;
+                    uint64_t* target = M.row(i);
+                    if (target[w] & bit) {
+                        for (int x = w; x < words; ++x) target[x] ^= source[x];
+                    }
+                }
+            });
+            pivots.push_back(c);
+            ++r;
+        }
+        return pivots;
+    }
+
+} // namespace detail
+
+inline long long BitMatrix::count() const {
+    long long total = 0;
+    for (uint64_t word : m_data) total += detail::popcount64(word);
+    return total;
+}
+
+/**
+ * @brief Bit-packed product A B over the given semiring with the Four Russians method.
+ * * B is processed in groups of 8 rows: the 256 combinations of a group (restricted to a
+ * block of at most 64 words of B's columns, 128 KiB of table) are built incrementally, one
+ * row operation each, then every row of C takes the combination selected by the matching
+ * byte of its row of A. Rows of C are updated in parallel. O(m k n / 512) word operations
+ * plus O(k n / 16) for the tables.
+ * @param A The left-hand side matrix (m x k).
+ * @param B The right-hand side matrix (k x n).
+ * @throws std::invalid_argument If the dimensions do not agree.
+ */
+inline BitMatrix multiply(const BitMatrix& A, const BitMatrix& B, BitSemiring semiring) {
+    if (A.getCols() != B.getRows()) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+    }
+    LINEARCPP_TRACE_SCOPE("m4rm", "kernel", A.getRows());
+    const int m = A.getRows(), k = A.getCols(), words = B.wordsPerRow();
+    const bool gf2 = semiring == BitSemiring::GF2;
+    constexpr int groupBits = 8, blockWords = 64;
+    BitMatrix C(m, B.getCols());
+    std::vector<uint64_t> table(size_t(1 << groupBits) * std::min(words, blockWords));
+
+    for (int w0 = 0; w0 < words; w0 += blockWords) {
+        const int wb = std::min(blockWords, words - w0);
+        for (int g = 0; g < k; g += groupBits) {
+            const int bitsInGroup = std::min(groupBits, k - g);
+            // table[s] combines the rows g + b for the set bits b of s; each entry extends a
+            // previous one by its lowest set bit.
+            std::fill(table.begin(), table.begin() + wb, 0);
+            for (int s = 1; s < (1 << bitsInGroup); ++s) {
+                const int low = detail::countTrailingZeros64(uint64_t(s));
+                const uint64_t* previous = table.data() + size_t(s & (s - 1)) * wb;
+                const uint64_t* source = B.row(g + low) + w0;
+                uint64_t* entry = table.data() + size_t(s) * wb;
+                for (int x = 0; x < wb; ++x) {
+                    entry[x] = gf2 ? previous[x] ^ source[x] : previous[x] | source[x];
+                }
+            }
+            const int shift = g & 63;
+            int grain = parallel::grainFor(wb);
+            parallel::parallelFor(0, m, grain, [&](int rowBegin, int rowEnd) {
+                for (int i = rowBegin; i < rowEnd; ++i) {
+                    // Groups start at multiples of 8, so a group never straddles two words.
+                    const unsigned s = unsigned(A.row(i)[g >> 6] >> shift) & ((1u << bitsInGroup) - 1);
+                    if (s == 0) continue;
+                    const uint64_t* entry = table.data() + size_t(s) * wb;
+                    uint64_t* target = C.row(i) + w0;
+                    if (gf2) {
+                        for (int x = 0; x < wb; ++x) target[x] ^= entry[x];
+                    } else {
+                        for (int x = 0; x < wb; ++x) target[x] |= entry[x];
+                    }
+                }
+            });
+        }
+    }
+    return C;
+}
+
+/**
+ * @brief Bit-packed product A B given Bt = B^T, one AND + popcount dot product per entry.
+ * * Over (or, and) an entry is 1 if the rows share any bit; over GF(2) it is the parity of
+ * the shared bits, obtained from a single popcount of the XOR-accumulated words.
+ * @param A The left-hand side matrix (m x k).
+ * @param Bt The transposed right-hand side (n x k).
+ * @throws std::invalid_argument If the dimensions do not agree.
+ */
+inline BitMatrix multiplyTransposed(const BitMatrix& A, const BitMatrix& Bt, BitSemiring semiring) {
+    if (A.getCols() != Bt.getCols()) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+    }
+    LINEARCPP_TRACE_SCOPE("bit_dot", "kernel", A.getRows());
+    const int m = A.getRows(), n = Bt.getRows(), words = A.wordsPerRow();
+    BitMatrix C(m, n);
+    int grain = parallel::grainFor(2LL * n * words);
+    parallel::parallelFor(0, m, grain, [&](int rowBegin, int rowEnd) {
+        for (int i = rowBegin; i < rowEnd; ++i) {
+            const uint64_t* a = A.row(i);
+            for (int j = 0; j < n; ++j) {
+                const uint64_t* b = Bt.row(j);
+                uint64_t acc = 0;
+                if (semiring == BitSemiring::GF2) {
+                    for (int x = 0; x < words; ++x) acc ^= a[x] & b[x];
+                    acc = detail::popcount64(acc) & 1;
+                } else {
+                    for (int x = 0; x < words && !acc; ++x) acc = a[x] & b[x];
+                }
+                if (acc) C.set(i, j, true);
+            }
+        }
+    });
+    return C;
+}
+
+/**
+ * @brief Transitive closure of a directed graph given as an n x n adjacency matrix.
+ * * Warshall's algorithm on packed rows: after step k every row that reaches k absorbs
+ * row k with one word-wise OR, O(n^3 / 64). Entry (i, j) of the result is 1 if there is a
+ * path of length >= 1 from i to j; OR in BitMatrix::identity(n) for reflexive closure.
+ * @throws std::invalid_argument If the matrix is not square.
+ */
+inline BitMatrix transitiveClosure(const BitMatrix& A) {
+    if (A.getRows() != A.getCols()) {
+        throw std::invalid_argument("Error: Matrix must be square.");
+    }
+    LINEARCPP_TRACE_SCOPE("closure", "solver", A.getRows());
+    BitMatrix R = A;
+    const int n = R.getRows(), words = R.wordsPerRow();
+    int grain = parallel::grainFor(words);
+    for (int k = 0; k < n; ++k) {
+        const uint64_t* source = R.row(k);
+        const uint64_t bit = uint64_t(1) << (k & 63);
+        // Row k only absorbs itself, so the rows can be updated concurrently.
+        parallel::parallelFor(0, n, grain, [&](int rowBegin, int rowEnd) {
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                uint64_t* target = R.row(i);
+                if (i != k && (target[k >> 6] & bit)) {
+                    for (int x = 0; x < words; ++x) target[x] |= source[x];
+                }
+            }
+        });
+    }
+    return R;
+}
+
+/**
+ * @brief Brings M to reduced row echelon form over GF(2) in place.
+ * @return The rank of M.
+ */
+inline int eliminateGF2(BitMatrix& M) {
+    LINEARCPP_TRACE_SCOPE("eliminate_gf2", "solver", M.getRows());
+    return static_cast<int>(detail::eliminateGF2(M, M.getCols(), true).size());
+}
+
+/**
+ * @brief Rank of a bit matrix over GF(2), for any shape.
+ */
+inline int rank(const BitMatrix& A) {
+    BitMatrix M = A;
+    return static_cast<int>(detail::eliminateGF2(M, M.getCols(), false).size());
+}
+
+/**
+ * @brief Solves A X = B over GF(2) by Gauss-Jordan elimination of [A | B].
+ * @param A The square coefficient matrix (n x n).
+ * @param B The right-hand sides (n x m).
+ * @return The n x m solution X.
+ * @throws std::invalid_argument If the dimensions do not agree.
+ * @throws std::runtime_error If A is singular.
+ */
+inline BitMatrix solveGF2(const BitMatrix& A, const BitMatrix& B) {
+    const int n = A.getRows(), m = B.getCols();
+    if (A.getCols() != n || B.getRows() != n) {
+        throw std::invalid_argument("Error: Dimensions of A and B do not agree.");
+    }
+    LINEARCPP_TRACE_SCOPE("solve_gf2", "solver", n);
+    BitMatrix augmented(n, n + m);
+    for (int i = 0; i < n; ++i) {
+        std::copy(A.row(i), A.row(i) + A.wordsPerRow(), augmented.row(i));
+        for (int j = 0; j < m; ++j) {
+            if (B.get(i, j)) augmented.set(i, n + j, true);
+        }
+    }
+    std::vector<int> pivots = detail::eliminateGF2(augmented, n, true);
+    if (static_cast<int>(pivots.size()) < n) {
+        throw std::runtime_error("Error: Singular matrix. Null pivot at index " + std::to_string(pivots.size()));
+    }
+    BitMatrix X(n, m);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < m; ++j) {
+            if (augmented.get(i, n + j)) X.set(i, j, true);
+        }
+    }
+    return X;
+}
+
+#endif // BIT_MATRIX_HPP
@@ -0,0 +1,182 @@
+#ifndef BLAS_HPP
+#define BLAS_HPP
+
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Optional dispatch of GEMM, TRSM, GETRF and POTRF to an external BLAS/LAPACK.
+ * * Configure with -DLINEARCPP_ENABLE_BLAS=ON to link a system BLAS/LAPACK (OpenBLAS, BLIS,
+ * MKL, reference; chosen with BLA_VENDOR) or, with -DLINEARCPP_BLAS_PROVIDER=eigen, the
+ * vendored Eigen blas/ and lapack/ directories. Calls go through the Fortran interface
+ * (dgemm_, dgetrf_, ...), which every provider exports, including Eigen's, which has no
+ * CBLAS/LAPACKE layer. Row-major storage is passed as its column-major transpose.
+ *
+ * Only float and double are dispatched; other element types, builds without the option, and
+ * processes started with LINEARCPP_BACKEND=native use the native kernels. Integer arguments
+ * are 32-bit (LP64); define LINEARCPP_BLAS_INT as long long for ILP64 libraries.
+ */
+
+#ifndef LINEARCPP_BLAS_INT
+#define LINEARCPP_BLAS_INT int
+#endif
+
+#ifdef LINEARCPP_ENABLE_BLAS
+extern "C" {
+    void sgemm_(const char*, const char*, const LINEARCPP_BLAS_INT*, const LINEARCPP_BLAS_INT*,
+                const LINEARCPP_BLAS_INT*, const float*, const float*, const LINEARCPP_BLAS_INT*, const float*,
+                const LINEARCPP_BLAS_INT*, const float*, float*, const LINEARCPP_BLAS_INT*);
+    void dgemm_(const char*, const char*, const LINEARCPP_BLAS_INT*, const LINEARCPP_BLAS_INT*,
+                const LINEARCPP_BLAS_INT*, const double*, const double*, const LINEARCPP_BLAS_INT*, const double*,
+                const LINEARCPP_BLAS_INT*, const double*, double*, const LINEARCPP_BLAS_INT*);
+    void strsm_(const char*, const char*, const char*, const char*, const LINEARCPP_BLAS_INT*,
+                const LINEARCPP_BLAS_INT*, const float*, const float*, const LINEARCPP_BLAS_INT*, float*,
+                const LINEARCPP_BLAS_INT*);
+    void dtrsm_(const char*, const char*, const char*, const char*, const LINEARCPP_BLAS_INT*,
+                const LINEARCPP_BLAS_INT*, const double*, const double*, const LINEARCPP_BLAS_INT*, double*,
+                const LINEARCPP_BLAS_INT*);
+    void sgetrf_(const LINEARCPP_BLAS_INT*, const LINEARCPP_BLAS_INT*, float*, const LINEARCPP_BLAS_INT*,
+                 LINEARCPP_BLAS_INT*, LINEARCPP_BLAS_INT*);
+    void dgetrf_(const LINEARCPP_BLAS_INT*, const LINEARCPP_BLAS_INT*, double*, const LINEARCPP_BLAS_INT*,
+                 LINEARCPP_BLAS_INT*, LINEARCPP_BLAS_INT*);
+    void spotrf_(const char*, const LINEARCPP_BLAS_INT*, float*, const LINEARCPP_BLAS_INT*, LINEARCPP_BLAS_INT*);
+    void dpotrf_(const char*, const LINEARCPP_BLAS_INT*, double*, const LINEARCPP_BLAS_INT*, LINEARCPP_BLAS_INT*);
+}
+#endif
+
+namespace blas {
+
+    using Int = LINEARCPP_BLAS_INT;
+
+    namespace detail {
+
+        inline bool& enabledFlag() {
+            static bool flag = [] {
+                const char* backend = std::getenv("LINEARCPP_BACKEND");
+                return !(backend && std::strcmp(backend, "native") == 0);
+            }();
+            return flag;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief True if the library was built with an external BLAS/LAPACK.
+     */
+    constexpr bool compiled() {
+#ifdef LINEARCPP_ENABLE_BLAS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief True if calls on element type T are currently routed to BLAS/LAPACK.
+     */
+    template <typename T>
+    bool active() {
+        return compiled() && (std::is_same<T, float>::value || std::is_same<T, double>::value) &&
+               detail::enabledFlag();
+    }
+
+    /**
+     * @brief Switches dispatch on or off at run time (e.g. to compare backends). Must not be
+     * called while other threads run library operations.
+     */
+    inline void setEnabled(bool enabled) {
+        detail::enabledFlag() = enabled;
+    }
+
+    inline const char* backendName() {
+        return compiled() && detail::enabledFlag() ? "blas" : "native";
+    }
+
+    /**
+     * @brief Row-major C += alpha * A * B, computed as the column-major C^T += alpha B^T A^T.
+     * * Only valid when active<T>().
+     */
+    template <typename T>
+    void gemm(int m, int n, int k, T alpha, const T* A, int lda, const T* B, int ldb, T* C, int ldc) {
+#ifdef LINEARCPP_ENABLE_BLAS
+        const Int M = n, N = m, K = k, LDA = ldb, LDB = lda, LDC = ldc;
+        const T beta = T(1);
+        if constexpr (std::is_same<T, double>::value) {
+            dgemm_("N", "N", &M, &N, &K, &alpha, B, &LDA, A, &LDB, &beta, C, &LDC);
+        } else if constexpr (std::is_same<T, float>::value) {
+            sgemm_("N", "N", &M, &N, &K, &alpha, B, &LDA, A, &LDB, &beta, C, &LDC);
+        }
+#else
+        (void)m; (void)n; (void)k; (void)alpha; (void)A; (void)lda; (void)B; (void)ldb; (void)C; (void)ldc;
+#endif
+    }
+
+    /**
+     * @brief Solves op(T) X = B in place for the n x nrhs column-major B, where the
+     * column-major triangular matrix is given by LAPACK-style flags ('L'/'U', 'N'/'T', 'N'/'U').
+     * * Only valid when active<T>().
+     */
+    template <typename T>
+    void trsm(char uplo, char trans, char diag, int n, int nrhs, const T* A, int lda, T* B, int ldb) {
+#ifdef LINEARCPP_ENABLE_BLAS
+        const Int N = n, NRHS = nrhs, LDA = lda, LDB = ldb;
+        const T one = T(1);
+        if constexpr (std::is_same<T, double>::value) {
+            dtrsm_("L", &uplo, &trans, &diag, &N, &NRHS, &one, A, &LDA, B, &LDB);
+        } else if constexpr (std::is_same<T, float>::value) {
+            strsm_("L", &uplo, &trans, &diag, &N, &NRHS, &one, A, &LDA, B, &LDB);
+        }
+#else
+        (void)uplo; (void)trans; (void)diag; (void)n; (void)nrhs; (void)A; (void)lda; (void)B; (void)ldb;
+#endif
+    }
+
+    /**
+     * @brief LU factorization with partial pivoting of the column-major n x n matrix A.
+     * @param pivots Receives the 1-based row interchanges of LAPACK.
+     * @return LAPACK info: 0 on success, i > 0 if U(i, i) is exactly zero.
+     */
+    template <typename T>
+    Int getrf(int n, T* A, int lda, std::vector<Int>& pivots) {
+        Int info = 0;
+        pivots.resize(n);
+#ifdef LINEARCPP_ENABLE_BLAS
+        const Int N = n, LDA = lda;
+        if constexpr (std::is_same<T, double>::value) {
+            dgetrf_(&N, &N, A, &LDA, pivots.data(), &info);
+        } else if constexpr (std::is_same<T, float>::value) {
+            sgetrf_(&N, &N, A, &LDA, pivots.data(), &info);
+        }
+#else
+        (void)A; (void)lda;
+#endif
+        return info;
+    }
+
+    /**
+     * @brief Cholesky factorization A = U^T U of the column-major n x n SPD matrix A.
+     * * For symmetric row-major storage, the column-major upper factor U read row-major is
+     * the lower factor L = U^T, so no transposition is needed.
+     * @return LAPACK info: 0 on success, i > 0 if the leading minor of order i is not positive.
+     */
+    template <typename T>
+    Int potrf(int n, T* A, int lda) {
+        Int info = 0;
+#ifdef LINEARCPP_ENABLE_BLAS
+        const Int N = n, LDA = lda;
+        if constexpr (std::is_same<T, double>::value) {
+            dpotrf_("U", &N, A, &LDA, &info);
+        } else if constexpr (std::is_same<T, float>::value) {
+            spotrf_("U", &N, A, &LDA, &info);
+        }
+#else
+        (void)n; (void)A; (void)lda;
+#endif
+        return info;
+    }
+
+} // namespace blas
+
+#endif // BLAS_HPP
@@ -0,0 +1,283 @@
+#ifndef COMPLEX_HPP
+#define COMPLEX_HPP
+
+#include <algorithm>
+#include <complex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "Matrix.hpp"
+#include "Blas.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Complex matrix storage, products and adjoint views.
+ * * Matrix<std::complex<R>> is the interleaved layout: (re, im) pairs, as std::complex stores
+ * them. Its products already run at real-GEMM efficiency: the blocked GEMM uses a 4M
+ * micro-kernel (see gemm::complexMicroKernel) that performs the four real multiply-adds of
+ * each complex one on real vectors. decomposeLU and solve work on it directly.
+ *
+ * SplitMatrix<R> keeps the real and imaginary parts in two real matrices, the layout of
+ * most signal-processing pipelines. Split products are assembled from real GEMMs, so they
+ * use an external BLAS when one is active, and can use the 3M (Karatsuba) scheme: three
+ * real products instead of four, at the price of O(n^2) extra additions, temporaries and a
+ * slightly weaker error bound on the imaginary part.
+ */
+namespace cplx {
+
+    /**
+     * @brief A complex matrix held as separate real and imaginary parts.
+     */
+    template <typename R>
+    struct SplitMatrix {
+        static_assert(std::is_floating_point<R>::value, "SplitMatrix requires a real floating-point type.");
+        Matrix<R> re; //< Real parts.
+        Matrix<R> im; //< Imaginary parts.
+
+        SplitMatrix() = default;
+        SplitMatrix(int rows, int cols) : re(rows, cols), im(rows, cols) {}
+        SplitMatrix(Matrix<R> real, Matrix<R> imag) : re(std::move(real)), im(std::move(imag)) {
+            if (re.getRows() != im.getRows() || re.getCols() != im.getCols()) {
+                throw std::invalid_argument("Error: Real and imaginary parts must have the same dimensions.");
+            }
+        }
+
+        int getRows() const { return re.getRows(); }
+        int getCols() const { return re.getCols(); }
+    };
+
+    /**
+     * @brief Product algorithm for complex matrices.
+     * - FourM: four real products per complex product (or the 4M micro-kernel).
+     * - ThreeM: three real products, (Ar + Ai)(Br + Bi) - ArBr - AiBi for the imaginary part.
+     * - Auto: ThreeM when all dimensions reach threeMCutoff, FourM otherwise.
+     */
+    enum class Algorithm { Auto, FourM, ThreeM };
+
+    /**
+     * @brief Smallest m, n and k at which Auto picks 3M. Below it, the O(n^2) additions and
+     * temporaries of 3M outweigh the saved quarter of the multiplications.
+     */
+    constexpr int threeMCutoff = 256;
+
+    /**
+     * @brief Splits an interleaved complex matrix into real and imaginary parts.
+     */
+    template <typename R>
+    SplitMatrix<R> split(const Matrix<std::complex<R>>& M) {
+        SplitMatrix<R> result(M.getRows(), M.getCols());
+        const int cols = M.getCols();
+        parallel::parallelFor(0, M.getRows(), parallel::grainFor(cols), [&](int rowBegin, int rowEnd) {
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                for (int j = 0; j < cols; ++j) {
+                    result.re(i, j) = M(i, j).real();
+                    result.im(i, j) = M(i, j).imag();
+                }
+            }
+        });
+        return result;
+    }
+
+    /**
+     * @brief Interleaves split parts back into a Matrix<std::complex<R>>.
+     */
+    template <typename R>
+    Matrix<std::complex<R>> interleave(const SplitMatrix<R>& M) {
+        Matrix<std::complex<R>> result(M.getRows(), M.getCols());
+        const int cols = M.getCols();
+        parallel::parallelFor(0, M.getRows(), parallel::grainFor(cols), [&](int rowBegin, int rowEnd) {
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                for (int j = 0; j < cols; ++j) {
+                    result(i, j) = std::complex<R>(M.re(i, j), M.im(i, j));
+                }
+            }
+        });
+        return result;
+    }
+
+    namespace detail {
+
+        inline bool useThreeM(Algorithm algorithm, int m, int n, int k) {
+            if (algorithm == Algorithm::Auto) {
+                return std::min({m, n, k}) >= threeMCutoff;
+            }
+            return algorithm == Algorithm::ThreeM;
+        }
+
+        // out = x + sign * y, element-wise.
+        template <typename R>
+        Matrix<R> combine(const Matrix<R>& x, const Matrix<R>& y, R sign) {
+            Matrix<R> out(x.getRows(), x.getCols());
+            const int cols = x.getCols();
+            parallel::parallelFor(0, x.getRows(), parallel::grainFor(cols), [&](int rowBegin, int rowEnd) {
+                for (int i = rowBegin; i < rowEnd; ++i) {
+                    for (int j = 0; j < cols; ++j) {
+                        out(i, j) = x(i, j) + sign * y(i, j);
+                    }
+                }
+            });
+            return out;
+        }
+
+        template <typename R>
+        void multiplyAdd(R alpha, const Matrix<R>& A, const Matrix<R>& B, Matrix<R>& C) {
+            gemm::multiplyAdd(A.getRows(), B.getCols(), A.getCols(), alpha,
+                              A.data(), A.getCols(), B.data(), B.getCols(), C.data(), C.getCols());
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Product of two split complex matrices.
+     * * FourM runs four real GEMMs. ThreeM runs three on ArBr, AiBi and (Ar + Ai)(Br + Bi) and
+     * recovers re(C) = ArBr - AiBi and im(C) = (Ar + Ai)(Br + Bi) - ArBr - AiBi. The real
+     * GEMMs go to BLAS when it is active for R.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename R>
+    SplitMatrix<R> multiply(const SplitMatrix<R>& A, const SplitMatrix<R>& B, Algorithm algorithm = Algorithm::Auto) {
+        if (A.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        const int m = A.getRows(), n = B.getCols(), k = A.getCols();
+        SplitMatrix<R> C(m, n);
+        if (!detail::useThreeM(algorithm, m, n, k)) {
+            LINEARCPP_TRACE_SCOPE("complex_gemm_4m", "product", m);
+            detail::multiplyAdd(R(1), A.re, B.re, C.re);
+            detail::multiplyAdd(R(-1), A.im, B.im, C.re);
+            detail::multiplyAdd(R(1), A.re, B.im, C.im);
+            detail::multiplyAdd(R(1), A.im, B.re, C.im);
+            return C;
+        }
+        LINEARCPP_TRACE_SCOPE("complex_gemm_3m", "product", m);
+        Matrix<R> imagProduct(m, n);
+        detail::multiplyAdd(R(1), A.re, B.re, C.re);
+        detail::multiplyAdd(R(1), A.im, B.im, imagProduct);
+        detail::multiplyAdd(R(1), detail::combine(A.re, A.im, R(1)), detail::combine(B.re, B.im, R(1)), C.im);
+        parallel::parallelFor(0, m, parallel::grainFor(2LL * n), [&](int rowBegin, int rowEnd) {
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                for (int j = 0; j < n; ++j) {
+                    C.im(i, j) -= C.re(i, j) + imagProduct(i, j);
+                    C.re(i, j) -= imagProduct(i, j);
+                }
+            }
+        });
+        return C;
+    }
+
+    /**
+     * @brief Product of two interleaved complex matrices.
+     * * FourM runs the blocked GEMM with the 4M micro-kernel on the interleaved data; ThreeM
+     * splits the operands, runs the split 3M product and interleaves the result.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename R>
+    Matrix<std::complex<R>> multiply(const Matrix<std::complex<R>>& A, const Matrix<std::complex<R>>& B,
+                                     Algorithm algorithm = Algorithm::Auto) {
+        if (A.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        if (detail::useThreeM(algorithm, A.getRows(), B.getCols(), A.getCols())) {
+            return interleave(multiply(split(A), split(B), Algorithm::ThreeM));
+        }
+        return matrixMultiply(A, B);
+    }
+
+    /**
+     * @brief Non-owning view of the conjugate transpose A^H of a matrix.
+     * * Element access conjugates and transposes on the fly; toMatrix() materializes the view
+     * with a tiled, parallel transposition. The viewed matrix must outlive the view.
+     */
+    template <typename T>
+    class AdjointView {
+        private:
+            const Matrix<T>* m_matrix;
+
+        public:
+            explicit AdjointView(const Matrix<T>& matrix) : m_matrix(&matrix) {}
+
+            int getRows() const { return m_matrix->getCols(); }
+            int getCols() const { return m_matrix->getRows(); }
+            const Matrix<T>& base() const { return *m_matrix; }
+
+            T operator()(int i, int j) const {
+                if constexpr (gemm::IsComplex<T>::value) {
+                    return std::conj((*m_matrix)(j, i));
+                } else {
+                    return (*m_matrix)(j, i);
+                }
+            }
+
+            Matrix<T> toMatrix() const {
+                constexpr int tile = 32;
+                const int rows = getRows(), cols = getCols();
+                Matrix<T> result(rows, cols);
+                parallel::parallelFor(0, (rows + tile - 1) / tile, parallel::grainFor(int64_t(tile) * cols),
+                                      [&](int firstTile, int lastTile) {
+                    for (int i0 = firstTile * tile; i0 < std::min(rows, lastTile * tile); i0 += tile) {
+                        for (int j0 = 0; j0 < cols; j0 += tile) {
+                            for (int i = i0; i < std::min(rows, i0 + tile); ++i) {
+                                for (int j = j0; j < std::min(cols, j0 + tile); ++j) {
+                                    result(i, j) = (*this)(i, j);
+                                }
+                            }
+                        }
+                    }
+                });
+                return result;
+            }
+    };
+
+    /**
+     * @brief The conjugate transpose A^H as a view (the plain transpose for real types).
+     */
+    template <typename T>
+    AdjointView<T> adjoint(const Matrix<T>& A) {
+        return AdjointView<T>(A);
+    }
+
+    /**
+     * @brief The materialized conjugate transpose A^H.
+     */
+    template <typename T>
+    Matrix<T> conjugateTranspose(const Matrix<T>& A) {
+        return adjoint(A).toMatrix();
+    }
+
+    /**
+     * @brief A^H B for the Gram matrices and matched filters of signal processing.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename T>
+    Matrix<T> multiply(const AdjointView<T>& Ah, const Matrix<T>& B, Algorithm algorithm = Algorithm::Auto) {
+        if (Ah.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        if constexpr (gemm::IsComplex<T>::value) {
+            return multiply(Ah.toMatrix(), B, algorithm);
+        } else {
+            return matrixMultiply(Ah.toMatrix(), B);
+        }
+    }
+
+    /**
+     * @brief A B^H.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename T>
+    Matrix<T> multiply(const Matrix<T>& A, const AdjointView<T>& Bh, Algorithm algorithm = Algorithm::Auto) {
+        if (A.getCols() != Bh.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        if constexpr (gemm::IsComplex<T>::value) {
+            return multiply(A, Bh.toMatrix(), algorithm);
+        } else {
+            return matrixMultiply(A, Bh.toMatrix());
+        }
+    }
+
+} // namespace cplx
+
+#endif // COMPLEX_HPP
@@ -0,0 +1,238 @@
+#ifndef CONTEXT_HPP
+#define CONTEXT_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Cooperative cancellation, deadlines and progress reporting for long operations.
+ * * A Context carries a cancellation token, an optional deadline and an optional progress
+ * callback. Installed on a thread with ScopedContext, it is seen by every library operation
+ * that thread runs, and by the pool tasks those operations fork (parallel::parallelFor
+ * hands it on). Operations check it at coarse-grained points (GEMM panels, Strassen levels
+ * and products, LU panels, file I/O chunks) and throw exec::Cancelled or
+ * exec::DeadlineExceeded there; parallel loops stop claiming chunks, so all threads are
+ * released within one checkpoint interval.
+ *
+ *   exec::CancellationToken token;            // token.cancel() from any thread
+ *   exec::Context context;
+ *   context.withToken(token).withTimeout(std::chrono::seconds(2))
+ *          .onProgress([](const exec::Progress& p) { ... });
+ *   exec::ScopedContext scope(context);
+ *   LUResult<double> lu = decomposeLU(A);     // may throw exec::Cancelled
+ *
+ * Without a context the checkpoints cost one thread-local load.
+ */
+namespace exec {
+
+    /**
+     * @brief Thrown at a checkpoint after the context's token was cancelled.
+     */
+    class Cancelled : public std::runtime_error {
+        public:
+            explicit Cancelled(const std::string& message = "Error: Operation cancelled.")
+                : std::runtime_error(message) {}
+    };
+
+    /**
+     * @brief Thrown at a checkpoint once the context's deadline has passed.
+     */
+    class DeadlineExceeded : public Cancelled {
+        public:
+            DeadlineExceeded() : Cancelled("Error: Operation deadline exceeded.") {}
+    };
+
+    /**
+     * @brief Shared cancellation flag. Copies refer to the same flag; cancel() may be called
+     * from any thread.
+     */
+    class CancellationToken {
+        private:
+            std::shared_ptr<std::atomic<bool>> m_flag;
+
+        public:
+            CancellationToken() : m_flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+            void cancel() const { m_flag->store(true, std::memory_order_relaxed); }
+            bool cancelled() const { return m_flag->load(std::memory_order_relaxed); }
+    };
+
+    /**
+     * @brief Progress of the outermost running operation: its name ("gemm", "strassen",
+     * "lu", "read", "write") and the completed fraction of its work, in [0, 1].
+     */
+    struct Progress {
+        const char* operation;
+        double fraction;
+    };
+
+    /**
+     * @brief What a long operation checks at its checkpoints.
+     */
+    class Context {
+        public:
+            using Clock = std::chrono::steady_clock;
+            using Callback = std::function<void(const Progress&)>;
+
+        private:
+            CancellationToken m_token;
+            Clock::time_point m_deadline = Clock::time_point::max();
+            Callback m_progress;
+
+        public:
+            Context& withToken(CancellationToken token) {
+                m_token = std::move(token);
+                return *this;
+            }
+
+            Context& withDeadline(Clock::time_point deadline) {
+                m_deadline = deadline;
+                return *this;
+            }
+
+            template <typename Rep, typename Period>
+            Context& withTimeout(std::chrono::duration<Rep, Period> timeout) {
+                m_deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout);
+                return *this;
+            }
+
+            /**
+             * @brief Sets the progress callback. It runs on whichever thread completes a unit
+             * of work, never concurrently with itself for one operation, and should return
+             * quickly; an exception it throws aborts the operation like a cancellation.
+             */
+            Context& onProgress(Callback callback) {
+                m_progress = std::move(callback);
+                return *this;
+            }
+
+            const CancellationToken& token() const { return m_token; }
+            Clock::time_point deadline() const { return m_deadline; }
+            const Callback& progress() const { return m_progress; }
+
+            /**
+             * @brief Throws Cancelled or DeadlineExceeded if the operation must stop.
+             */
+            void check() const {
+                if (m_token.cancelled()) {
+                    throw Cancelled();
+                }
+                if (m_deadline != Clock::time_point::max() && Clock::now() >= m_deadline) {
+                    throw DeadlineExceeded();
+                }
+            }
+    };
+
+    namespace detail {
+
+        // What the calling thread runs under: its context and how many Stages are open.
+        struct State {
+            const Context* context = nullptr;
+            int depth = 0;
+        };
+
+        inline State& state() {
+            thread_local State current;
+            return current;
+        }
+
+        /**
+         * @brief Installs a captured State on a pool thread for the lifetime of the object.
+         */
+        class StateGuard {
+            private:
+                State m_previous;
+
+            public:
+                explicit StateGuard(const State& captured) : m_previous(state()) { state() = captured; }
+                ~StateGuard() { state() = m_previous; }
+
+                StateGuard(const StateGuard&) = delete;
+                StateGuard& operator=(const StateGuard&) = delete;
+        };
+
+    } // namespace detail
+
+    /**
+     * @brief The context installed on the calling thread, or nullptr.
+     */
+    inline const Context* current() {
+        return detail::state().context;
+    }
+
+    /**
+     * @brief Installs a context on the calling thread for the lifetime of the object. The
+     * context must outlive the scope.
+     */
+    class ScopedContext {
+        private:
+            const Context* m_previous;
+
+        public:
+            explicit ScopedContext(const Context& context) : m_previous(detail::state().context) {
+                detail::state().context = &context;
+            }
+            ~ScopedContext() { detail::state().context = m_previous; }
+
+            ScopedContext(const ScopedContext&) = delete;
+            ScopedContext& operator=(const ScopedContext&) = delete;
+    };
+
+    /**
+     * @brief Throws if the current context was cancelled or its deadline has passed.
+     */
+    inline void checkpoint() {
+        if (const Context* context = current()) {
+            context->check();
+        }
+    }
+
+    /**
+     * @brief A unit-counted phase of an operation: checks the context on entry and at every
+     * advance(), and reports progress when it is the outermost stage, so a GEMM inside an
+     * LU update does not interleave its own fractions with the LU's.
+     */
+    class Stage {
+        private:
+            const Context* m_context;
+            const char* m_operation;
+            double m_total;
+            bool m_reports;
+            double m_done = 0.0;
+            std::mutex m_mutex;
+
+        public:
+            Stage(const char* operation, double total)
+                : m_context(current()), m_operation(operation), m_total(total),
+                  m_reports(m_context && m_context->progress() && detail::state().depth == 0) {
+                checkpoint();
+                ++detail::state().depth;
+            }
+
+            ~Stage() { --detail::state().depth; }
+
+            Stage(const Stage&) = delete;
+            Stage& operator=(const Stage&) = delete;
+
+            /**
+             * @brief Records `units` more completed units of the total. Thread-safe.
+             */
+            void advance(double units = 1.0) {
+                if (!m_context) return;
+                m_context->check();
+                if (!m_reports) return;
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_done += units;
+                m_context->progress()({m_operation, m_total > 0 ? std::min(1.0, m_done / m_total) : 1.0});
+            }
+    };
+
+} // namespace exec
+
+#endif // CONTEXT_HPP
@@ -0,0 +1,622 @@
+#ifndef DISTRIBUTED_HPP
+#define DISTRIBUTED_HPP
+
+#ifndef LINEARCPP_ENABLE_MPI
+#error "Distributed.hpp needs MPI: configure with -DLINEARCPP_ENABLE_MPI=ON"
+#endif
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <climits>
+#include <complex>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Matrices distributed over MPI processes and their SUMMA / 2.5D product.
+ * * A Grid arranges the processes of a communicator as `layers` stacked rows x cols
+ * grids. A DistMatrix is split into rows x cols contiguous blocks (balanced to within one
+ * row or column) held by the processes of layer 0; the other layers only hold replicas
+ * while a product runs. multiply() is SUMMA (van de Geijn and Watts, 1997): the shared
+ * dimension is cut into panels, and for each panel the owning process column broadcasts
+ * its slice of A along the process rows and the owning process row broadcasts its slice of
+ * B along the process columns, after which every process adds the outer product to its
+ * block of C with the local GEMM (the packed kernel, or the vendor BLAS when active). The
+ * broadcasts of the next panel are in flight while the current one is multiplied.
+ *
+ * With layers c > 1 it runs the 2.5D algorithm (Solomonik and Demmel, 2011): layer 0
+ * broadcasts A and B to the other layers, every layer runs SUMMA over a 1/c share of the
+ * panels on its (P/c)-process grid, and the partial products are summed back onto layer 0.
+ * Each process then moves about sqrt(c) times fewer words than with 2D SUMMA over all P
+ * processes, for c times the memory.
+ *
+ * CyclicMatrix holds the 2D block-cyclic layout used by the distributed LU in
+ * DistributedSolver.hpp.
+ *
+ * All calls are collective over the grid's communicator. Grid and DistMatrix objects must
+ * be destroyed before MPI_Finalize.
+ */
+namespace dist {
+
+    /**
+     * @brief The MPI datatype of an element type.
+     */
+    template <typename T>
+    struct MpiType;
+
+    template <> struct MpiType<float> { static MPI_Datatype get() { return MPI_FLOAT; } };
+    template <> struct MpiType<double> { static MPI_Datatype get() { return MPI_DOUBLE; } };
+    template <> struct MpiType<int> { static MPI_Datatype get() { return MPI_INT; } };
+    template <> struct MpiType<long long> { static MPI_Datatype get() { return MPI_LONG_LONG; } };
+    template <> struct MpiType<std::complex<float>> { static MPI_Datatype get() { return MPI_CXX_FLOAT_COMPLEX; } };
+    template <> struct MpiType<std::complex<double>> { static MPI_Datatype get() { return MPI_CXX_DOUBLE_COMPLEX; } };
+
+    /**
+     * @brief First index of part `index` when n items are split into `parts` balanced
+     * contiguous parts (the first n % parts parts get one extra item).
+     */
+    inline int blockOffset(int n, int parts, int index) {
+        return index * (n / parts) + std::min(index, n % parts);
+    }
+
+    /**
+     * @brief Part of `parts` balanced parts of n items that holds item i.
+     */
+    inline int blockOwner(int n, int parts, int i) {
+        const int size = n / parts, extra = n % parts;
+        return i < extra * (size + 1) ? i / (size + 1) : extra + (i - extra * (size + 1)) / size;
+    }
+
+    namespace detail {
+
+        inline int mpiCount(size_t count) {
+            if (count > size_t(INT_MAX)) {
+                throw std::runtime_error("Error: Distributed block exceeds the MPI count limit.");
+            }
+            return static_cast<int>(count);
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Processes of a communicator arranged as layers x rows x cols, with the row,
+     * column and layer (fiber) sub-communicators. Rank = (layer * rows + row) * cols + col.
+     */
+    class Grid {
+        private:
+            MPI_Comm m_comm;
+            MPI_Comm m_rowComm;   //< Same layer and row; rank = column.
+            MPI_Comm m_colComm;   //< Same layer and column; rank = row.
+            MPI_Comm m_fiberComm; //< Same row and column; rank = layer.
+            int m_rank;
+            int m_rows;
+            int m_cols;
+            int m_layers;
+            int m_row;
+            int m_col;
+            int m_layer;
+
+        public:
+            /**
+             * @param layers Number of replicated layers c; 1 gives the 2D grid of SUMMA.
+             * @param rows, cols Grid shape of each layer; 0 lets MPI_Dims_create pick a
+             * near-square one.
+             * @throws std::invalid_argument If the process count does not factor so.
+             */
+            explicit Grid(MPI_Comm comm = MPI_COMM_WORLD, int layers = 1, int rows = 0, int cols = 0) {
+                int size = 0;
+                MPI_Comm_size(comm, &size);
+                if (layers < 1 || size % layers != 0) {
+                    throw std::invalid_argument("Error: Process count " + std::to_string(size) +
+                                                " is not a multiple of the layer count.");
+                }
+                int dims[2] = {rows, cols};
+                if (rows <= 0 || cols <= 0) {
+                    dims[0] = dims[1] = 0;
+                    MPI_Dims_create(size / layers, 2, dims);
+                }
+                if (dims[0] * dims[1] * layers != size) {
+                    throw std::invalid_argument("Error: Grid shape does not match the process count.");
+                }
+                m_rows = dims[0];
+                m_cols = dims[1];
+                m_layers = layers;
+                MPI_Comm_dup(comm, &m_comm);
+                MPI_Comm_rank(m_comm, &m_rank);
+                m_layer = m_rank / (m_rows * m_cols);
+                m_row = m_rank / m_cols % m_rows;
+                m_col = m_rank % m_cols;
+                MPI_Comm_split(m_comm, m_layer * m_rows + m_row, m_col, &m_rowComm);
+                MPI_Comm_split(m_comm, m_layer * m_cols + m_col, m_row, &m_colComm);
+                MPI_Comm_split(m_comm, m_row * m_cols + m_col, m_layer, &m_fiberComm);
+            }
+
+            ~Grid() {
+                MPI_Comm_free(&m_fiberComm);
+                MPI_Comm_free(&m_colComm);
+                MPI_Comm_free(&m_rowComm);
+                MPI_Comm_free(&m_comm);
+            }
+
+            Grid(const Grid&) = delete;
+            Grid& operator=(const Grid&) = delete;
+
+            MPI_Comm comm() const { return m_comm; }
+            MPI_Comm rowComm() const { return m_rowComm; }
+            MPI_Comm colComm() const { return m_colComm; }
+            MPI_Comm fiberComm() const { return m_fiberComm; }
+            int rank() const { return m_rank; }
+            int size() const { return m_rows * m_cols * m_layers; }
+            int rows() const { return m_rows; }
+            int cols() const { return m_cols; }
+            int layers() const { return m_layers; }
+            int row() const { return m_row; }
+            int col() const { return m_col; }
+            int layer() const { return m_layer; }
+    };
+
+    /**
+     * @brief A rows x cols matrix split into grid.rows() x grid.cols() contiguous blocks,
+     * one per process of layer 0 (processes of other layers hold an empty block).
+     */
+    template <typename T>
+    class DistMatrix {
+        private:
+            const Grid* m_grid;
+            int m_rows;
+            int m_cols;
+            Matrix<T> m_local;
+
+        public:
+            /**
+             * @brief A zero matrix distributed over `grid`.
+             */
+            DistMatrix(const Grid& grid, int rows, int cols) : m_grid(&grid), m_rows(rows), m_cols(cols) {
+                if (rows < 0 || cols < 0) {
+                    throw std::invalid_argument("Error: Matrix dimensions must be non-negative.");
+                }
+                if (grid.layer() == 0) {
+                    m_local = Matrix<T>(localRowsOf(grid.row()), localColsOf(grid.col()));
+                }
+            }
+
+            const Grid& grid() const { return *m_grid; }
+            int getRows() const { return m_rows; }
+            int getCols() const { return m_cols; }
+
+            int localRowsOf(int gridRow) const {
+                return blockOffset(m_rows, m_grid->rows(), gridRow + 1) - blockOffset(m_rows, m_grid->rows(), gridRow);
+            }
+            int localColsOf(int gridCol) const {
+                return blockOffset(m_cols, m_grid->cols(), gridCol + 1) - blockOffset(m_cols, m_grid->cols(), gridCol);
+            }
+
+            /** First global row of this process's block. */
+            int rowBegin() const { return blockOffset(m_rows, m_grid->rows(), m_grid->row()); }
+            /** First global column of this process's block. */
+            int colBegin() const { return blockOffset(m_cols, m_grid->cols(), m_grid->col()); }
+
+            /** This process's block (empty outside layer 0). */
+            Matrix<T>& local() { return m_local; }
+            const Matrix<T>& local() const { return m_local; }
+
+            /**
+             * @brief Builds the matrix in place from f(globalRow, globalCol), with no data
+             * movement.
+             */
+            template <typename F>
+            static DistMatrix generate(const Grid& grid, int rows, int cols, F f) {
+                DistMatrix result(grid, rows, cols);
+                const int r0 = result.rowBegin(), c0 = result.colBegin();
+                for (int i = 0; i < result.m_local.getRows(); ++i) {
+                    for (int j = 0; j < result.m_local.getCols(); ++j) {
+                        result.m_local(i, j) = f(r0 + i, c0 + j);
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * @brief Distributes a matrix held by process `root` (the argument is ignored on
+             * the other processes).
+             */
+            static DistMatrix scatter(const Grid& grid, const Matrix<T>& global, int root = 0) {
+                int dims[2] = {global.getRows(), global.getCols()};
+                MPI_Bcast(dims, 2, MPI_INT, root, grid.comm());
+                DistMatrix result(grid, dims[0], dims[1]);
+                std::vector<int> counts(grid.size(), 0), displs(grid.size(), 0);
+                std::vector<T> packed;
+                if (grid.rank() == root) {
+                    packed.reserve(size_t(dims[0]) * dims[1]);
+                    for (int r = 0; r < grid.rows(); ++r) {
+                        for (int c = 0; c < grid.cols(); ++c) {
+                            const int rank = r * grid.cols() + c;
+                            displs[rank] = detail::mpiCount(packed.size());
+                            const int r0 = blockOffset(dims[0], grid.rows(), r);
+                            const int c0 = blockOffset(dims[1], grid.cols(), c);
+                            for (int i = 0; i < result.localRowsOf(r); ++i) {
+                                const T* row = global.data() + size_t(r0 + i) * dims[1] + c0;
+                                packed.insert(packed.end(), row, row + result.localColsOf(c));
+                            }
+                            counts[rank] = detail::mpiCount(packed.size()) - displs[rank];
+                        }
+                    }
+                }
+                MPI_Scatterv(packed.data(), counts.data(), displs.data(), MpiType<T>::get(),
+                             result.m_local.data(), detail::mpiCount(size_t(result.m_local.getRows()) * result.m_local.getCols()),
+                             MpiType<T>::get(),
+                             root, grid.comm());
+                return result;
+            }
+
+            /**
+             * @brief Collects the whole matrix on process `root`; the other processes get an
+             * empty matrix.
+             */
+            Matrix<T> gather(int root = 0) const {
+                const Grid& grid = *m_grid;
+                std::vector<int> counts(grid.size(), 0), displs(grid.size(), 0);
+                int total = 0;
+                for (int r = 0; r < grid.rows(); ++r) {
+                    for (int c = 0; c < grid.cols(); ++c) {
+                        const int rank = r * grid.cols() + c;
+                        displs[rank] = total;
+                        counts[rank] = detail::mpiCount(size_t(localRowsOf(r)) * localColsOf(c));
+                        total = detail::mpiCount(size_t(total) + counts[rank]);
+                    }
+                }
+                std::vector<T> packed(grid.rank() == root ? total : 0);
+                MPI_Gatherv(m_local.data(), detail::mpiCount(size_t(m_local.getRows()) * m_local.getCols()), MpiType<T>::get(),
+                            packed.data(), counts.data(), displs.data(), MpiType<T>::get(), root, grid.comm());
+                if (grid.rank() != root) {
+                    return Matrix<T>();
+                }
+                Matrix<T> global(m_rows, m_cols);
+                for (int r = 0; r < grid.rows(); ++r) {
+                    for (int c = 0; c < grid.cols(); ++c) {
+                        const T* block = packed.data() + displs[r * grid.cols() + c];
+                        const int r0 = blockOffset(m_rows, grid.rows(), r);
+                        const int c0 = blockOffset(m_cols, grid.cols(), c);
+                        const int cols = localColsOf(c);
+                        for (int i = 0; i < localRowsOf(r); ++i) {
+                            std::copy(block + size_t(i) * cols, block + size_t(i + 1) * cols,
+                                      global.data() + size_t(r0 + i) * m_cols + c0);
+                        }
+                    }
+                }
+                return global;
+            }
+    };
+
+    /**
+     * @brief Number of the first n items that land on part `index` when they are dealt in
+     * blocks of nb round-robin over `parts` parts (ScaLAPACK's NUMROC). With n the global
+     * index of an item, it is also that item's local index on part `index` if it lives there,
+     * or the local index of the part's next item otherwise.
+     */
+    inline int cyclicCount(int n, int nb, int parts, int index) {
+        const int blocks = n / nb;
+        int count = blocks / parts * nb;
+        if (index < blocks % parts) {
+            count += nb;
+        } else if (index == blocks % parts) {
+            count += n % nb;
+        }
+        return count;
+    }
+
+    /**
+     * @brief Part holding item i in a block-cyclic distribution.
+     */
+    inline int cyclicOwner(int i, int nb, int parts) {
+        return i / nb % parts;
+    }
+
+    /**
+     * @brief Global index of local item `local` of part `index` in a block-cyclic distribution.
+     */
+    inline int cyclicGlobal(int local, int nb, int parts, int index) {
+        return (local / nb * parts + index) * nb + local % nb;
+    }
+
+    /**
+     * @brief A rows x cols matrix in the 2D block-cyclic distribution of ScaLAPACK: the
+     * matrix is tiled into block x block tiles, and tile (I, J) lives on process
+     * (I mod grid.rows(), J mod grid.cols()) of layer 0. Each process stores its tiles as one
+     * local row-major matrix, in global order, so every trailing submatrix of the global
+     * matrix is a trailing submatrix of each local one. This is the layout of the
+     * distributed factorizations (DistributedSolver.hpp), which it keeps load-balanced as the
+     * active part of the matrix shrinks.
+     */
+    template <typename T>
+    class CyclicMatrix {
+        private:
+            const Grid* m_grid;
+            int m_rows;
+            int m_cols;
+            int m_block;
+            Matrix<T> m_local;
+
+        public:
+            /**
+             * @brief A zero matrix distributed over `grid` in block x block tiles.
+             */
+            CyclicMatrix(const Grid& grid, int rows, int cols, int block)
+                : m_grid(&grid), m_rows(rows), m_cols(cols), m_block(block) {
+                if (rows < 0 || cols < 0) {
+                    throw std::invalid_argument("Error: Matrix dimensions must be non-negative.");
+                }
+                if (block < 1) {
+                    throw std::invalid_argument("Error: Distribution block size must be positive.");
+                }
+                if (grid.layer() == 0) {
+                    m_local = Matrix<T>(localRowsOf(grid.row()), localColsOf(grid.col()));
+                }
+            }
+
+            const Grid& grid() const { return *m_grid; }
+            int getRows() const { return m_rows; }
+            int getCols() const { return m_cols; }
+            int blockSize() const { return m_block; }
+
+            int localRowsOf(int gridRow) const { return cyclicCount(m_rows, m_block, m_grid->rows(), gridRow); }
+            int localColsOf(int gridCol) const { return cyclicCount(m_cols, m_block, m_grid->cols(), gridCol); }
+
+            /** Global row of local row i of this process. */
+            int globalRow(int i) const { return cyclicGlobal(i, m_block, m_grid->rows(), m_grid->row()); }
+            /** Global column of local column j of this process. */
+            int globalCol(int j) const { return cyclicGlobal(j, m_block, m_grid->cols(), m_grid->col()); }
+
+            /** Number of this process's local rows whose global row is below `row`. */
+            int localRowsBefore(int row) const { return cyclicCount(row, m_block, m_grid->rows(), m_grid->row()); }
+            /** Number of this process's local columns whose global column is below `col`. */
+            int localColsBefore(int col) const { return cyclicCount(col, m_block, m_grid->cols(), m_grid->col()); }
+
+            /** This process's tiles (empty outside layer 0). */
+            Matrix<T>& local() { return m_local; }
+            const Matrix<T>& local() const { return m_local; }
+
+            /**
+             * @brief Builds the matrix in place from f(globalRow, globalCol), with no data
+             * movement.
+             */
+            template <typename F>
+            static CyclicMatrix generate(const Grid& grid, int rows, int cols, int block, F f) {
+                CyclicMatrix result(grid, rows, cols, block);
+                for (int i = 0; i < result.m_local.getRows(); ++i) {
+                    const int gi = result.globalRow(i);
+                    for (int j = 0; j < result.m_local.getCols(); ++j) {
+                        result.m_local(i, j) = f(gi, result.globalCol(j));
+                    }
+                }
+                return result;
+            }
+
+            /**
+             * @brief Distributes a matrix held by process `root` (the argument is ignored on
+             * the other processes).
+             */
+            static CyclicMatrix scatter(const Grid& grid, const Matrix<T>& global, int block, int root = 0) {
+                int dims[2] = {global.getRows(), global.getCols()};
+                MPI_Bcast(dims, 2, MPI_INT, root, grid.comm());
+                CyclicMatrix result(grid, dims[0], dims[1], block);
+                std::vector<int> counts(grid.size(), 0), displs(grid.size(), 0);
+                std::vector<T> packed;
+                if (grid.rank() == root) {
+                    packed.reserve(size_t(dims[0]) * dims[1]);
+                    for (int r = 0; r < grid.rows(); ++r) {
+                        for (int c = 0; c < grid.cols(); ++c) {
+                            const int rank = r * grid.cols() + c;
+                            displs[rank] = detail::mpiCount(packed.size());
+                            for (int i = 0; i < result.localRowsOf(r); ++i) {
+                                const T* row = global.data() + size_t(cyclicGlobal(i, block, grid.rows(), r)) * dims[1];
+                                for (int j = 0; j < result.localColsOf(c); ++j) {
+                                    packed.push_back(row[cyclicGlobal(j, block, grid.cols(), c)]);
+                                }
+                            }
+                            counts[rank] = detail::mpiCount(packed.size()) - displs[rank];
+                        }
+                    }
+                }
+                MPI_Scatterv(packed.data(), counts.data(), displs.data(), MpiType<T>::get(),
+                             result.m_local.data(), detail::mpiCount(size_t(result.m_local.getRows()) * result.m_local.getCols()),
+                             MpiType<T>::get(), root, grid.comm());
+                return result;
+            }
+
+            /**
+             * @brief Collects the whole matrix on process `root`; the other processes get an
+             * empty matrix.
+             */
+            Matrix<T> gather(int root = 0) const {
+                const Grid& grid = *m_grid;
+                std::vector<int> counts(grid.size(), 0), displs(grid.size(), 0);
+                int total = 0;
+                for (int r = 0; r < grid.rows(); ++r) {
+                    for (int c = 0; c < grid.cols(); ++c) {
+                        const int rank = r * grid.cols() + c;
+                        displs[rank] = total;
+                        counts[rank] = detail::mpiCount(size_t(localRowsOf(r)) * localColsOf(c));
+                        total = detail::mpiCount(size_t(total) + counts[rank]);
+                    }
+                }
+                std::vector<T> packed(grid.rank() == root ? total : 0);
+                MPI_Gatherv(m_local.data(), detail::mpiCount(size_t(m_local.getRows()) * m_local.getCols()), MpiType<T>::get(),
+                            packed.data(), counts.data(), displs.data(), MpiType<T>::get(), root, grid.comm());
+                if (grid.rank() != root) {
+                    return Matrix<T>();
+                }
+                Matrix<T> global(m_rows, m_cols);
+                for (int r = 0; r < grid.rows(); ++r) {
+                    for (int c = 0; c < grid.cols(); ++c) {
+                        const T* block = packed.data() + displs[r * grid.cols() + c];
+                        const int cols = localColsOf(c);
+                        for (int i = 0; i < localRowsOf(r); ++i) {
+                            T* row = global.data() + size_t(cyclicGlobal(i, m_block, grid.rows(), r)) * m_cols;
+                            for (int j = 0; j < cols; ++j) {
+                                row[cyclicGlobal(j, m_block, grid.cols(), c)] = block[size_t(i) * cols + j];
+                            }
+                        }
+                    }
+                }
+                return global;
+            }
+    };
+
+    namespace detail {
+
+        /**
+         * @brief One SUMMA step: the panel [begin, end) of the shared dimension, which lies
+         * in the block of one process column of A and one process row of B.
+         */
+        struct Panel {
+            int begin;
+            int end;
+            int ownerCol;
+            int ownerRow;
+        };
+
+        // Cuts [0, k) at the column blocks of A, the row blocks of B and every `width` items.
+        inline std::vector<Panel> panels(int k, const Grid& grid, int width) {
+            std::vector<Panel> result;
+            int begin = 0;
+            while (begin < k) {
+                const int ownerCol = blockOwner(k, grid.cols(), begin);
+                const int ownerRow = blockOwner(k, grid.rows(), begin);
+                const int end = std::min({k, begin + width, blockOffset(k, grid.cols(), ownerCol + 1),
+                                          blockOffset(k, grid.rows(), ownerRow + 1)});
+                result.push_back({begin, end, ownerCol, ownerRow});
+                begin = end;
+            }
+            return result;
+        }
+
+        /**
+         * @brief A panel's slices of A (local rows x width) and B (width x local columns),
+         * received by non-blocking broadcasts.
+         */
+        template <typename T>
+        struct PanelBuffers {
+            std::vector<T> a;
+            std::vector<T> b;
+            MPI_Request requests[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+
+            void wait() { MPI_Waitall(2, requests, MPI_STATUSES_IGNORE); }
+        };
+
+    } // namespace detail
+
+    /**
+     * @brief Default panel width of multiply(): wide enough for the local GEMM to run at
+     * full speed, narrow enough to overlap the broadcasts of the next panel with it.
+     */
+    constexpr int defaultPanel = 256;
+
+    /**
+     * @brief C = A * B by SUMMA, or by 2.5D SUMMA when the grid has several layers.
+     * @param panel Width of the shared-dimension panels broadcast per step.
+     * @throws std::invalid_argument If the dimensions do not agree or the operands live on
+     * different grids.
+     */
+    template <typename T>
+    DistMatrix<T> multiply(const DistMatrix<T>& A, const DistMatrix<T>& B, int panel = defaultPanel) {
+        if (A.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        if (&A.grid() != &B.grid()) {
+            throw std::invalid_argument("Error: Distributed operands must share one grid.");
+        }
+        const Grid& grid = A.grid();
+        const int m = A.getRows(), n = B.getCols(), k = A.getCols();
+        LINEARCPP_TRACE_SCOPE("summa", "distributed", m);
+        DistMatrix<T> C(grid, m, n);
+
+        // Block shapes depend only on the grid position, so every layer knows them.
+        const int rowsA = A.localRowsOf(grid.row()), colsA = A.localColsOf(grid.col());
+        const int rowsB = B.localRowsOf(grid.row()), colsB = B.localColsOf(grid.col());
+        const MPI_Datatype type = MpiType<T>::get();
+
+        // 2.5D: replicate A and B from layer 0 along the fibers.
+        Matrix<T> replicaA, replicaB;
+        const T* localA = A.local().data();
+        const T* localB = B.local().data();
+        if (grid.layers() > 1) {
+            LINEARCPP_TRACE_SCOPE("summa_replicate", "distributed", grid.layer());
+            if (grid.layer() != 0) {
+                replicaA = Matrix<T>(rowsA, colsA);
+                replicaB = Matrix<T>(rowsB, colsB);
+                localA = replicaA.data();
+                localB = replicaB.data();
+            }
+            MPI_Bcast(const_cast<T*>(localA), detail::mpiCount(size_t(rowsA) * colsA), type, 0, grid.fiberComm());
+            MPI_Bcast(const_cast<T*>(localB), detail::mpiCount(size_t(rowsB) * colsB), type, 0, grid.fiberComm());
+        }
+        Matrix<T> partial = grid.layer() == 0 ? Matrix<T>() : Matrix<T>(rowsA, colsB);
+        Matrix<T>& target = grid.layer() == 0 ? C.local() : partial;
+
+        // Layer l runs panels l, l + c, l + 2c, ...
+        const std::vector<detail::Panel> steps = detail::panels(k, grid, std::max(1, panel));
+        std::vector<detail::Panel> mine;
+        for (size_t s = grid.layer(); s < steps.size(); s += grid.layers()) {
+            mine.push_back(steps[s]);
+        }
+
+        const int aCol0 = A.colBegin(), bRow0 = B.rowBegin();
+        auto post = [&](const detail::Panel& p, detail::PanelBuffers<T>& buffers) {
+            const int width = p.end - p.begin;
+            buffers.a.resize(size_t(rowsA) * width);
+            buffers.b.resize(size_t(width) * colsB);
+            if (grid.col() == p.ownerCol) {
+                for (int i = 0; i < rowsA; ++i) {
+                    const T* row = localA + size_t(i) * colsA + (p.begin - aCol0);
+                    std::copy(row, row + width, buffers.a.data() + size_t(i) * width);
+                }
+            }
+            if (grid.row() == p.ownerRow) {
+                const T* rows = localB + size_t(p.begin - bRow0) * colsB;
+                std::copy(rows, rows + size_t(width) * colsB, buffers.b.data());
+            }
+            MPI_Ibcast(buffers.a.data(), detail::mpiCount(buffers.a.size()), type, p.ownerCol, grid.rowComm(),
+                       &buffers.requests[0]);
+            MPI_Ibcast(buffers.b.data(), detail::mpiCount(buffers.b.size()), type, p.ownerRow, grid.colComm(),
+                       &buffers.requests[1]);
+        };
+
+        detail::PanelBuffers<T> buffers[2];
+        if (!mine.empty()) {
+            post(mine[0], buffers[0]);
+        }
+        for (size_t s = 0; s < mine.size(); ++s) {
+            detail::PanelBuffers<T>& current = buffers[s % 2];
+            current.wait();
+            if (s + 1 < mine.size()) {
+                post(mine[s + 1], buffers[(s + 1) % 2]);
+            }
+            LINEARCPP_TRACE_SCOPE("summa_step", "distributed", mine[s].begin);
+            const int width = mine[s].end - mine[s].begin;
+            gemm::multiplyAdd(rowsA, colsB, width, T(1), current.a.data(), width, current.b.data(), colsB,
+                              target.data(), colsB);
+        }
+
+        if (grid.layers() > 1) {
+            LINEARCPP_TRACE_SCOPE("summa_reduce", "distributed", grid.layer());
+            const int count = detail::mpiCount(size_t(rowsA) * colsB);
+            if (grid.layer() == 0) {
+                MPI_Reduce(MPI_IN_PLACE, target.data(), count, type, MPI_SUM, 0, grid.fiberComm());
+            } else {
+                MPI_Reduce(target.data(), nullptr, count, type, MPI_SUM, 0, grid.fiberComm());
+            }
+        }
+        return C;
+    }
+
+} // namespace dist
+
+#endif // DISTRIBUTED_HPP
@@ -0,0 +1,417 @@
+#ifndef DISTRIBUTED_SOLVER_HPP
+#define DISTRIBUTED_SOLVER_HPP
+
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Distributed.hpp"
+#include "LinearSolver.hpp"
+
+/**
+ * @brief LU decomposition with partial pivoting and linear solves for matrices in the 2D
+ * block-cyclic layout of CyclicMatrix, over MPI.
+ * * decomposeLU is the right-looking blocked algorithm of ScaLAPACK's PDGETRF. For each
+ * block column, the owning process column factors the panel (the pivot of every column is
+ * found with an all-reduce down the process column), then broadcasts the pivots and its
+ * rows of L along the process rows. Every process applies the row interchanges to the rest
+ * of its columns, the process row that owns the diagonal block solves for its block row of
+ * U and broadcasts it down the process columns, and every process updates its part of the
+ * trailing submatrix with the local GEMM. With lookahead, the process column that owns the
+ * next panel updates that panel first, factors it and starts its broadcast before the rest
+ * of the update, so the panel factorization and its communication are off the critical
+ * path.
+ *
+ *   dist::Grid grid(MPI_COMM_WORLD);
+ *   auto A = dist::CyclicMatrix<double>::scatter(grid, global, 64);
+ *   dist::LUResult<double> lu = dist::decomposeLU(A);
+ *   std::vector<double> x = dist::solve(lu, b);   // b and x on every process
+ *
+ * All calls are collective over the grid's communicator, which must have a single layer.
+ */
+namespace dist {
+
+    /**
+     * @brief Result of a distributed LU decomposition (PA = LU), laid out like the
+     * sequential LUResult: L (unit lower, without its diagonal) and U packed into one
+     * matrix, distributed like the input, and the permutation vector and swap sign,
+     * replicated on every process.
+     */
+    template <typename T>
+    struct LUResult {
+        CyclicMatrix<T> LU;  //< Packed L and U matrices.
+        std::vector<int> P;  //< Permutation vector tracking row swaps (pivoting).
+        int toggleSign;      //< Tracks the number of swaps to determine the determinant sign.
+    };
+
+    namespace detail {
+
+        /**
+         * @brief A factored panel on its way along the process rows: its global pivot rows
+         * and the local rows of its L from the panel's first row down, received by
+         * non-blocking broadcasts.
+         */
+        template <typename T>
+        struct LUPanel {
+            std::vector<int> pivots;
+            std::vector<T> l;
+            MPI_Request requests[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+
+            void wait() { MPI_Waitall(2, requests, MPI_STATUSES_IGNORE); }
+        };
+
+        /**
+         * @brief Interchanges global rows j and p over the local column ranges
+         * [first, firstEnd) and [second, secondEnd); a no-op on process rows holding neither.
+         */
+        template <typename T>
+        void swapRows(CyclicMatrix<T>& A, int j, int p, int first, int firstEnd, int second, int secondEnd,
+                      std::vector<T>& buffer) {
+            const Grid& grid = A.grid();
+            Matrix<T>& a = A.local();
+            const int cols = a.getCols();
+            const int ownerJ = cyclicOwner(j, A.blockSize(), grid.rows());
+            const int ownerP = cyclicOwner(p, A.blockSize(), grid.rows());
+            T* rowJ = ownerJ == grid.row() ? a.data() + size_t(A.localRowsBefore(j)) * cols : nullptr;
+            T* rowP = ownerP == grid.row() ? a.data() + size_t(A.localRowsBefore(p)) * cols : nullptr;
+            if (rowJ && rowP) {
+                std::swap_ranges(rowJ + first, rowJ + firstEnd, rowP + first);
+                std::swap_ranges(rowJ + second, rowJ + secondEnd, rowP + second);
+                return;
+            }
+            T* row = rowJ ? rowJ : rowP;
+            if (!row) {
+                return;
+            }
+            buffer.assign(row + first, row + firstEnd);
+            buffer.insert(buffer.end(), row + second, row + secondEnd);
+            const int peer = rowJ ? ownerP : ownerJ;
+            MPI_Sendrecv_replace(buffer.data(), mpiCount(buffer.size()), MpiType<T>::get(), peer, 0, peer, 0,
+                                 grid.colComm(), MPI_STATUS_IGNORE);
+            std::copy(buffer.begin(), buffer.begin() + (firstEnd - first), row + first);
+            std::copy(buffer.begin() + (firstEnd - first), buffer.end(), row + second);
+        }
+
+        /**
+         * @brief Factors the panel of global columns [j0, j0 + kb) in place; called by the
+         * process column that owns it. Row interchanges are applied within the panel only.
+         * @return The global pivot row of each column, or -1 from a null pivot on, in which
+         * case the panel is left partly factored.
+         */
+        template <typename T>
+        std::vector<int> factorPanel(CyclicMatrix<T>& A, int j0, int kb) {
+            const Grid& grid = A.grid();
+            Matrix<T>& a = A.local();
+            const int rows = a.getRows(), cols = a.getCols();
+            const int c0 = A.localColsBefore(j0);
+            const MPI_Datatype type = MpiType<T>::get();
+            std::vector<int> pivots(kb, -1);
+            std::vector<T> pivotRow(kb), buffer;
+            for (int jj = 0; jj < kb; ++jj) {
+                const int j = j0 + jj;
+                // MPI_DOUBLE_INT layout; MAXLOC breaks ties towards the lower row, as the
+                // sequential search does.
+                struct {
+                    double score;
+                    int row;
+                } best = {-1.0, INT_MAX};
+                for (int i = A.localRowsBefore(j); i < rows; ++i) {
+                    const double score = double(PivotTraits<T>::score(a(i, c0 + jj)));
+                    if (score > best.score) {
+                        best.score = score;
+                        best.row = A.globalRow(i);
+                    }
+                }
+                MPI_Allreduce(MPI_IN_PLACE, &best, 1, MPI_DOUBLE_INT, MPI_MAXLOC, grid.colComm());
+
+                const int p = best.row;
+                const int ownerJ = cyclicOwner(j, A.blockSize(), grid.rows());
+                if (p != j) {
+                    swapRows(A, j, p, c0, c0 + kb, cols, cols, buffer);
+                }
+                const int localJ = A.localRowsBefore(j);
+                if (ownerJ == grid.row()) {
+                    std::copy(a.data() + size_t(localJ) * cols + c0 + jj, a.data() + size_t(localJ) * cols + c0 + kb,
+                              pivotRow.begin() + jj);
+                }
+                MPI_Bcast(pivotRow.data() + jj, kb - jj, type, ownerJ, grid.colComm());
+                if (PivotTraits<T>::isNull(pivotRow[jj])) {
+                    return pivots;
+                }
+                pivots[jj] = p;
+
+                const int below = A.localRowsBefore(j + 1);
+                int grain = parallel::grainFor(2LL * (kb - jj));
+                parallel::parallelFor(below, rows, grain, [&](int rowBegin, int rowEnd) {
+                    for (int i = rowBegin; i < rowEnd; ++i) {
+                        T* row = a.data() + size_t(i) * cols + c0;
+                        T mult = row[jj] / pivotRow[jj];
+                        row[jj] = mult;
+                        for (int c = jj + 1; c < kb; ++c) {
+                            row[c] -= mult * pivotRow[c];
+                        }
+                    }
+                });
+            }
+            return pivots;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Default tile size of the block-cyclic layout for decomposeLU: the panel
+     * width, wide enough for the trailing GEMM to run at full speed.
+     */
+    constexpr int defaultLUBlock = 64;
+
+    /**
+     * @brief Performs a distributed LU decomposition with partial pivoting (PA = LU).
+     * * The pivots are chosen as in the sequential decomposeLU, so the factors agree with it
+     * up to rounding.
+     * * @tparam T A floating-point or complex type.
+     * @param A The square matrix to decompose; its tile size is the panel width.
+     * @param lookahead Factor and broadcast each panel during the previous trailing update.
+     * @return An LUResult with the packed factors in A's layout.
+     * @throws std::invalid_argument If the matrix is not square or the grid has several layers.
+     * @throws std::runtime_error If the matrix is singular (zero pivot encountered), on
+     * every process.
+     */
+    template <typename T>
+    LUResult<T> decomposeLU(const CyclicMatrix<T>& A, bool lookahead = true) {
+        static_assert(std::is_floating_point<T>::value || gemm::IsComplex<T>::value,
+                      "Distributed LU decomposition requires floating-point or complex types");
+        const Grid& grid = A.grid();
+        if (A.getRows() != A.getCols()) {
+            throw std::invalid_argument("Error: LU decomposition requires a square matrix.");
+        }
+        if (grid.layers() != 1) {
+            throw std::invalid_argument("Error: Distributed LU decomposition requires a single-layer grid.");
+        }
+        const int n = A.getRows(), nb = A.blockSize();
+        LINEARCPP_TRACE_SCOPE("dist_lu", "distributed", n);
+
+        LUResult<T> result{A, std::vector<int>(n), 1};
+        for (int i = 0; i < n; ++i) {
+            result.P[i] = i;
+        }
+        CyclicMatrix<T>& lu = result.LU;
+        Matrix<T>& a = lu.local();
+        const int rows = a.getRows(), cols = a.getCols();
+        const int blocks = (n + nb - 1) / nb;
+        const MPI_Datatype type = MpiType<T>::get();
+        auto width = [&](int k) { return std::min(nb, n - k * nb); };
+
+        // Factors panel k on its process column and starts its broadcast along the rows.
+        auto launch = [&](int k, detail::LUPanel<T>& panel) {
+            const int j0 = k * nb, kb = width(k), owner = k % grid.cols();
+            const int r0 = lu.localRowsBefore(j0);
+            panel.pivots.assign(kb, -1);
+            panel.l.resize(size_t(rows - r0) * kb);
+            if (grid.col() == owner) {
+                LINEARCPP_TRACE_SCOPE("dist_lu_panel", "distributed", j0);
+                panel.pivots = detail::factorPanel(lu, j0, kb);
+                const int c0 = lu.localColsBefore(j0);
+                for (int i = r0; i < rows; ++i) {
+                    const T* row = a.data() + size_t(i) * cols + c0;
+                    std::copy(row, row + kb, panel.l.data() + size_t(i - r0) * kb);
+                }
+            }
+            MPI_Ibcast(panel.pivots.data(), kb, MPI_INT, owner, grid.rowComm(), &panel.requests[0]);
+            MPI_Ibcast(panel.l.data(), detail::mpiCount(panel.l.size()), type, owner, grid.rowComm(),
+                       &panel.requests[1]);
+        };
+
+        detail::LUPanel<T> panels[2];
+        std::vector<T> buffer, u;
+        if (blocks > 0) {
+            launch(0, panels[0]);
+        }
+        for (int k = 0; k < blocks; ++k) {
+            detail::LUPanel<T>& panel = panels[k % 2];
+            panel.wait();
+            const int j0 = k * nb, kb = width(k), j1 = j0 + kb;
+            for (int jj = 0; jj < kb; ++jj) {
+                if (panel.pivots[jj] < 0) {
+                    throw std::runtime_error("Error: Singular matrix. Null pivot at index " + std::to_string(j0 + jj));
+                }
+            }
+
+            const int c0 = lu.localColsBefore(j0);
+            const bool ownsPanel = grid.col() == k % grid.cols();
+            {
+                LINEARCPP_TRACE_SCOPE("dist_lu_swap", "distributed", j0);
+                for (int jj = 0; jj < kb; ++jj) {
+                    const int j = j0 + jj, p = panel.pivots[jj];
+                    if (p == j) {
+                        continue;
+                    }
+                    std::swap(result.P[j], result.P[p]);
+                    result.toggleSign *= -1;
+                    detail::swapRows(lu, j, p, 0, c0, ownsPanel ? c0 + kb : c0, cols, buffer);
+                }
+            }
+
+            // U12 = L11^-1 * A12 on the process row of the diagonal block, broadcast down
+            // the process columns.
+            const int r0 = lu.localRowsBefore(j0), r1 = lu.localRowsBefore(j1);
+            const int u0 = lu.localColsBefore(j1), trailing = cols - u0;
+            const int ownerRow = k % grid.rows();
+            u.resize(size_t(kb) * trailing);
+            {
+                LINEARCPP_TRACE_SCOPE("dist_lu_trsm", "distributed", j0);
+                if (grid.row() == ownerRow) {
+                    for (int i = 1; i < kb; ++i) {
+                        T* target = a.data() + size_t(r0 + i) * cols;
+                        for (int p = 0; p < i; ++p) {
+                            const T l = panel.l[size_t(i) * kb + p];
+                            const T* source = a.data() + size_t(r0 + p) * cols;
+                            for (int c = u0; c < cols; ++c) {
+                                target[c] -= l * source[c];
+                            }
+                        }
+                    }
+                    for (int i = 0; i < kb; ++i) {
+                        const T* row = a.data() + size_t(r0 + i) * cols + u0;
+                        std::copy(row, row + trailing, u.data() + size_t(i) * trailing);
+                    }
+                }
+                MPI_Bcast(u.data(), detail::mpiCount(u.size()), type, ownerRow, grid.colComm());
+            }
+
+            // A22 -= L21 * U12 over the local columns [begin, end) of the trailing part.
+            const int below = rows - r1;
+            const T* l21 = panel.l.data() + size_t(r1 - r0) * kb;
+            auto update = [&](int begin, int end) {
+                if (below == 0 || end <= begin) {
+                    return;
+                }
+                LINEARCPP_TRACE_SCOPE("dist_lu_update", "distributed", end - begin);
+                gemm::multiplyAdd(below, end - begin, kb, T(-1), l21, kb, u.data() + (begin - u0), trailing,
+                                  a.data() + size_t(r1) * cols + begin, cols);
+            };
+            if (k + 1 == blocks) {
+                update(u0, cols);
+            } else if (!lookahead) {
+                update(u0, cols);
+                launch(k + 1, panels[(k + 1) % 2]);
+            } else if (grid.col() == (k + 1) % grid.cols()) {
+                // Panel k + 1 is this process's first trailing block column.
+                const int next = u0 + width(k + 1);
+                update(u0, next);
+                launch(k + 1, panels[(k + 1) % 2]);
+                update(next, cols);
+            } else {
+                launch(k + 1, panels[(k + 1) % 2]);
+                update(u0, cols);
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Solves the linear system Ax = b using a distributed LU decomposition.
+     * * Forward and backward substitution proceed one diagonal block at a time: the process
+     * row holding the block's rows reduces its products with the solved part of x onto the
+     * process that holds the diagonal block, which solves the small triangular system and
+     * broadcasts the new entries of x.
+     * * @param lu The result of dist::decomposeLU.
+     * @param b The right-hand side vector, identical on every process.
+     * @return The solution x, on every process.
+     * @throws std::invalid_argument If b does not match the matrix size.
+     */
+    template <typename T>
+    std::vector<T> solve(const LUResult<T>& lu, const std::vector<T>& b) {
+        const CyclicMatrix<T>& A = lu.LU;
+        const Grid& grid = A.grid();
+        const int n = A.getRows(), nb = A.blockSize();
+        if (int(b.size()) != n) {
+            throw std::invalid_argument("Error: Right-hand side size does not match the matrix.");
+        }
+        LINEARCPP_TRACE_SCOPE("dist_solve", "distributed", n);
+        const Matrix<T>& a = A.local();
+        const int cols = a.getCols();
+        const MPI_Datatype type = MpiType<T>::get();
+        const int blocks = (n + nb - 1) / nb;
+
+        std::vector<int> globalCol(cols);
+        for (int c = 0; c < cols; ++c) {
+            globalCol[c] = A.globalCol(c);
+        }
+
+        // Apply permutation to the vector b
+        std::vector<T> x(n);
+        for (int i = 0; i < n; ++i) {
+            x[i] = b[lu.P[i]];
+        }
+
+        // Sums row i of block k's local rows over the local columns [begin, end) times x,
+        // reduced along the process row onto the diagonal block's process column.
+        std::vector<T> partial(nb);
+        auto reduce = [&](int k, int begin, int end) {
+            const int j0 = k * nb, kb = std::min(nb, n - j0), owner = k % grid.cols();
+            const int r0 = A.localRowsBefore(j0);
+            for (int i = 0; i < kb; ++i) {
+                const T* row = a.data() + size_t(r0 + i) * cols;
+                T sum = 0;
+                for (int c = begin; c < end; ++c) {
+                    sum += row[c] * x[globalCol[c]];
+                }
+                partial[i] = sum;
+            }
+            if (grid.col() == owner) {
+                MPI_Reduce(MPI_IN_PLACE, partial.data(), kb, type, MPI_SUM, owner, grid.rowComm());
+            } else {
+                MPI_Reduce(partial.data(), nullptr, kb, type, MPI_SUM, owner, grid.rowComm());
+            }
+        };
+
+        // Forward Substitution (Ly = Pb), L unit lower triangular
+        for (int k = 0; k < blocks; ++k) {
+            const int j0 = k * nb, kb = std::min(nb, n - j0);
+            const int ownerRow = k % grid.rows(), ownerCol = k % grid.cols();
+            if (grid.row() == ownerRow) {
+                const int c0 = A.localColsBefore(j0);
+                reduce(k, 0, c0);
+                if (grid.col() == ownerCol) {
+                    const int r0 = A.localRowsBefore(j0);
+                    for (int i = 0; i < kb; ++i) {
+                        T value = x[j0 + i] - partial[i];
+                        for (int p = 0; p < i; ++p) {
+                            value -= a(r0 + i, c0 + p) * x[j0 + p];
+                        }
+                        x[j0 + i] = value;
+                    }
+                }
+            }
+            MPI_Bcast(x.data() + j0, kb, type, ownerRow * grid.cols() + ownerCol, grid.comm());
+        }
+
+        // Backward Substitution (Ux = y)
+        for (int k = blocks - 1; k >= 0; --k) {
+            const int j0 = k * nb, kb = std::min(nb, n - j0);
+            const int ownerRow = k % grid.rows(), ownerCol = k % grid.cols();
+            if (grid.row() == ownerRow) {
+                const int c0 = A.localColsBefore(j0);
+                reduce(k, A.localColsBefore(j0 + kb), cols);
+                if (grid.col() == ownerCol) {
+                    const int r0 = A.localRowsBefore(j0);
+                    for (int i = kb - 1; i >= 0; --i) {
+                        T value = x[j0 + i] - partial[i];
+                        for (int p = i + 1; p < kb; ++p) {
+                            value -= a(r0 + i, c0 + p) * x[j0 + p];
+                        }
+                        x[j0 + i] = value / a(r0 + i, c0 + i);
+                    }
+                }
+            }
+            MPI_Bcast(x.data() + j0, kb, type, ownerRow * grid.cols() + ownerCol, grid.comm());
+        }
+        return x;
+    }
+
+} // namespace dist
+
+#endif // DISTRIBUTED_SOLVER_HPP
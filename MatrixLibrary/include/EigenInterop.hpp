@@ -0,0 +1,229 @@
+#ifndef EIGEN_INTEROP_HPP
+#define EIGEN_INTEROP_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <Eigen/Core>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+
+/**
+ * @brief Zero-copy interoperability between Matrix<T> and Eigen.
+ * * Matrix<T> stores its elements row-major and contiguously, so its storage can be handed to
+ * Eigen as an Eigen::Map of a row-major matrix (optionally a strided block) and Eigen
+ * expressions then read and write the Matrix directly. In the other direction, memory owned
+ * by Eigen is exposed through MatrixView, a non-owning row-major view with a leading
+ * dimension that the library kernels accept without copying.
+ *
+ * Views and maps do not extend the lifetime of the underlying storage, and resizing either
+ * owner invalidates them.
+ */
+namespace interop {
+
+    template <typename T>
+    using RowMajor = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    /**
+     * @brief Eigen map of a row-major block with a leading dimension (outer stride).
+     * * T may be const-qualified for read-only maps.
+     */
+    template <typename T>
+    using StridedMap = Eigen::Map<typename std::conditional<std::is_const<T>::value,
+                                                            const RowMajor<typename std::remove_const<T>::type>,
+                                                            RowMajor<T>>::type,
+                                  Eigen::Unaligned, Eigen::OuterStride<>>;
+
+    /**
+     * @brief Non-owning view of a row-major matrix with leading dimension `stride`.
+     * * Element (i, j) lives at data[i * stride + j]. Use MatrixView<const T> for read-only
+     * access; a MatrixView<T> converts to it implicitly.
+     */
+    template <typename T>
+    class MatrixView {
+        private:
+            T* m_data;
+            int m_rows;
+            int m_cols;
+            int m_stride;
+        public:
+            MatrixView(T* data, int rows, int cols, int stride)
+                : m_data(data), m_rows(rows), m_cols(cols), m_stride(stride) {
+                if (rows < 0 || cols < 0 || stride < cols) {
+                    throw std::invalid_argument("Error: Invalid view dimensions.");
+                }
+            }
+
+            template <typename U = T, typename = typename std::enable_if<std::is_const<U>::value>::type>
+            MatrixView(const MatrixView<typename std::remove_const<T>::type>& other)
+                : m_data(other.data()), m_rows(other.getRows()), m_cols(other.getCols()), m_stride(other.stride()) {}
+
+            int getRows() const { return m_rows; }
+            int getCols() const { return m_cols; }
+            int stride() const { return m_stride; }
+            T* data() const { return m_data; }
+
+            T& operator()(int row, int col) const {
+                return m_data[static_cast<size_t>(row) * m_stride + col];
+            }
+
+            /**
+             * @brief View of the rows x cols block starting at (row, col), sharing the storage.
+             * @throws std::out_of_range If the block exceeds the view.
+             */
+            MatrixView block(int row, int col, int rows, int cols) const {
+                if (row < 0 || col < 0 || rows < 0 || cols < 0 || row + rows > m_rows || col + cols > m_cols) {
+                    throw std::out_of_range("Error: Block exceeds view bounds.");
+                }
+                return MatrixView(m_data + static_cast<size_t>(row) * m_stride + col, rows, cols, m_stride);
+            }
+    };
+
+    /**
+     * @brief Views a Matrix without copying.
+     */
+    template <typename T>
+    MatrixView<T> view(Matrix<T>& M) {
+        return MatrixView<T>(M.data(), M.getRows(), M.getCols(), M.getCols());
+    }
+
+    template <typename T>
+    MatrixView<const T> view(const Matrix<T>& M) {
+        return MatrixView<const T>(M.data(), M.getRows(), M.getCols(), M.getCols());
+    }
+
+    /**
+     * @brief Views Eigen-owned memory (a row-major Matrix, Map or direct-access Block)
+     * without copying.
+     * * Column-major objects are rejected at compile time; see viewTransposed().
+     * @throws std::invalid_argument If the inner stride is not 1.
+     */
+    template <typename Derived>
+    auto view(Eigen::DenseBase<Derived>& x) {
+        static_assert(int(Derived::Flags) & Eigen::DirectAccessBit, "Eigen object must expose its storage.");
+        static_assert(Derived::IsRowMajor || Derived::ColsAtCompileTime == 1,
+                      "Eigen object must be row-major; use viewTransposed for column-major storage.");
+        using Scalar = typename std::remove_reference<decltype(*x.derived().data())>::type;
+        Derived& d = x.derived();
+        if (d.innerStride() != 1) {
+            throw std::invalid_argument("Error: Eigen object must have unit inner stride.");
+        }
+        int stride = Derived::IsRowMajor ? int(d.outerStride()) : 1;
+        return MatrixView<Scalar>(d.data(), int(d.rows()), int(d.cols()), std::max(stride, int(d.cols())));
+    }
+
+    /**
+     * @brief Trait: Derived owns its storage (an Eigen::Matrix or Eigen::Array), so a
+     * temporary of it dies with the full expression and a view of it would dangle.
+     */
+    template <typename Derived>
+    struct IsOwning : std::is_base_of<Eigen::PlainObjectBase<Derived>, Derived> {};
+
+    /**
+     * @brief Writable view of a temporary Eigen expression such as `X.block(...)` or
+     * `X.middleRows(...)`, or of a temporary Map; the owning object must outlive the view.
+     */
+    template <typename Derived, typename = std::enable_if_t<!IsOwning<Derived>::value>>
+    auto view(Eigen::DenseBase<Derived>&& x) {
+        return view(static_cast<Eigen::DenseBase<Derived>&>(x));
+    }
+
+    /**
+     * @brief Temporaries that own their storage cannot be viewed.
+     */
+    template <typename Derived>
+    void view(Eigen::PlainObjectBase<Derived>&& x) = delete;
+
+    template <typename Derived>
+    auto view(const Eigen::DenseBase<Derived>& x) {
+        auto writable = view(const_cast<Eigen::DenseBase<Derived>&>(x));
+        using Scalar = typename std::remove_const<typename std::remove_pointer<decltype(writable.data())>::type>::type;
+        return MatrixView<const Scalar>(writable);
+    }
+
+    /**
+     * @brief Views column-major Eigen memory as the row-major transpose, without copying.
+     * * A column-major m x n matrix X has the same layout as the row-major n x m matrix X^T.
+     * Products can stay in that form: C = A B is computed as C^T = B^T A^T on the views.
+     */
+    template <typename Derived>
+    auto viewTransposed(Eigen::DenseBase<Derived>& x) {
+        static_assert(int(Derived::Flags) & Eigen::DirectAccessBit, "Eigen object must expose its storage.");
+        static_assert(!Derived::IsRowMajor, "Eigen object must be column-major; use view for row-major storage.");
+        using Scalar = typename std::remove_reference<decltype(*x.derived().data())>::type;
+        Derived& d = x.derived();
+        if (d.innerStride() != 1) {
+            throw std::invalid_argument("Error: Eigen object must have unit inner stride.");
+        }
+        return MatrixView<Scalar>(d.data(), int(d.cols()), int(d.rows()), std::max(int(d.outerStride()), int(d.rows())));
+    }
+
+    template <typename Derived>
+    void viewTransposed(Eigen::PlainObjectBase<Derived>&& x) = delete;
+
+    template <typename Derived>
+    auto viewTransposed(const Eigen::DenseBase<Derived>& x) {
+        auto writable = viewTransposed(const_cast<Eigen::DenseBase<Derived>&>(x));
+        using Scalar = typename std::remove_const<typename std::remove_pointer<decltype(writable.data())>::type>::type;
+        return MatrixView<const Scalar>(writable);
+    }
+
+    /**
+     * @brief Exposes a view (and hence a Matrix or a block of it) to Eigen as a strided Map.
+     */
+    template <typename T>
+    StridedMap<T> toEigen(const MatrixView<T>& v) {
+        return StridedMap<T>(v.data(), v.getRows(), v.getCols(), Eigen::OuterStride<>(v.stride()));
+    }
+
+    template <typename T>
+    StridedMap<T> toEigen(Matrix<T>& M) {
+        return toEigen(view(M));
+    }
+
+    template <typename T>
+    StridedMap<const T> toEigen(const Matrix<T>& M) {
+        return toEigen(view(M));
+    }
+
+    /**
+     * @brief Eigen map of the rows x cols block of M starting at (row, col).
+     * @throws std::out_of_range If the block exceeds the matrix.
+     */
+    template <typename T>
+    StridedMap<T> toEigen(Matrix<T>& M, int row, int col, int rows, int cols) {
+        return toEigen(view(M).block(row, col, rows, cols));
+    }
+
+    /**
+     * @brief Copies a view into a new Matrix; the one explicit copy at the boundary.
+     */
+    template <typename T>
+    Matrix<typename std::remove_const<T>::type> toMatrix(const MatrixView<T>& v) {
+        Matrix<typename std::remove_const<T>::type> M(v.getRows(), v.getCols());
+        for (int i = 0; i < v.getRows(); ++i) {
+            std::copy(&v(i, 0), &v(i, 0) + v.getCols(), M.data() + static_cast<size_t>(i) * v.getCols());
+        }
+        return M;
+    }
+
+    /**
+     * @brief C += alpha * A * B with the library GEMM, reading and writing the viewed memory in
+     * place (e.g. Eigen-owned operands and result).
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename TA, typename TB, typename T>
+    void multiplyAdd(const MatrixView<TA>& A, const MatrixView<TB>& B, const MatrixView<T>& C, T alpha = T(1)) {
+        static_assert(std::is_same<typename std::remove_const<TA>::type, T>::value &&
+                      std::is_same<typename std::remove_const<TB>::type, T>::value,
+                      "Operands must have the same element type.");
+        if (A.getCols() != B.getRows() || C.getRows() != A.getRows() || C.getCols() != B.getCols()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        gemm::multiplyAdd(A.getRows(), B.getCols(), A.getCols(), alpha,
+                          A.data(), A.stride(), B.data(), B.stride(), C.data(), C.stride());
+    }
+
+} // namespace interop
+
+#endif // EIGEN_INTEROP_HPP
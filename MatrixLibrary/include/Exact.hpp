@@ -0,0 +1,232 @@
+#ifndef EXACT_HPP
+#define EXACT_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "LinearSolver.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Exact integer and modular matrix arithmetic.
+ * * ModInt<P> is the field GF(P) for a prime P (any modulus works for +, - and *). It plugs into
+ * the existing kernels: the classical and Strassen products are exact over GF(P), and
+ * decomposeLU / solve factor and solve systems exactly, picking any nonzero pivot. The GEMM
+ * micro-kernel accumulates residue products in 64-bit integers and reduces only once every
+ * Accumulator<ModInt<P>>::block steps, instead of after each multiply-add.
+ *
+ * For plain integers, multiplyWide multiplies int32 matrices into int64 results, widening the
+ * operands while they are packed, so products that would wrap around in Matrix<int> are exact.
+ */
+
+namespace detail {
+
+    constexpr bool isPrime(uint32_t n) {
+        if (n < 2) return false;
+        for (uint32_t d = 2; uint64_t(d) * d <= n; ++d) {
+            if (n % d == 0) return false;
+        }
+        return true;
+    }
+
+} // namespace detail
+
+/**
+ * @brief Residue modulo P, stored in [0, P).
+ * * P must be below 2^31 so sums of two residues fit in 32 bits. Division and inverse() require
+ * P to be prime.
+ * @tparam P The modulus.
+ */
+template <uint32_t P>
+class ModInt {
+    static_assert(P >= 2 && P < (1u << 31), "ModInt modulus must be in [2, 2^31).");
+
+    private:
+        uint32_t m_value;
+
+    public:
+        ModInt() : m_value(0) {}
+
+        /**
+         * @brief Reduces any integer, including negative ones, into [0, P).
+         */
+        ModInt(long long value) {
+            long long r = value % static_cast<long long>(P);
+            m_value = static_cast<uint32_t>(r < 0 ? r + P : r);
+        }
+
+        static constexpr uint32_t modulus() { return P; }
+        uint32_t value() const { return m_value; }
+
+        ModInt& operator+=(const ModInt& other) {
+            m_value += other.m_value;
+            if (m_value >= P) m_value -= P;
+            return *this;
+        }
+
+        ModInt& operator-=(const ModInt& other) {
+            m_value += P - other.m_value;
+            if (m_value >= P) m_value -= P;
+            return *this;
+        }
+
+        ModInt& operator*=(const ModInt& other) {
+            m_value = static_cast<uint32_t>(uint64_t(m_value) * other.m_value % P);
+            return *this;
+        }
+
+        ModInt& operator/=(const ModInt& other) {
+            return *this *= other.inverse();
+        }
+
+        ModInt operator-() const {
+            return ModInt() -= *this;
+        }
+
+        ModInt pow(uint64_t exponent) const {
+            ModInt result(1), base = *this;
+            for (; exponent > 0; exponent >>= 1) {
+                if (exponent & 1) result *= base;
+                base *= base;
+            }
+            return result;
+        }
+
+        /**
+         * @brief Multiplicative inverse by Fermat's little theorem.
+         * @throws std::invalid_argument If the value is zero.
+         */
+        ModInt inverse() const {
+            static_assert(detail::isPrime(P), "ModInt division requires a prime modulus.");
+            if (m_value == 0) {
+                throw std::invalid_argument("Error: Zero has no inverse modulo " + std::to_string(P) + ".");
+            }
+            return pow(P - 2);
+        }
+
+        friend ModInt operator+(ModInt a, const ModInt& b) { return a += b; }
+        friend ModInt operator-(ModInt a, const ModInt& b) { return a -= b; }
+        friend ModInt operator*(ModInt a, const ModInt& b) { return a *= b; }
+        friend ModInt operator/(ModInt a, const ModInt& b) { return a /= b; }
+        friend bool operator==(const ModInt& a, const ModInt& b) { return a.m_value == b.m_value; }
+        friend bool operator!=(const ModInt& a, const ModInt& b) { return a.m_value != b.m_value; }
+
+        friend std::ostream& operator<<(std::ostream& os, const ModInt& x) {
+            return os << x.m_value;
+        }
+
+        friend std::istream& operator>>(std::istream& is, ModInt& x) {
+            long long value;
+            if (is >> value) x = ModInt(value);
+            return is;
+        }
+};
+
+namespace gemm {
+
+    /**
+     * @brief Delayed reduction for GF(P): residue products (< 2^62) are summed in 64 bits and
+     * reduced only when the next `block` products could overflow the accumulator.
+     */
+    template <uint32_t P>
+    struct Accumulator<ModInt<P>> {
+        using type = uint64_t;
+        static constexpr uint64_t maxProduct = uint64_t(P - 1) * (P - 1);
+        static constexpr int block = static_cast<int>(
+            std::min<uint64_t>((UINT64_MAX - (P - 1)) / maxProduct, 1u << 30));
+        static type product(const ModInt<P>& a, const ModInt<P>& b) { return uint64_t(a.value()) * b.value(); }
+        static type reduce(type sum) { return sum % P; }
+        static ModInt<P> finish(type sum) { return ModInt<P>(static_cast<long long>(sum % P)); }
+    };
+
+} // namespace gemm
+
+template <uint32_t P>
+struct PivotTraits<ModInt<P>> {
+    static constexpr bool exact = true;
+    static int score(const ModInt<P>& x) { return x.value() != 0; }
+    static bool isNull(const ModInt<P>& x) { return x.value() == 0; }
+};
+
+template <uint32_t P>
+struct FreivaldsTraits<ModInt<P>> {
+    static ModInt<P> sample(std::mt19937_64& rng) { return ModInt<P>(static_cast<long long>(rng() % P)); }
+};
+
+/**
+ * @brief Exact product of int32 matrices with int64 accumulation.
+ * * The operands are widened while the blocked GEMM packs them, so no widened copy of A or B
+ * is stored. The result is exact whenever k * max|A| * max|B| fits in int64, which is checked
+ * up front in O(mk + kn).
+ * @throws std::invalid_argument If the dimensions do not agree.
+ * @throws std::overflow_error If the accumulation could exceed the int64 range.
+ */
+inline Matrix<int64_t> multiplyWide(const Matrix<int32_t>& A, const Matrix<int32_t>& B) {
+    if (A.getCols() != B.getRows()) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+    }
+    auto maxAbs = [](const Matrix<int32_t>& M) {
+        uint64_t result = 0;
+        const int32_t* data = M.data();
+        for (size_t i = 0, size = size_t(M.getRows()) * M.getCols(); i < size; ++i) {
+            result = std::max(result, uint64_t(std::llabs(data[i])));
+        }
+        return result;
+    };
+    const uint64_t bound = maxAbs(A) * maxAbs(B);
+    if (bound > 0 && uint64_t(A.getCols()) > uint64_t(INT64_MAX) / bound) {
+        throw std::overflow_error("Error: int64 accumulation may overflow for inner dimension " +
+                                  std::to_string(A.getCols()) + ".");
+    }
+    LINEARCPP_TRACE_SCOPE("multiplyWide", "product", A.getRows());
+    Matrix<int64_t> C(A.getRows(), B.getCols());
+    gemm::multiplyAdd<int64_t, int32_t>(A.getRows(), B.getCols(), A.getCols(), 1,
+                                        A.data(), A.getCols(), B.data(), B.getCols(), C.data(), C.getCols());
+    return C;
+}
+
+/**
+ * @brief Rank of a matrix over GF(P) by Gaussian elimination, for any shape.
+ * * Works column by column on a copy, eliminating below each nonzero pivot; the rows below a
+ * pivot are updated in parallel. O(rows * cols * rank).
+ */
+template <uint32_t P>
+int rank(const Matrix<ModInt<P>>& A) {
+    LINEARCPP_TRACE_SCOPE("rank", "solver", A.getRows());
+    Matrix<ModInt<P>> M = A;
+    const int rows = M.getRows(), cols = M.getCols();
+    int r = 0;
+    for (int c = 0; c < cols && r < rows; ++c) {
+        int pivot = r;
+        while (pivot < rows && M(pivot, c) == ModInt<P>(0)) ++pivot;
+        if (pivot == rows) continue;
+        if (pivot != r) {
+            for (int j = c; j < cols; ++j) std::swap(M(r, j), M(pivot, j));
+        }
+        const ModInt<P> inv = M(r, c).inverse();
+        int grain = parallel::grainFor(2LL * (cols - c));
+        parallel::parallelFor(r + 1, rows, grain, [&](int rowBegin, int rowEnd) {
+            for (int i = rowBegin; i < rowEnd; ++i) {
+                ModInt<P> mult = M(i, c) * inv;
+                if (mult == ModInt<P>(0)) continue;
+                for (int j = c; j < cols; ++j) {
+                    M(i, j) -= mult * M(r, j);
+                }
+            }
+        });
+        ++r;
+    }
+    return r;
+}
+
+#endif // EXACT_HPP
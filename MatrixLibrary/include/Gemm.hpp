@@ -0,0 +1,505 @@
+#ifndef GEMM_HPP
+#define GEMM_HPP
+
+#include <algorithm>
+#include <complex>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "Blas.hpp"
+#include "Context.hpp"
+#include "Instantiations.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+#include "Traits.hpp"
+#include "Tuning.hpp"
+
+/**
+ * @brief Cache-blocked, packed general matrix multiply on row-major storage.
+ * * The loop structure follows the Goto/BLIS design:
+ *   for each NC-wide column panel of B      (kept in L3)
+ *     for each KC-deep slice of the shared dimension
+ *       pack B(KC x NC) into NR-wide slivers
+ *       for each MC-high row block of A    (kept in L2, blocks run in parallel)
+ *         pack A(MC x KC) into MR-high slivers
+ *         run the MR x NR micro-kernel over all sliver pairs (accumulators in registers)
+ * Packing makes the micro-kernel read both operands with unit stride and pads partial
+ * slivers with zeros, so edge tiles run the same kernel and only the store is masked.
+ * MC, KC and NC come from the active tuning profile (see Tuning.hpp). When an external
+ * BLAS is active for the element type (see Blas.hpp), multiplyAdd forwards to it instead.
+ * semiringMultiplyAdd runs the same blocking with the (plus, times) of another semiring
+ * (see Semiring.hpp).
+ */
+namespace gemm {
+
+    constexpr int MR = 4; //< Rows of the register tile.
+    constexpr int NR = 8; //< Columns of the register tile.
+
+    /**
+     * @brief Accumulation policy of the micro-kernel for element type T.
+     * * The default accumulates products in T itself. Specializations may use a wider `type`
+     * (e.g. 64-bit sums of modular residues) and delay normalization: the kernel calls
+     * reduce() after every `block` products (0 means never) and finish() once per tile.
+     */
+    template <typename T, typename = void>
+    struct Accumulator {
+        using type = T;
+        static constexpr int block = 0;
+        static type product(const T& a, const T& b) { return a * b; }
+        static type reduce(const type& sum) { return sum; }
+        static T finish(const type& sum) { return sum; }
+    };
+
+    /**
+     * @brief Packs an mc x kc block of A into MR-row slivers, each stored column by column.
+     * * The source element type S is converted to T while packing, so operands can be
+     * widened (e.g. int32 to int64) without a separate conversion pass. Partial slivers are
+     * padded with `pad`, the additive identity of the semiring in use.
+     */
+    template <typename T, typename S>
+    void packA(int mc, int kc, const S* A, int lda, T* buffer, T pad = T(0)) {
+        for (int i0 = 0; i0 < mc; i0 += MR) {
+            int rows = std::min(MR, mc - i0);
+            for (int p = 0; p < kc; ++p) {
+                for (int i = 0; i < rows; ++i) {
+                    buffer[p * MR + i] = static_cast<T>(A[(i0 + i) * lda + p]);
+                }
+                for (int i = rows; i < MR; ++i) {
+                    buffer[p * MR + i] = pad;
+                }
+            }
+            buffer += MR * kc;
+        }
+    }
+
+    /**
+     * @brief Packs a kc x nc panel of B into NR-column slivers, each stored row by row.
+     */
+    template <typename T, typename S>
+    void packB(int kc, int nc, const S* B, int ldb, T* buffer, T pad = T(0)) {
+        for (int j0 = 0; j0 < nc; j0 += NR) {
+            int cols = std::min(NR, nc - j0);
+            for (int p = 0; p < kc; ++p) {
+                const S* row = B + p * ldb + j0;
+                for (int j = 0; j < cols; ++j) {
+                    buffer[p * NR + j] = static_cast<T>(row[j]);
+                }
+                for (int j = cols; j < NR; ++j) {
+                    buffer[p * NR + j] = pad;
+                }
+            }
+            buffer += NR * kc;
+        }
+    }
+
+    /**
+     * @brief C(mr x nr) += alpha * a * b for one packed A sliver and one packed B sliver.
+     * * The accumulator tile is a fixed-size local array so the compiler keeps it in
+     * registers and vectorizes the NR loop. Sums follow the Accumulator policy of T.
+     */
+    template <typename T>
+    void microKernel(int kc, const T* a, const T* b, T alpha, T* C, int ldc, int mr, int nr) {
+        using Acc = Accumulator<T>;
+        typename Acc::type acc[MR][NR];
+        for (int i = 0; i < MR; ++i) {
+            for (int j = 0; j < NR; ++j) {
+                acc[i][j] = typename Acc::type(0);
+            }
+        }
+        const int block = Acc::block > 0 ? Acc::block : kc;
+        for (int p0 = 0; p0 < kc; p0 += block) {
+            const int pEnd = std::min(kc, p0 + block);
+            for (int p = p0; p < pEnd; ++p) {
+                for (int i = 0; i < MR; ++i) {
+                    T ai = a[p * MR + i];
+                    for (int j = 0; j < NR; ++j) {
+                        acc[i][j] += Acc::product(ai, b[p * NR + j]);
+                    }
+                }
+            }
+            if constexpr (Acc::block > 0) {
+                for (int i = 0; i < MR; ++i) {
+                    for (int j = 0; j < NR; ++j) {
+                        acc[i][j] = Acc::reduce(acc[i][j]);
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < mr; ++i) {
+            for (int j = 0; j < nr; ++j) {
+                C[i * ldc + j] += alpha * Acc::finish(acc[i][j]);
+            }
+        }
+    }
+
+    /**
+     * @brief Complex C(mr x nr) += alpha * a * b on interleaved (re, im) slivers, 4M style.
+     * * A complex multiply-add is four real ones. Each packed B row is read as 2 * NR reals and
+     * scaled by the real and the imaginary part of the A entry into two real accumulator
+     * tiles, so the inner loop is the same broadcast-and-FMA stream as the real kernel; the
+     * real and imaginary sums are only combined at the store:
+     *   re(C) = re(a) re(b) - im(a) im(b),  im(C) = re(a) im(b) + im(a) re(b).
+     */
+    template <typename R>
+    void complexMicroKernel(int kc, const std::complex<R>* a, const std::complex<R>* b,
+                            std::complex<R> alpha, std::complex<R>* C, int ldc, int mr, int nr) {
+        const R* ar = reinterpret_cast<const R*>(a);
+        const R* br = reinterpret_cast<const R*>(b);
+        R byRe[MR][2 * NR];
+        R byIm[MR][2 * NR];
+        for (int i = 0; i < MR; ++i) {
+            for (int q = 0; q < 2 * NR; ++q) {
+                byRe[i][q] = R(0);
+                byIm[i][q] = R(0);
+            }
+        }
+        for (int p = 0; p < kc; ++p) {
+            const R* row = br + 2 * NR * p;
+            for (int i = 0; i < MR; ++i) {
+                const R re = ar[2 * (p * MR + i)];
+                const R im = ar[2 * (p * MR + i) + 1];
+                for (int q = 0; q < 2 * NR; ++q) {
+                    byRe[i][q] += re * row[q];
+                    byIm[i][q] += im * row[q];
+                }
+            }
+        }
+        for (int i = 0; i < mr; ++i) {
+            for (int j = 0; j < nr; ++j) {
+                std::complex<R> sum(byRe[i][2 * j] - byIm[i][2 * j + 1], byRe[i][2 * j + 1] + byIm[i][2 * j]);
+                C[i * ldc + j] += alpha * sum;
+            }
+        }
+    }
+
+    namespace detail {
+
+#if defined(__AVX512F__)
+        constexpr int simdBytes = 64;
+#elif defined(__AVX__)
+        constexpr int simdBytes = 32;
+#else
+        constexpr int simdBytes = 16;
+#endif
+
+        /**
+         * @brief True if SR declares `vectorizable = true`, i.e. its plus and times are
+         * templates that also accept GCC/Clang vector types.
+         */
+        template <typename SR, typename = void>
+        struct IsVectorizable : std::false_type {};
+
+        template <typename SR>
+        struct IsVectorizable<SR, typename std::enable_if<SR::vectorizable>::type> : std::true_type {};
+
+    } // namespace detail
+
+    /**
+     * @brief C(mr x nr) = C plus (a times b) in the semiring SR, for one pair of packed slivers.
+     * * Same register tile as microKernel. Unlike +, min and max are associative, so the
+     * auto-vectorizer would rather turn the kc loop into 32 reductions than vectorize the
+     * NR loop; for vectorizable semirings each tile row is therefore held in explicit
+     * vector registers (GCC/Clang vector extensions, as wide as the target ISA allows).
+     */
+    template <typename SR, typename T>
+    void semiringKernel(int kc, const T* a, const T* b, T* C, int ldc, int mr, int nr) {
+        T acc[MR][NR];
+#if defined(__GNUC__)
+        if constexpr (detail::IsVectorizable<SR>::value) {
+            constexpr int width = std::min<int>(detail::simdBytes, NR * sizeof(T));
+            constexpr int lanes = width / sizeof(T);
+            constexpr int NV = NR / lanes;
+            typedef T Vec __attribute__((vector_size(width)));
+            Vec zero;
+            for (int l = 0; l < lanes; ++l) {
+                zero[l] = SR::zero();
+            }
+            Vec vacc[MR][NV];
+            for (int i = 0; i < MR; ++i) {
+                for (int v = 0; v < NV; ++v) {
+                    vacc[i][v] = zero;
+                }
+            }
+            for (int p = 0; p < kc; ++p) {
+                Vec bv[NV];
+                std::memcpy(bv, b + p * NR, sizeof(bv));
+                for (int i = 0; i < MR; ++i) {
+                    Vec ai = zero;
+                    for (int l = 0; l < lanes; ++l) {
+                        ai[l] = a[p * MR + i];
+                    }
+                    for (int v = 0; v < NV; ++v) {
+                        vacc[i][v] = SR::plus(vacc[i][v], SR::times(ai, bv[v]));
+                    }
+                }
+            }
+            std::memcpy(acc, vacc, sizeof(acc));
+        } else
+#endif
+        {
+            for (int i = 0; i < MR; ++i) {
+                for (int j = 0; j < NR; ++j) {
+                    acc[i][j] = SR::zero();
+                }
+            }
+            for (int p = 0; p < kc; ++p) {
+                for (int i = 0; i < MR; ++i) {
+                    T ai = a[p * MR + i];
+                    for (int j = 0; j < NR; ++j) {
+                        acc[i][j] = SR::plus(acc[i][j], SR::times(ai, b[p * NR + j]));
+                    }
+                }
+            }
+        }
+        for (int i = 0; i < mr; ++i) {
+            for (int j = 0; j < nr; ++j) {
+                C[i * ldc + j] = SR::plus(C[i * ldc + j], acc[i][j]);
+            }
+        }
+    }
+
+    namespace detail {
+
+        /**
+         * @brief The NC / KC / MC loop nest. packB(pc, jc, kc, nc, buffer) and
+         * packA(ic, pc, mc, kc, buffer) fill the packed panels, and tile(kc, aSliver, bSliver,
+         * row, col, mr, nr) consumes one MR x NR tile of C at (row, col).
+         */
+        template <typename T, typename PackA, typename PackB, typename Tile>
+        void blockedWith(int m, int n, int k, const PackA& packA, const PackB& packB, const Tile& tile) {
+            const tuning::Profile &profile = tuning::profile();
+            const int MC = std::max(MR, profile.gemmMC / MR * MR);
+            const int KC = std::max(1, profile.gemmKC);
+            const int NC = std::max(NR, profile.gemmNC / NR * NR);
+
+            std::vector<T> packedB(size_t(KC) * ((std::min(NC, n) + NR - 1) / NR * NR));
+            int blocksM = (m + MC - 1) / MC;
+            // Panels report progress; every MC-row block is a checkpoint of the execution context.
+            exec::Stage stage("gemm", double((n + NC - 1) / NC) * ((k + KC - 1) / KC));
+
+            for (int jc = 0; jc < n; jc += NC) {
+                int nc = std::min(NC, n - jc);
+                for (int pc = 0; pc < k; pc += KC) {
+                    int kc = std::min(KC, k - pc);
+                    packB(pc, jc, kc, nc, packedB.data());
+
+                    // Row blocks of C are disjoint: each task packs its own A block.
+                    int grain = parallel::grainFor(2LL * MC * kc * nc);
+                    parallel::parallelFor(0, blocksM, grain, [&](int firstBlock, int lastBlock) {
+                        thread_local std::vector<T> packedA;
+                        packedA.resize(size_t(MC) * kc + MR * kc);
+                        for (int block = firstBlock; block < lastBlock; ++block) {
+                            LINEARCPP_TRACE_SCOPE("gemm_tile", "kernel", block);
+                            exec::checkpoint();
+                            int ic = block * MC;
+                            int mc = std::min(MC, m - ic);
+                            packA(ic, pc, mc, kc, packedA.data());
+                            for (int jr = 0; jr < nc; jr += NR) {
+                                int nr = std::min(NR, nc - jr);
+                                const T* b = packedB.data() + size_t(jr) * kc;
+                                for (int ir = 0; ir < mc; ir += MR) {
+                                    int mr = std::min(MR, mc - ir);
+                                    tile(kc, packedA.data() + size_t(ir) * kc, b, ic + ir, jc + jr, mr, nr);
+                                }
+                            }
+                        }
+                    });
+                    stage.advance();
+                }
+            }
+        }
+
+        // The micro-kernel for T: 4M for complex types, the generic one otherwise.
+        template <typename T>
+        void multiplyTile(int kc, const T* a, const T* b, T alpha, T* C, int ldc, int mr, int nr) {
+            if constexpr (IsComplex<T>::value) {
+                complexMicroKernel(kc, a, b, alpha, C, ldc, mr, nr);
+            } else {
+                microKernel(kc, a, b, alpha, C, ldc, mr, nr);
+            }
+        }
+
+        /**
+         * @brief blockedWith on plain operands: packs A and B (padding with `pad`) and calls
+         * kernel(kc, aSliver, bSliver, cTile, ldc, mr, nr) per tile.
+         */
+        template <typename T, typename S, typename Kernel>
+        void blocked(int m, int n, int k, const S* A, int lda, const S* B, int ldb, T* C, int ldc,
+                     T pad, const Kernel& kernel) {
+            blockedWith<T>(m, n, k,
+                [&](int ic, int pc, int mc, int kc, T* buffer) { packA(mc, kc, A + ic * lda + pc, lda, buffer, pad); },
+                [&](int pc, int jc, int kc, int nc, T* buffer) { packB(kc, nc, B + pc * ldb + jc, ldb, buffer, pad); },
+                [&](int kc, const T* a, const T* b, int row, int col, int mr, int nr) {
+                    kernel(kc, a, b, C + row * ldc + col, ldc, mr, nr);
+                });
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Computes C += alpha * A * B for row-major operands with leading dimensions.
+     * @param m Rows of A and C.
+     * @param n Columns of B and C.
+     * @param k Columns of A and rows of B.
+     * @note A and B may have an element type S other than T; they are converted to T while
+     * packing (see multiplyWide in Exact.hpp).
+     */
+    template <typename T, typename S = T>
+    void multiplyAdd(int m, int n, int k, T alpha, const S* A, int lda, const S* B, int ldb, T* C, int ldc) {
+        if (m == 0 || n == 0 || k == 0) return;
+        if constexpr (std::is_same<S, T>::value) {
+            if (blas::active<T>()) {
+                blas::gemm(m, n, k, alpha, A, lda, B, ldb, C, ldc);
+                return;
+            }
+        }
+        detail::blocked(m, n, k, A, lda, B, ldb, C, ldc, T(0),
+                        [alpha](int kc, const T* a, const T* b, T* c, int ldc, int mr, int nr) {
+                            detail::multiplyTile(kc, a, b, alpha, c, ldc, mr, nr);
+                        });
+    }
+
+    constexpr int maxFusedTerms = 4; //< Terms per combination in a fused product (two Strassen levels).
+
+    /**
+     * @brief A linear combination sum_t coefficient[t] * block[t] of equally shaped blocks
+     * that share one leading dimension, e.g. A11 + A22 or the C quadrants a Strassen
+     * product is added to.
+     */
+    template <typename P, typename T>
+    struct Combination {
+        P block[maxFusedTerms];
+        T coefficient[maxFusedTerms];
+        int count = 0;
+
+        void add(P data, T scale) {
+            block[count] = data;
+            coefficient[count] = scale;
+            ++count;
+        }
+    };
+
+    /**
+     * @brief packA of the sum of an mc x kc block taken at `offset` in every term of A.
+     */
+    template <typename T>
+    void packACombination(int mc, int kc, const Combination<const T*, T>& A, size_t offset, int lda, T* buffer) {
+        if (A.count == 1 && A.coefficient[0] == T(1)) {
+            packA(mc, kc, A.block[0] + offset, lda, buffer);
+            return;
+        }
+        for (int i0 = 0; i0 < mc; i0 += MR) {
+            int rows = std::min(MR, mc - i0);
+            for (int p = 0; p < kc; ++p) {
+                for (int i = 0; i < rows; ++i) {
+                    const size_t at = offset + size_t(i0 + i) * lda + p;
+                    T sum = A.coefficient[0] * A.block[0][at];
+                    for (int t = 1; t < A.count; ++t) {
+                        sum += A.coefficient[t] * A.block[t][at];
+                    }
+                    buffer[p * MR + i] = sum;
+                }
+                for (int i = rows; i < MR; ++i) {
+                    buffer[p * MR + i] = T(0);
+                }
+            }
+            buffer += MR * kc;
+        }
+    }
+
+    /**
+     * @brief packB of the sum of a kc x nc panel taken at `offset` in every term of B.
+     */
+    template <typename T>
+    void packBCombination(int kc, int nc, const Combination<const T*, T>& B, size_t offset, int ldb, T* buffer) {
+        if (B.count == 1 && B.coefficient[0] == T(1)) {
+            packB(kc, nc, B.block[0] + offset, ldb, buffer);
+            return;
+        }
+        for (int j0 = 0; j0 < nc; j0 += NR) {
+            int cols = std::min(NR, nc - j0);
+            for (int p = 0; p < kc; ++p) {
+                const size_t at = offset + size_t(p) * ldb + j0;
+                for (int j = 0; j < cols; ++j) {
+                    T sum = B.coefficient[0] * B.block[0][at + j];
+                    for (int t = 1; t < B.count; ++t) {
+                        sum += B.coefficient[t] * B.block[t][at + j];
+                    }
+                    buffer[p * NR + j] = sum;
+                }
+                for (int j = cols; j < NR; ++j) {
+                    buffer[p * NR + j] = T(0);
+                }
+            }
+            buffer += NR * kc;
+        }
+    }
+
+    /**
+     * @brief C_j += alpha * gamma_j * (sum_a alpha_a A_a) (sum_b beta_b B_b) for every term
+     * C_j of C, with no temporaries.
+     * * The sums of A and B blocks are formed while packing, and each micro-kernel tile is
+     * added to every output block in the epilogue, so one Strassen product costs one GEMM
+     * pass and no extra memory (the "ABC" variant of Huang, Smith, Henry and van de Geijn,
+     * "Strassen's Algorithm Reloaded", SC16). All blocks are m x k, k x n and m x n with
+     * leading dimensions lda, ldb and ldc. Always runs the built-in kernel.
+     */
+    template <typename T>
+    void multiplyAddFused(int m, int n, int k, T alpha, const Combination<const T*, T>& A, int lda,
+                          const Combination<const T*, T>& B, int ldb, const Combination<T*, T>& C, int ldc) {
+        if (m == 0 || n == 0 || k == 0 || A.count == 0 || B.count == 0 || C.count == 0) return;
+        detail::blockedWith<T>(m, n, k,
+            [&](int ic, int pc, int mc, int kc, T* buffer) {
+                packACombination(mc, kc, A, size_t(ic) * lda + pc, lda, buffer);
+            },
+            [&](int pc, int jc, int kc, int nc, T* buffer) {
+                packBCombination(kc, nc, B, size_t(pc) * ldb + jc, ldb, buffer);
+            },
+            [&](int kc, const T* a, const T* b, int row, int col, int mr, int nr) {
+                const size_t at = size_t(row) * ldc + col;
+                if (C.count == 1) {
+                    detail::multiplyTile(kc, a, b, alpha * C.coefficient[0], C.block[0] + at, ldc, mr, nr);
+                    return;
+                }
+                T tile[MR * NR] = {};
+                detail::multiplyTile(kc, a, b, T(1), tile, NR, mr, nr);
+                for (int t = 0; t < C.count; ++t) {
+                    const T scale = alpha * C.coefficient[t];
+                    for (int i = 0; i < mr; ++i) {
+                        T* out = C.block[t] + at + size_t(i) * ldc;
+                        for (int j = 0; j < nr; ++j) {
+                            out[j] += scale * tile[i * NR + j];
+                        }
+                    }
+                }
+            });
+    }
+
+    /**
+     * @brief Computes C = C plus (A times B) over the semiring SR for row-major operands.
+     * * SR provides static zero(), plus(a, b) and times(a, b) on its value_type; e.g. with
+     * semiring::MinPlus, C(i, j) = min(C(i, j), min_p A(i, p) + B(p, j)).
+     * @param m Rows of A and C.
+     * @param n Columns of B and C.
+     * @param k Columns of A and rows of B.
+     */
+    template <typename SR, typename T>
+    void semiringMultiplyAdd(int m, int n, int k, const T* A, int lda, const T* B, int ldb, T* C, int ldc) {
+        static_assert(std::is_same<typename SR::value_type, T>::value, "Semiring and element type must agree.");
+        if (m == 0 || n == 0 || k == 0) return;
+        detail::blocked(m, n, k, A, lda, B, ldb, C, ldc, SR::zero(),
+                        [](int kc, const T* a, const T* b, T* c, int ldc, int mr, int nr) {
+                            semiringKernel<SR>(kc, a, b, c, ldc, mr, nr);
+                        });
+    }
+
+} // namespace gemm
+
+#ifdef LINEARCPP_TEMPLATE
+#define LINEARCPP_GEMM_INSTANCE(T) \
+    LINEARCPP_TEMPLATE void gemm::multiplyAdd<T>(int, int, int, T, const T*, int, const T*, int, T*, int);
+LINEARCPP_ELEMENT_TYPES(LINEARCPP_GEMM_INSTANCE)
+#undef LINEARCPP_GEMM_INSTANCE
+#endif
+
+#endif // GEMM_HPP
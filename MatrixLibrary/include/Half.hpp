@@ -0,0 +1,356 @@
+#ifndef HALF_HPP
+#define HALF_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief 16-bit floating-point element types for Matrix<T>.
+ * * bfloat16 keeps the 8-bit exponent of float with a 7-bit mantissa; float16 is IEEE binary16
+ * (5-bit exponent, 10-bit mantissa). Both are storage formats: arithmetic converts to float,
+ * and every store rounds to nearest-even. float16 conversions use F16C when the compiler
+ * targets it (e.g. -mf16c or -march=native), with an exact software fallback otherwise.
+ *
+ * Matrix<bfloat16> and Matrix<float16> halve the memory and bandwidth of a float matrix. Their
+ * products convert panels to float while the blocked GEMM packs them and accumulate in float,
+ * rounding once per output entry; multiplyFloat keeps the float result. solveRefined
+ * (LinearSolver.hpp) solves systems stored in either format to double accuracy.
+ */
+
+namespace detail {
+
+    inline float bitsToFloat(uint32_t bits) {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t floatToBits(float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline float bfloat16ToFloat(uint16_t bits) {
+        return bitsToFloat(uint32_t(bits) << 16);
+    }
+
+    inline uint16_t floatToBfloat16(float value) {
+        uint32_t bits = floatToBits(value);
+        if ((bits & 0x7fffffffu) > 0x7f800000u) {
+            return static_cast<uint16_t>((bits >> 16) | 0x0040u); // keep NaN quiet
+        }
+        bits += 0x7fffu + ((bits >> 16) & 1u);
+        return static_cast<uint16_t>(bits >> 16);
+    }
+
+    inline float float16ToFloat(uint16_t bits) {
+#if defined(__F16C__)
+        return _cvtsh_ss(bits);
+#else
+        const uint32_t shiftedExponent = 0x7c00u << 13;
+        uint32_t out = uint32_t(bits & 0x7fffu) << 13;
+        const uint32_t exponent = out & shiftedExponent;
+        out += uint32_t(127 - 15) << 23;
+        if (exponent == shiftedExponent) {
+            out += uint32_t(128 - 16) << 23; // Inf / NaN
+        } else if (exponent == 0) {
+            out += 1u << 23; // subnormal: renormalize through a float subtraction
+            out = floatToBits(bitsToFloat(out) - bitsToFloat(113u << 23));
+        }
+        return bitsToFloat(out | (uint32_t(bits & 0x8000u) << 16));
+#endif
+    }
+
+    inline uint16_t floatToFloat16(float value) {
+#if defined(__F16C__)
+        return static_cast<uint16_t>(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT));
+#else
+        uint32_t bits = floatToBits(value);
+        const uint32_t sign = bits & 0x80000000u;
+        bits ^= sign;
+        uint32_t out;
+        if (bits >= (127u + 16u) << 23) {
+            out = bits > 0x7f800000u ? 0x7e00u : 0x7c00u; // NaN, or Inf / overflow
+        } else if (bits < 113u << 23) {
+            // Subnormal or zero: adding the magic constant rounds the mantissa into place.
+            const uint32_t magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+            out = floatToBits(bitsToFloat(bits) + bitsToFloat(magic)) - magic;
+        } else {
+            const uint32_t mantissaOdd = (bits >> 13) & 1u;
+            bits += (uint32_t(15 - 127) << 23) + 0xfffu + mantissaOdd;
+            out = bits >> 13;
+        }
+        return static_cast<uint16_t>(out | (sign >> 16));
+#endif
+    }
+
+} // namespace detail
+
+/**
+ * @brief Brain floating point: float with the mantissa rounded to 7 bits.
+ */
+class bfloat16 {
+    private:
+        uint16_t m_bits;
+
+    public:
+        bfloat16() : m_bits(0) {}
+
+        template <typename U, typename = std::enable_if_t<std::is_arithmetic<U>::value>>
+        bfloat16(U value) : m_bits(detail::floatToBfloat16(static_cast<float>(value))) {}
+
+        static bfloat16 fromBits(uint16_t bits) {
+            bfloat16 result;
+            result.m_bits = bits;
+            return result;
+        }
+
+        uint16_t bits() const { return m_bits; }
+        operator float() const { return detail::bfloat16ToFloat(m_bits); }
+
+        bfloat16& operator+=(float other) { return *this = float(*this) + other; }
+        bfloat16& operator-=(float other) { return *this = float(*this) - other; }
+        bfloat16& operator*=(float other) { return *this = float(*this) * other; }
+        bfloat16& operator/=(float other) { return *this = float(*this) / other; }
+
+        friend std::ostream& operator<<(std::ostream& os, const bfloat16& x) {
+            return os << float(x);
+        }
+
+        friend std::istream& operator>>(std::istream& is, bfloat16& x) {
+            float value;
+            if (is >> value) x = value;
+            return is;
+        }
+};
+
+/**
+ * @brief IEEE 754 binary16 half precision.
+ */
+class float16 {
+    private:
+        uint16_t m_bits;
+
+    public:
+        float16() : m_bits(0) {}
+
+        template <typename U, typename = std::enable_if_t<std::is_arithmetic<U>::value>>
+        float16(U value) : m_bits(detail::floatToFloat16(static_cast<float>(value))) {}
+
+        static float16 fromBits(uint16_t bits) {
+            float16 result;
+            result.m_bits = bits;
+            return result;
+        }
+
+        uint16_t bits() const { return m_bits; }
+        operator float() const { return detail::float16ToFloat(m_bits); }
+
+        float16& operator+=(float other) { return *this = float(*this) + other; }
+        float16& operator-=(float other) { return *this = float(*this) - other; }
+        float16& operator*=(float other) { return *this = float(*this) * other; }
+        float16& operator/=(float other) { return *this = float(*this) / other; }
+
+        friend std::ostream& operator<<(std::ostream& os, const float16& x) {
+            return os << float(x);
+        }
+
+        friend std::istream& operator>>(std::istream& is, float16& x) {
+            float value;
+            if (is >> value) x = value;
+            return is;
+        }
+};
+
+namespace std {
+
+    template <>
+    class numeric_limits<bfloat16> {
+        public:
+            static constexpr bool is_specialized = true;
+            static constexpr bool is_signed = true;
+            static constexpr bool is_integer = false;
+            static constexpr bool is_exact = false;
+            static constexpr bool has_infinity = true;
+            static constexpr bool has_quiet_NaN = true;
+            static constexpr int digits = 8;
+            static constexpr int radix = 2;
+            static bfloat16 min() { return bfloat16::fromBits(0x0080); }
+            static bfloat16 max() { return bfloat16::fromBits(0x7f7f); }
+            static bfloat16 lowest() { return bfloat16::fromBits(0xff7f); }
+            static bfloat16 epsilon() { return bfloat16::fromBits(0x3c00); }
+            static bfloat16 infinity() { return bfloat16::fromBits(0x7f80); }
+            static bfloat16 quiet_NaN() { return bfloat16::fromBits(0x7fc0); }
+    };
+
+    template <>
+    class numeric_limits<float16> {
+        public:
+            static constexpr bool is_specialized = true;
+            static constexpr bool is_signed = true;
+            static constexpr bool is_integer = false;
+            static constexpr bool is_exact = false;
+            static constexpr bool has_infinity = true;
+            static constexpr bool has_quiet_NaN = true;
+            static constexpr int digits = 11;
+            static constexpr int radix = 2;
+            static float16 min() { return float16::fromBits(0x0400); }
+            static float16 max() { return float16::fromBits(0x7bff); }
+            static float16 lowest() { return float16::fromBits(0xfbff); }
+            static float16 epsilon() { return float16::fromBits(0x1400); }
+            static float16 infinity() { return float16::fromBits(0x7c00); }
+            static float16 quiet_NaN() { return float16::fromBits(0x7e00); }
+    };
+
+} // namespace std
+
+namespace gemm {
+
+    /**
+     * @brief 16-bit types accumulate their products in float and round once at the end.
+     */
+    template <typename H>
+    struct Accumulator<H, std::enable_if_t<std::is_same<H, bfloat16>::value || std::is_same<H, float16>::value>> {
+        using type = float;
+        static constexpr int block = 0;
+        static type product(const H& a, const H& b) { return float(a) * float(b); }
+        static type reduce(type sum) { return sum; }
+        static H finish(type sum) { return H(sum); }
+    };
+
+} // namespace gemm
+
+namespace half {
+
+    /**
+     * @brief Converts `count` bfloat16 values to float.
+     */
+    inline void toFloat(const bfloat16* src, float* dst, size_t count) {
+        const uint16_t* bits = reinterpret_cast<const uint16_t*>(src);
+        for (size_t i = 0; i < count; ++i) {
+            dst[i] = detail::bitsToFloat(uint32_t(bits[i]) << 16);
+        }
+    }
+
+    /**
+     * @brief Converts `count` floats to bfloat16 with round-to-nearest-even.
+     */
+    inline void fromFloat(const float* src, bfloat16* dst, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            dst[i] = bfloat16(src[i]);
+        }
+    }
+
+    /**
+     * @brief Converts `count` float16 values to float, eight per instruction with F16C.
+     */
+    inline void toFloat(const float16* src, float* dst, size_t count) {
+        size_t i = 0;
+#if defined(__F16C__)
+        for (; i + 8 <= count; i += 8) {
+            __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(packed));
+        }
+#endif
+        for (; i < count; ++i) {
+            dst[i] = float(src[i]);
+        }
+    }
+
+    /**
+     * @brief Converts `count` floats to float16 with round-to-nearest-even, eight per
+     * instruction with F16C.
+     */
+    inline void fromFloat(const float* src, float16* dst, size_t count) {
+        size_t i = 0;
+#if defined(__F16C__)
+        for (; i + 8 <= count; i += 8) {
+            __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+        }
+#endif
+        for (; i < count; ++i) {
+            dst[i] = float16(src[i]);
+        }
+    }
+
+    /**
+     * @brief Widens a 16-bit matrix to float.
+     */
+    template <typename H>
+    Matrix<float> toFloat(const Matrix<H>& M) {
+        Matrix<float> result(M.getRows(), M.getCols());
+        const int cols = M.getCols();
+        parallel::parallelFor(0, M.getRows(), parallel::grainFor(cols), [&](int rowBegin, int rowEnd) {
+            toFloat(M.data() + size_t(rowBegin) * cols, result.data() + size_t(rowBegin) * cols,
+                    size_t(rowEnd - rowBegin) * cols);
+        });
+        return result;
+    }
+
+    /**
+     * @brief Rounds a float matrix to a 16-bit type H (bfloat16 or float16).
+     */
+    template <typename H>
+    Matrix<H> fromFloat(const Matrix<float>& M) {
+        Matrix<H> result(M.getRows(), M.getCols());
+        const int cols = M.getCols();
+        parallel::parallelFor(0, M.getRows(), parallel::grainFor(cols), [&](int rowBegin, int rowEnd) {
+            fromFloat(M.data() + size_t(rowBegin) * cols, result.data() + size_t(rowBegin) * cols,
+                      size_t(rowEnd - rowBegin) * cols);
+        });
+        return result;
+    }
+
+    /**
+     * @brief Product of two 16-bit matrices with a float result.
+     * * The blocked GEMM converts A and B to float while it packs their panels, so only the
+     * packed buffers are ever held in float, and accumulates in float.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename H>
+    Matrix<float> multiplyFloat(const Matrix<H>& A, const Matrix<H>& B) {
+        static_assert(std::is_same<H, bfloat16>::value || std::is_same<H, float16>::value,
+                      "multiplyFloat requires bfloat16 or float16 operands.");
+        if (A.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        LINEARCPP_TRACE_SCOPE("multiplyFloat", "product", A.getRows());
+        Matrix<float> C(A.getRows(), B.getCols());
+        gemm::multiplyAdd<float, H>(A.getRows(), B.getCols(), A.getCols(), 1.0f,
+                                    A.data(), A.getCols(), B.data(), B.getCols(), C.data(), C.getCols());
+        return C;
+    }
+
+} // namespace half
+
+/**
+ * @brief Classical product of bfloat16 matrices: float accumulation, one rounding per entry.
+ * * Found by the Matrix operator* and the Strassen leaves in place of the generic kernel.
+ */
+inline Matrix<bfloat16> matrixMultiply(const Matrix<bfloat16>& A, const Matrix<bfloat16>& B) {
+    return half::fromFloat<bfloat16>(half::multiplyFloat(A, B));
+}
+
+/**
+ * @brief Classical product of float16 matrices: float accumulation, one rounding per entry.
+ */
+inline Matrix<float16> matrixMultiply(const Matrix<float16>& A, const Matrix<float16>& B) {
+    return half::fromFloat<float16>(half::multiplyFloat(A, B));
+}
+
+#endif // HALF_HPP
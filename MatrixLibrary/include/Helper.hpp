@@ -4,7 +4,16 @@
 #include<cmath>
 #include<algorithm>
 #include <iostream>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 #include "Matrix.hpp"
+#include "Traits.hpp"
+
+template<typename T> class Matrix;
 
 /**
  * @brief Computes the smallest power of two greater than or equal to a given value.
@@ -17,7 +26,7 @@
  * @return The next power of two size_t value. Returns 1 if input is 0.
  */
 
-size_t nextPowerOfTwo(size_t n){
+inline size_t nextPowerOfTwo(size_t n){
 
     if(n == 0) return 1;
     // Check if n is already a power of two using bitwise AND
@@ -30,34 +39,229 @@ size_t nextPowerOfTwo(size_t n){
     return power;
 }
 
+namespace detail {
+
+    /**
+     * @brief Unit roundoff used for tolerance-aware comparisons; 0 for exact types
+     * (integers and other non-floating element types), which are compared exactly.
+     * Complex types and inexact types with a numeric_limits specialization, such as
+     * bfloat16 and float16, count as floating.
+     */
+    template <typename T>
+    constexpr bool hasTolerance()
+    {
+        return std::is_floating_point<T>::value || gemm::IsComplex<T>::value ||
+               (std::numeric_limits<T>::is_specialized && !std::numeric_limits<T>::is_exact);
+    }
+
+    template <typename T>
+    double verificationEpsilon()
+    {
+        if constexpr (hasTolerance<T>())
+        {
+            if constexpr (gemm::IsComplex<T>::value)
+            {
+                return std::numeric_limits<typename T::value_type>::epsilon();
+            }
+            else
+            {
+                return static_cast<double>(std::numeric_limits<T>::epsilon());
+            }
+        }
+        else
+        {
+            return 0.0;
+        }
+    }
+
+    // Max row sum of absolute values (infinity norm), O(rows * cols).
+    template <typename T>
+    double normInf(const Matrix<T> &M)
+    {
+        double norm = 0.0;
+        for (auto i = 0; i < M.getRows(); ++i)
+        {
+            double rowSum = 0.0;
+            for (auto j = 0; j < M.getCols(); ++j)
+            {
+                rowSum += static_cast<double>(std::abs(M(i, j)));
+            }
+            norm = std::max(norm, rowSum);
+        }
+        return norm;
+    }
+
+} // namespace detail
+
+/**
+ * @brief How freivaldsCheck draws the entries of its random vectors.
+ * * A wrong product passes a trial with probability at most 1/2 if, for every nonzero d,
+ * d * r takes at least two values as r ranges over the drawn entries. Signed and
+ * floating-point types draw from {-1, +1}. Finite rings, where 1 and -1 may coincide (GF(2))
+ * or 2d may vanish (Z/2^k), draw uniformly from the whole ring: d * r is then uniform over a
+ * nonzero subgroup and is zero with probability at most 1/2. Unsigned integers are handled
+ * here and ModInt specializes it in Exact.hpp.
+ */
+template <typename T, typename = void>
+struct FreivaldsTraits {
+    static T sample(std::mt19937_64 &rng) { return (rng() & 1) ? T(1) : T(-1); }
+};
+
+template <typename T>
+struct FreivaldsTraits<T, std::enable_if_t<std::is_integral<T>::value && std::is_unsigned<T>::value &&
+                                              !std::is_same<T, bool>::value>> {
+    static T sample(std::mt19937_64 &rng) { return static_cast<T>(rng()); }
+};
+
+/**
+ * @brief Probabilistically verifies that A * X == B using Freivalds' algorithm.
+ * * Instead of recomputing A * X in O(n^3), the check compares A (X r) with B r for random
+ * vectors r (entries in {-1, +1}, or uniform over finite rings; see FreivaldsTraits), which
+ * costs O(n^2) per trial. A wrong B passes a single trial with probability at most 1/2, so
+ * ceil(log2(1 / failureProbability)) trials are run; they are batched into one n x trials
+ * matrix so the products run through GEMM.
+ *
+ * Exact element types are compared exactly. Floating-point types accept a difference of
+ * up to tolerance * (||A|| ||X|| + ||B||) in the infinity norm, the normwise bound that
+ * both the classical and Strassen products satisfy.
+ * * @tparam T The numeric type of the matrix elements.
+ * @param A The first factor matrix (m x k).
+ * @param X The second factor matrix (k x n).
+ * @param B The claimed product (m x n).
+ * @param failureProbability Upper bound on the probability of accepting a wrong B.
+ * @param tolerance Relative tolerance for floating point; negative selects 16 * (k + 2) * eps.
+ * @param seed Seed of the random vectors; 0 draws one from std::random_device.
+ * @return true if B passed all trials.
+ * @throws std::invalid_argument If the dimensions do not agree.
+ */
+template <typename T>
+bool freivaldsCheck(const Matrix<T> &A, const Matrix<T> &X, const Matrix<T> &B,
+                    double failureProbability = 1e-9, double tolerance = -1.0, uint64_t seed = 0)
+{
+    if (A.getCols() != X.getRows() || B.getRows() != A.getRows() || B.getCols() != X.getCols())
+    {
+        throw std::invalid_argument("Matrix dimensions must agree for verification.");
+    }
+    int trials = std::max(1, static_cast<int>(std::ceil(std::log2(1.0 / failureProbability))));
+
+    std::mt19937_64 rng(seed != 0 ? seed : (uint64_t(std::random_device{}()) << 32) ^ std::random_device{}());
+    Matrix<T> R(X.getCols(), trials);
+    for (auto i = 0; i < R.getRows(); ++i)
+    {
+        for (auto j = 0; j < R.getCols(); ++j)
+        {
+            R(i, j) = FreivaldsTraits<T>::sample(rng);
+        }
+    }
+
+    Matrix<T> AXR = matrixMultiply(A, matrixMultiply(X, R));
+    Matrix<T> BR = matrixMultiply(B, R);
+
+    double eps = detail::verificationEpsilon<T>();
+    double bound = 0.0;
+    if constexpr (detail::hasTolerance<T>())
+    {
+        if (tolerance < 0.0)
+        {
+            tolerance = 16.0 * (A.getCols() + 2) * eps;
+        }
+        bound = tolerance * (detail::normInf(A) * detail::normInf(X) + detail::normInf(B));
+    }
+
+    for (auto i = 0; i < BR.getRows(); ++i)
+    {
+        for (auto j = 0; j < BR.getCols(); ++j)
+        {
+            if constexpr (detail::hasTolerance<T>())
+            {
+                if (!(static_cast<double>(std::abs(AXR(i, j) - BR(i, j))) <= bound))
+                {
+                    return false;
+                }
+            }
+            else if (AXR(i, j) != BR(i, j))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 /**
  * @brief Verifies the correctness of a matrix multiplication result.
- * * Performs a validation check by computing the product of matrices A and X
- * and comparing the result element-wise against matrix B. This is typically
- * used to verify that an optimized multiplication (like Strassen) matches
- * the expected theoretical outcome.
+ * * Checks that A * X matches B with Freivalds' randomized algorithm (see freivaldsCheck),
+ * so verification costs O(n^2) instead of repeating the O(n^3) product. Exact types must
+ * match exactly; floating-point types are compared with a normwise tolerance.
  * * @tparam T The numeric type of the matrix elements.
  * @param A The first factor matrix.
  * @param X The second factor matrix.
  * @param B The expected result matrix to verify against.
- * @return true if (A * X) is identical to B, false otherwise.
+ * @return true if (A * X) matches B, false otherwise.
  */
 template <typename T>
 bool check(const Matrix<T> &A, const Matrix<T> &X, const Matrix<T> &B)
 {
-    Matrix<T> result = A * X;
-    for (auto i = 0; i < result.getRows(); ++i)
+    if (!freivaldsCheck(A, X, B))
     {
-        for (auto j = 0; j < result.getCols(); ++j)
+        std::cout << "Verification failed: Matrices are different." << std::endl;
+        return false;
+    }
+    std::cout << "Verification successful: Matrices match." << std::endl;
+    return true;
+}
+
+/**
+ * @brief Normwise backward error of an approximate solution x of Ax = b.
+ * * Computes ||b - Ax|| / (||A|| ||x|| + ||b||) in the infinity norm in O(n^2). A
+ * backward-stable solver such as LU with partial pivoting yields a value of the order of
+ * n * eps regardless of the conditioning of A.
+ */
+template <typename T>
+double backwardError(const Matrix<T> &A, const std::vector<T> &x, const std::vector<T> &b)
+{
+    if (A.getCols() != static_cast<int>(x.size()) || A.getRows() != static_cast<int>(b.size()))
+    {
+        throw std::invalid_argument("Matrix dimensions must agree for residual computation.");
+    }
+    double residual = 0.0, normX = 0.0, normB = 0.0;
+    for (auto i = 0; i < A.getRows(); ++i)
+    {
+        T sum = b[i];
+        for (auto j = 0; j < A.getCols(); ++j)
         {
-            if (result(i, j) != B(i, j))
-            {
-                std::cout << "Verification failed: Matrices are different." << std::endl;
-                return false;
-            }
+            sum -= A(i, j) * x[j];
         }
+        residual = std::max(residual, static_cast<double>(std::abs(sum)));
+        normB = std::max(normB, static_cast<double>(std::abs(b[i])));
+    }
+    for (const T &value : x)
+    {
+        normX = std::max(normX, static_cast<double>(std::abs(value)));
+    }
+    double scale = detail::normInf(A) * normX + normB;
+    return scale > 0.0 ? residual / scale : residual;
+}
+
+/**
+ * @brief Verifies a solution of Ax = b through its normwise backward error.
+ * @param tolerance Maximum accepted backward error; negative selects 64 * n * eps.
+ * @return true if the backward error is within the tolerance.
+ */
+template <typename T>
+bool checkSolution(const Matrix<T> &A, const std::vector<T> &x, const std::vector<T> &b, double tolerance = -1.0)
+{
+    if (tolerance < 0.0)
+    {
+        tolerance = 64.0 * std::max(1, A.getRows()) * detail::verificationEpsilon<T>();
+    }
+    double error = backwardError(A, x, b);
+    if (!(error <= tolerance))
+    {
+        std::cout << "Verification failed: backward error " << error << " exceeds " << tolerance << "." << std::endl;
+        return false;
     }
-    std::cout << "Verification successful: Matrices are identical." << std::endl;
+    std::cout << "Verification successful: backward error " << error << "." << std::endl;
     return true;
 }
 
@@ -0,0 +1,32 @@
+#ifndef INSTANTIATIONS_HPP
+#define INSTANTIATIONS_HPP
+
+#include <complex>
+
+/**
+ * @brief Explicit instantiation lists shared by the headers and the compiled library.
+ * * Each kernel header ends with an instantiation list for its templates, written once in
+ * terms of LINEARCPP_TEMPLATE:
+ * - the linearcpp library source defines LINEARCPP_INSTANTIATE, so the lists become explicit
+ *   instantiation definitions and the kernels are compiled once into the library;
+ * - consumers of the linearcpp target get LINEARCPP_USE_LIBRARY, so the lists become extern
+ *   template declarations and those translation units link against the precompiled kernels
+ *   instead of instantiating them again;
+ * - header-only users define neither and instantiate on demand as before.
+ * Element types outside the lists keep working header-only in every mode.
+ */
+
+// Element types with precompiled containers and products.
+#define LINEARCPP_ELEMENT_TYPES(X) X(float) X(double) X(std::complex<float>) X(std::complex<double>)
+
+// Element types with precompiled Cholesky and mixed-precision solvers (real floating point;
+// LU and its solve are precompiled for all element types above).
+#define LINEARCPP_REAL_TYPES(X) X(float) X(double)
+
+#if defined(LINEARCPP_INSTANTIATE)
+#define LINEARCPP_TEMPLATE template
+#elif defined(LINEARCPP_USE_LIBRARY)
+#define LINEARCPP_TEMPLATE extern template
+#endif
+
+#endif // INSTANTIATIONS_HPP
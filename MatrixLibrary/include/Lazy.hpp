@@ -0,0 +1,1137 @@
+#ifndef LAZY_HPP
+#define LAZY_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Matrix.hpp"
+#include "LinearSolver.hpp"
+#include "Gemm.hpp"
+#include "Parallel.hpp"
+#include "Context.hpp"
+#include "Memory.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Opt-in lazy evaluation of matrix expressions as a task graph.
+ * * Operations on lazy::Expr build a DAG of products, additions, subtractions, scalings,
+ * Hadamard products, transposes and solves instead of computing anything. evaluate()
+ * plans the whole graph and runs it:
+ * - Transpose elimination: transposes are pushed through sums and products
+ *   ((A B)^T = B^T A^T) wherever that removes them, and only the ones left are computed.
+ * - Chain reordering: runs of products are re-parenthesized by the matrix-chain dynamic
+ *   program to minimize flops.
+ * - GEMM epilogues: C + alpha * A * B and scalings of a product become one GEMM that
+ *   accumulates into C.
+ * - Elementwise fusion: trees of additions, scalings and Hadamard products become one
+ *   kernel that reads each input once and writes one result.
+ * - Common subexpressions: equal subexpressions, whether the same Expr reused or written
+ *   out twice over the same operands, are computed once.
+ * - Shared factorizations: solves against the same matrix share one LU decomposition.
+ * - Buffer reuse: an intermediate is recycled as soon as its last consumer has run, and a
+ *   kernel whose input has no other consumer writes over it.
+ * The planned steps are then run on the thread pool as soon as their inputs are ready; a
+ * step that runs alone gets the whole pool for itself (see Parallel.hpp).
+ *
+ *   auto a = lazy::ref(A), b = lazy::ref(B), c = lazy::ref(C);
+ *   Matrix<double> R = (a * b * c + 2.0 * lazy::transpose(b * a)).eval();
+ *   std::vector<Matrix<double>> both = lazy::evaluate<double>({a * b, a * b + c});
+ *
+ * Matrices captured with lazy::ref must stay alive and unchanged until evaluation; those
+ * passed to lazy::value are owned by the expression.
+ */
+namespace lazy {
+
+    /**
+     * @brief What the planner did with an evaluated graph and how its buffers were served.
+     */
+    struct Stats {
+        int steps = 0;                 //< Kernels run.
+        int gemms = 0;                 //< GEMM kernels.
+        int fusedKernels = 0;          //< Elementwise kernels after fusion.
+        int elementwiseOps = 0;        //< Elementwise operations those kernels perform.
+        int epilogues = 0;             //< Additions and scalings folded into a GEMM.
+        int transposes = 0;            //< Transposes computed.
+        int transposesEliminated = 0;  //< Transposes written but not computed.
+        int factorizations = 0;        //< LU decompositions.
+        double flopsWritten = 0;       //< GEMM flops of the products in the order written.
+        double flops = 0;              //< GEMM flops after chain reordering.
+        int buffersAllocated = 0;      //< Result buffers allocated.
+        int buffersReused = 0;         //< Result buffers recycled or overwritten in place.
+    };
+
+    template <typename T>
+    class Expr;
+
+    namespace detail {
+
+        enum class Op { Input, Add, Sub, Scale, Hadamard, Multiply, Transpose, Solve };
+
+        /**
+         * @brief A node of the expression as written.
+         */
+        template <typename T>
+        struct Node {
+            Op op;
+            int rows;
+            int cols;
+            std::shared_ptr<const Node> left;
+            std::shared_ptr<const Node> right;
+            T scalar = T(1);
+            const Matrix<T>* matrix = nullptr;       // Input
+            std::shared_ptr<const Matrix<T>> owned;  // Input made by lazy::value
+        };
+
+        template <typename T>
+        Expr<T> make(Op op, int rows, int cols, const Expr<T>* left, const Expr<T>* right, T scalar = T(1));
+
+    } // namespace detail
+
+    /**
+     * @brief A matrix-valued expression, evaluated on demand. Copies share the node, so an
+     * expression used twice is computed once.
+     */
+    template <typename T>
+    class Expr {
+        private:
+            std::shared_ptr<const detail::Node<T>> m_node;
+
+        public:
+            using Scalar = T;
+
+            explicit Expr(std::shared_ptr<const detail::Node<T>> node) : m_node(std::move(node)) {}
+
+            int getRows() const { return m_node->rows; }
+            int getCols() const { return m_node->cols; }
+            const std::shared_ptr<const detail::Node<T>>& node() const { return m_node; }
+
+            Expr transpose() const {
+                return detail::make<T>(detail::Op::Transpose, getCols(), getRows(), this, nullptr);
+            }
+
+            /**
+             * @brief Plans and runs the expression.
+             */
+            Matrix<T> eval() const;
+    };
+
+    namespace detail {
+
+        template <typename T>
+        Expr<T> make(Op op, int rows, int cols, const Expr<T>* left, const Expr<T>* right, T scalar) {
+            auto node = std::make_shared<Node<T>>();
+            node->op = op;
+            node->rows = rows;
+            node->cols = cols;
+            node->left = left ? left->node() : nullptr;
+            node->right = right ? right->node() : nullptr;
+            node->scalar = scalar;
+            return Expr<T>(std::move(node));
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Refers to a matrix without copying it; it must outlive the evaluation.
+     */
+    template <typename T>
+    Expr<T> ref(const Matrix<T>& matrix) {
+        auto node = std::make_shared<detail::Node<T>>();
+        node->op = detail::Op::Input;
+        node->rows = matrix.getRows();
+        node->cols = matrix.getCols();
+        node->matrix = &matrix;
+        return Expr<T>(std::move(node));
+    }
+
+    /**
+     * @brief Moves a matrix into the expression.
+     */
+    template <typename T>
+    Expr<T> value(Matrix<T> matrix) {
+        auto node = std::make_shared<detail::Node<T>>();
+        node->op = detail::Op::Input;
+        node->rows = matrix.getRows();
+        node->cols = matrix.getCols();
+        node->owned = std::make_shared<const Matrix<T>>(std::move(matrix));
+        node->matrix = node->owned.get();
+        return Expr<T>(std::move(node));
+    }
+
+    template <typename T>
+    Expr<T> operator+(const Expr<T>& a, const Expr<T>& b) {
+        if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+            throw std::invalid_argument("Matrix dimensions must agree for addition.");
+        }
+        return detail::make<T>(detail::Op::Add, a.getRows(), a.getCols(), &a, &b);
+    }
+
+    template <typename T>
+    Expr<T> operator-(const Expr<T>& a, const Expr<T>& b) {
+        if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+            throw std::invalid_argument("Matrix dimensions must agree for subtraction.");
+        }
+        return detail::make<T>(detail::Op::Sub, a.getRows(), a.getCols(), &a, &b);
+    }
+
+    template <typename T>
+    Expr<T> operator*(const Expr<T>& a, const Expr<T>& b) {
+        if (a.getCols() != b.getRows()) {
+            throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
+        }
+        return detail::make<T>(detail::Op::Multiply, a.getRows(), b.getCols(), &a, &b);
+    }
+
+    template <typename T>
+    Expr<T> operator*(const Expr<T>& a, const typename Expr<T>::Scalar& scalar) {
+        return detail::make<T>(detail::Op::Scale, a.getRows(), a.getCols(), &a, nullptr, scalar);
+    }
+
+    template <typename T>
+    Expr<T> operator*(const typename Expr<T>::Scalar& scalar, const Expr<T>& a) {
+        return a * scalar;
+    }
+
+    template <typename T>
+    Expr<T> operator-(const Expr<T>& a) {
+        return a * T(-1);
+    }
+
+    template <typename T>
+    Expr<T> hadamard(const Expr<T>& a, const Expr<T>& b) {
+        if (a.getRows() != b.getRows() || a.getCols() != b.getCols()) {
+            throw std::invalid_argument("Dimensions must match for Hadamard product");
+        }
+        return detail::make<T>(detail::Op::Hadamard, a.getRows(), a.getCols(), &a, &b);
+    }
+
+    template <typename T>
+    Expr<T> transpose(const Expr<T>& a) {
+        return a.transpose();
+    }
+
+    /**
+     * @brief X with A X = B, by LU decomposition with partial pivoting (see decomposeLU).
+     * Solves against the same matrix share one decomposition.
+     */
+    template <typename T>
+    Expr<T> solve(const Expr<T>& A, const Expr<T>& B) {
+        static_assert(std::is_floating_point<T>::value || gemm::IsComplex<T>::value || PivotTraits<T>::exact,
+                      "Solving requires floating-point, complex or exact field types");
+        if (A.getRows() != A.getCols()) {
+            throw std::invalid_argument("Error: Solving requires a square matrix.");
+        }
+        if (A.getRows() != B.getRows()) {
+            throw std::invalid_argument("Error: Right-hand side rows do not match the matrix.");
+        }
+        return detail::make<T>(detail::Op::Solve, B.getRows(), B.getCols(), &A, &B);
+    }
+
+    namespace detail {
+
+        enum class Kernel { Input, Transpose, Gemm, Add, Sub, Scale, Hadamard, Elementwise, Factor, Solve };
+
+        enum class Code { Load, Scale, Add, Sub, Mul };
+
+        /**
+         * @brief One instruction of a fused elementwise kernel, run on a stack of tiles.
+         */
+        template <typename T>
+        struct Instruction {
+            Code code;
+            int input;  // Load
+            T scalar;   // Scale
+        };
+
+        /**
+         * @brief A step of the planned graph.
+         */
+        template <typename T>
+        struct Step {
+            Kernel kernel;
+            int rows;
+            int cols;
+            std::vector<std::shared_ptr<Step>> inputs;
+            T scalar = T(1);                      // Scale
+            T alpha = T(1);                       // Gemm: alpha * A * B + beta * inputs[2]
+            T beta = T(0);
+            std::vector<Instruction<T>> program;  // Elementwise
+            int depth = 0;                        // Elementwise stack depth
+            const Matrix<T>* matrix = nullptr;    // Input
+            int uses = 0;
+            bool output = false;
+        };
+
+        template <typename T>
+        using StepPtr = std::shared_ptr<Step<T>>;
+
+        inline bool isElementwise(Kernel kernel) {
+            return kernel == Kernel::Add || kernel == Kernel::Sub || kernel == Kernel::Scale ||
+                   kernel == Kernel::Hadamard;
+        }
+
+        /**
+         * @brief Turns the written expression into the planned graph, one pass per rewrite.
+         */
+        template <typename T>
+        class Planner {
+            private:
+                Stats& m_stats;
+                std::map<std::pair<const Node<T>*, bool>, StepPtr<T>> m_lowered;
+                std::map<std::pair<const Node<T>*, bool>, int> m_cost;
+                std::map<const Matrix<T>*, StepPtr<T>> m_inputs;
+                std::map<const Step<T>*, StepPtr<T>> m_transposes;
+                std::map<const Step<T>*, StepPtr<T>> m_factors;
+                std::set<const Node<T>*> m_writtenTransposes;
+                std::map<std::pair<Kernel, std::vector<const Step<T>*>>, std::vector<StepPtr<T>>> m_interned;
+
+                static StepPtr<T> step(Kernel kernel, int rows, int cols, std::vector<StepPtr<T>> inputs) {
+                    auto s = std::make_shared<Step<T>>();
+                    s->kernel = kernel;
+                    s->rows = rows;
+                    s->cols = cols;
+                    s->inputs = std::move(inputs);
+                    return s;
+                }
+
+                // The step computing the same kernel on the same inputs with the same scalar
+                // as `s`, if one was lowered already, so that a subexpression written twice
+                // is computed once like one reused through the same Expr.
+                StepPtr<T> intern(const StepPtr<T>& s) {
+                    std::vector<const Step<T>*> inputs;
+                    for (const auto& input : s->inputs) {
+                        inputs.push_back(input.get());
+                    }
+                    std::vector<StepPtr<T>>& equal = m_interned[{s->kernel, std::move(inputs)}];
+                    for (const auto& candidate : equal) {
+                        if (candidate->scalar == s->scalar) {
+                            return candidate;
+                        }
+                    }
+                    equal.push_back(s);
+                    return s;
+                }
+
+                StepPtr<T> transposeOf(const StepPtr<T>& s) {
+                    StepPtr<T>& t = m_transposes[s.get()];
+                    if (!t) {
+                        t = step(Kernel::Transpose, s->cols, s->rows, {s});
+                    }
+                    return t;
+                }
+
+                // Transposes computed to get `node` in the given orientation if each node
+                // picks the cheaper of its two ways (shared subexpressions counted per use).
+                int cost(const Node<T>* node, bool transposed) {
+                    auto key = std::make_pair(node, transposed);
+                    auto found = m_cost.find(key);
+                    if (found != m_cost.end()) {
+                        return found->second;
+                    }
+                    int result = 0;
+                    switch (node->op) {
+                        case Op::Input:
+                            result = transposed ? 1 : 0;
+                            break;
+                        case Op::Transpose:
+                            result = cost(node->left.get(), !transposed);
+                            break;
+                        case Op::Solve:
+                            result = cost(node->left.get(), false) + cost(node->right.get(), false) + (transposed ? 1 : 0);
+                            break;
+                        default:
+                            result = std::min(direct(node, transposed), 1 + direct(node, !transposed));
+                    }
+                    m_cost[key] = result;
+                    return result;
+                }
+
+                // Cost of computing `node` in the given orientation from its inputs in the
+                // orientation that needs no transpose of the result.
+                int direct(const Node<T>* node, bool transposed) {
+                    int result = cost(node->left.get(), transposed);
+                    if (node->right) {
+                        result += cost(node->right.get(), transposed);
+                    }
+                    return result;
+                }
+
+            public:
+                explicit Planner(Stats& stats) : m_stats(stats) {}
+
+                /**
+                 * @brief The steps computing `node`, or its transpose if `transposed`.
+                 */
+                StepPtr<T> lower(const Node<T>* node, bool transposed) {
+                    auto key = std::make_pair(node, transposed);
+                    auto found = m_lowered.find(key);
+                    if (found != m_lowered.end()) {
+                        return found->second;
+                    }
+                    StepPtr<T> result;
+                    switch (node->op) {
+                        case Op::Input: {
+                            StepPtr<T>& input = m_inputs[node->matrix];
+                            if (!input) {
+                                input = step(Kernel::Input, node->rows, node->cols, {});
+                                input->matrix = node->matrix;
+                            }
+                            result = transposed ? transposeOf(input) : input;
+                            break;
+                        }
+                        case Op::Transpose:
+                            m_writtenTransposes.insert(node);
+                            result = lower(node->left.get(), !transposed);
+                            break;
+                        case Op::Solve: {
+                            StepPtr<T> A = lower(node->left.get(), false);
+                            StepPtr<T>& factor = m_factors[A.get()];
+                            if (!factor) {
+                                factor = step(Kernel::Factor, A->rows, A->cols, {A});
+                            }
+                            result = intern(step(Kernel::Solve, node->rows, node->cols, {factor, lower(node->right.get(), false)}));
+                            if (transposed) {
+                                result = transposeOf(result);
+                            }
+                            break;
+                        }
+                        default: {
+                            // Compute in the requested orientation, or in the other one and
+                            // transpose the result, whichever computes fewer transposes.
+                            const bool flip = direct(node, transposed) > 1 + direct(node, !transposed);
+                            const bool inner = flip ? !transposed : transposed;
+                            StepPtr<T> left = lower(node->left.get(), inner);
+                            StepPtr<T> right = node->right ? lower(node->right.get(), inner) : nullptr;
+                            const int innerRows = inner ? node->cols : node->rows;
+                            const int innerCols = inner ? node->rows : node->cols;
+                            switch (node->op) {
+                                case Op::Add: result = step(Kernel::Add, innerRows, innerCols, {left, right}); break;
+                                case Op::Sub: result = step(Kernel::Sub, innerRows, innerCols, {left, right}); break;
+                                case Op::Hadamard: result = step(Kernel::Hadamard, innerRows, innerCols, {left, right}); break;
+                                case Op::Scale:
+                                    result = step(Kernel::Scale, innerRows, innerCols, {left});
+                                    result->scalar = node->scalar;
+                                    break;
+                                default:
+                                    // (A B)^T = B^T A^T
+                                    result = inner ? step(Kernel::Gemm, innerRows, innerCols, {right, left})
+                                                   : step(Kernel::Gemm, innerRows, innerCols, {left, right});
+                            }
+                            result = intern(result);
+                            if (flip) {
+                                result = transposeOf(result);
+                            }
+                        }
+                    }
+                    m_lowered[key] = result;
+                    return result;
+                }
+
+                /**
+                 * @brief Plans the graph computing `outputs` and returns its steps in a
+                 * topological order.
+                 */
+                std::vector<StepPtr<T>> plan(const std::vector<Expr<T>>& outputs, std::vector<StepPtr<T>>& roots) {
+                    for (const auto& output : outputs) {
+                        roots.push_back(lower(output.node().get(), false));
+                    }
+                    countUses(roots);
+                    std::set<const Step<T>*> visited;
+                    for (const auto& root : roots) {
+                        reorderChains(root, visited);
+                    }
+                    visited.clear();
+                    for (const auto& root : roots) {
+                        foldEpilogues(root, visited);
+                    }
+                    countUses(roots);
+                    visited.clear();
+                    for (const auto& root : roots) {
+                        fuse(root, visited);
+                    }
+                    countUses(roots);
+
+                    std::vector<StepPtr<T>> order;
+                    visited.clear();
+                    for (const auto& root : roots) {
+                        linearize(root, visited, order);
+                    }
+                    for (const auto& s : order) {
+                        switch (s->kernel) {
+                            case Kernel::Transpose: ++m_stats.transposes; break;
+                            case Kernel::Gemm:
+                                ++m_stats.gemms;
+                                m_stats.flops += 2.0 * s->rows * s->cols * s->inputs[0]->cols;
+                                break;
+                            case Kernel::Factor: ++m_stats.factorizations; break;
+                            default: break;
+                        }
+                        if (s->kernel != Kernel::Input) {
+                            ++m_stats.steps;
+                        }
+                    }
+                    m_stats.transposesEliminated = std::max(0, int(m_writtenTransposes.size()) - m_stats.transposes);
+                    return order;
+                }
+
+            private:
+                void countUses(const std::vector<StepPtr<T>>& roots) {
+                    std::vector<Step<T>*> all;
+                    std::set<const Step<T>*> seen;
+                    std::vector<Step<T>*> stack;
+                    for (const auto& root : roots) {
+                        stack.push_back(root.get());
+                    }
+                    while (!stack.empty()) {
+                        Step<T>* s = stack.back();
+                        stack.pop_back();
+                        if (!seen.insert(s).second) {
+                            continue;
+                        }
+                        all.push_back(s);
+                        s->uses = 0;
+                        s->output = false;
+                        for (const auto& input : s->inputs) {
+                            stack.push_back(input.get());
+                        }
+                    }
+                    for (Step<T>* s : all) {
+                        for (const auto& input : s->inputs) {
+                            ++input->uses;
+                        }
+                    }
+                    for (const auto& root : roots) {
+                        root->output = true;
+                    }
+                }
+
+                // A product whose only consumer is another product of the chain.
+                static bool chainLink(const StepPtr<T>& s) {
+                    return s->kernel == Kernel::Gemm && s->uses == 1 && !s->output;
+                }
+
+                void collectChain(const StepPtr<T>& s, std::vector<StepPtr<T>>& factors, double& flops) {
+                    if (!chainLink(s)) {
+                        factors.push_back(s);
+                        return;
+                    }
+                    flops += 2.0 * s->rows * s->cols * s->inputs[0]->cols;
+                    collectChain(s->inputs[0], factors, flops);
+                    collectChain(s->inputs[1], factors, flops);
+                }
+
+                void reorderChains(const StepPtr<T>& s, std::set<const Step<T>*>& visited) {
+                    if (!visited.insert(s.get()).second) {
+                        return;
+                    }
+                    if (s->kernel != Kernel::Gemm) {
+                        for (const auto& input : s->inputs) {
+                            reorderChains(input, visited);
+                        }
+                        return;
+                    }
+                    std::vector<StepPtr<T>> factors;
+                    double written = 2.0 * s->rows * s->cols * s->inputs[0]->cols;
+                    collectChain(s->inputs[0], factors, written);
+                    collectChain(s->inputs[1], factors, written);
+                    for (const auto& factor : factors) {
+                        reorderChains(factor, visited);
+                    }
+                    m_stats.flopsWritten += written;
+                    if (factors.size() < 3) {
+                        return;
+                    }
+
+                    // Matrix-chain order: best[i][j] is the cheapest product of factors i..j.
+                    const int count = int(factors.size());
+                    std::vector<double> dims(count + 1);
+                    for (int i = 0; i < count; ++i) {
+                        dims[i] = factors[i]->rows;
+                    }
+                    dims[count] = factors[count - 1]->cols;
+                    std::vector<std::vector<double>> best(count, std::vector<double>(count, 0.0));
+                    std::vector<std::vector<int>> split(count, std::vector<int>(count, 0));
+                    for (int length = 2; length <= count; ++length) {
+                        for (int i = 0; i + length - 1 < count; ++i) {
+                            const int j = i + length - 1;
+                            best[i][j] = std::numeric_limits<double>::infinity();
+                            for (int k = i; k < j; ++k) {
+                                const double flops = best[i][k] + best[k + 1][j] + 2.0 * dims[i] * dims[k + 1] * dims[j + 1];
+                                if (flops < best[i][j]) {
+                                    best[i][j] = flops;
+                                    split[i][j] = k;
+                                }
+                            }
+                        }
+                    }
+                    std::function<StepPtr<T>(int, int)> build = [&](int i, int j) -> StepPtr<T> {
+                        if (i == j) {
+                            return factors[i];
+                        }
+                        const int k = split[i][j];
+                        StepPtr<T> product = step(Kernel::Gemm, factors[i]->rows, factors[j]->cols, {build(i, k), build(k + 1, j)});
+                        product->uses = 1;
+                        return product;
+                    };
+                    const int k = split[0][count - 1];
+                    s->inputs = {build(0, k), build(k + 1, count - 1)};
+                }
+
+                // A product that can take an addition or scaling of its result in its epilogue.
+                static bool foldable(const StepPtr<T>& s) {
+                    return s->kernel == Kernel::Gemm && s->uses == 1 && !s->output;
+                }
+
+                void foldEpilogues(const StepPtr<T>& s, std::set<const Step<T>*>& visited) {
+                    if (!visited.insert(s.get()).second) {
+                        return;
+                    }
+                    for (const auto& input : s->inputs) {
+                        foldEpilogues(input, visited);
+                    }
+                    if (s->kernel == Kernel::Scale && foldable(s->inputs[0])) {
+                        const StepPtr<T> product = s->inputs[0];
+                        const T scalar = s->scalar;
+                        s->kernel = Kernel::Gemm;
+                        s->inputs = product->inputs;
+                        s->alpha = product->alpha * scalar;
+                        s->beta = product->beta * scalar;
+                        ++m_stats.epilogues;
+                        return;
+                    }
+                    if (s->kernel != Kernel::Add && s->kernel != Kernel::Sub) {
+                        return;
+                    }
+                    const T sign = s->kernel == Kernel::Add ? T(1) : T(-1);
+                    const StepPtr<T> left = s->inputs[0], right = s->inputs[1];
+                    // A product with no addend of its own: C + alpha A B, or alpha A B - C.
+                    if (foldable(right) && right->inputs.size() == 2) {
+                        s->kernel = Kernel::Gemm;
+                        s->inputs = {right->inputs[0], right->inputs[1], left};
+                        s->alpha = sign * right->alpha;
+                        s->beta = T(1);
+                        ++m_stats.epilogues;
+                    } else if (foldable(left) && left->inputs.size() == 2) {
+                        s->kernel = Kernel::Gemm;
+                        s->inputs = {left->inputs[0], left->inputs[1], right};
+                        s->alpha = left->alpha;
+                        s->beta = sign;
+                        ++m_stats.epilogues;
+                    }
+                }
+
+                // Emits the program of an elementwise tree, inlining the operands that have
+                // no other consumer; returns the stack depth it needs.
+                int emit(const StepPtr<T>& s, bool root, std::vector<Instruction<T>>& program,
+                         std::vector<StepPtr<T>>& leaves) {
+                    if (!root && !(isElementwise(s->kernel) && s->uses == 1 && !s->output)) {
+                        auto found = std::find(leaves.begin(), leaves.end(), s);
+                        program.push_back({Code::Load, int(found - leaves.begin()), T(1)});
+                        if (found == leaves.end()) {
+                            leaves.push_back(s);
+                        }
+                        return 1;
+                    }
+                    ++m_stats.elementwiseOps;
+                    const int left = emit(s->inputs[0], false, program, leaves);
+                    if (s->kernel == Kernel::Scale) {
+                        program.push_back({Code::Scale, 0, s->scalar});
+                        return left;
+                    }
+                    const int right = emit(s->inputs[1], false, program, leaves);
+                    const Code code = s->kernel == Kernel::Add ? Code::Add : s->kernel == Kernel::Sub ? Code::Sub : Code::Mul;
+                    program.push_back({code, 0, T(1)});
+                    return std::max(left, right + 1);
+                }
+
+                void fuse(const StepPtr<T>& s, std::set<const Step<T>*>& visited) {
+                    if (!visited.insert(s.get()).second) {
+                        return;
+                    }
+                    if (isElementwise(s->kernel)) {
+                        std::vector<Instruction<T>> program;
+                        std::vector<StepPtr<T>> leaves;
+                        s->depth = emit(s, true, program, leaves);
+                        s->kernel = Kernel::Elementwise;
+                        s->program = std::move(program);
+                        s->inputs = std::move(leaves);
+                        ++m_stats.fusedKernels;
+                    }
+                    for (const auto& input : s->inputs) {
+                        fuse(input, visited);
+                    }
+                }
+
+                void linearize(const StepPtr<T>& s, std::set<const Step<T>*>& visited, std::vector<StepPtr<T>>& order) {
+                    if (!visited.insert(s.get()).second) {
+                        return;
+                    }
+                    for (const auto& input : s->inputs) {
+                        linearize(input, visited, order);
+                    }
+                    order.push_back(s);
+                }
+        };
+
+        /**
+         * @brief Runs a planned graph on the thread pool, each step as soon as its inputs are
+         * ready, preferring the steps with the most work left below them.
+         */
+        template <typename T>
+        class Executor {
+            private:
+                const std::vector<StepPtr<T>>& m_order;
+                Stats& m_stats;
+                std::map<const Step<T>*, int> m_index;
+                std::vector<std::vector<int>> m_inputs;     // distinct inputs of each step
+                std::vector<std::vector<int>> m_consumers;  // distinct consumers of each step
+                std::vector<int> m_steal;                   // input whose buffer a step takes, or -1
+                std::vector<double> m_priority;
+                std::vector<Matrix<T>> m_results;
+                std::vector<std::shared_ptr<LUResult<T>>> m_factors;
+
+                std::mutex m_mutex;
+                std::condition_variable m_changed;
+                std::vector<int> m_pending;    // inputs not yet computed
+                std::vector<int> m_remaining;  // consumers not yet run
+                std::vector<bool> m_stolen;
+                std::vector<int> m_ready;
+                int m_running = 0;
+                std::exception_ptr m_error;
+
+                std::mutex m_poolMutex;
+                std::map<std::pair<int, int>, std::vector<Matrix<T>>> m_pool;
+
+            public:
+                Executor(const std::vector<StepPtr<T>>& order, Stats& stats) : m_order(order), m_stats(stats) {
+                    const int count = int(order.size());
+                    for (int i = 0; i < count; ++i) {
+                        m_index[order[i].get()] = i;
+                    }
+                    m_inputs.resize(count);
+                    m_consumers.resize(count);
+                    for (int i = 0; i < count; ++i) {
+                        for (const auto& input : order[i]->inputs) {
+                            const int j = m_index[input.get()];
+                            if (std::find(m_inputs[i].begin(), m_inputs[i].end(), j) == m_inputs[i].end()) {
+                                m_inputs[i].push_back(j);
+                                m_consumers[j].push_back(i);
+                            }
+                        }
+                    }
+                    m_steal.assign(count, -1);
+                    for (int i = 0; i < count; ++i) {
+                        const Step<T>& s = *order[i];
+                        auto reusable = [&](int j) {
+                            const Step<T>& input = *order[j];
+                            return input.kernel != Kernel::Input && input.kernel != Kernel::Factor && !input.output &&
+                                   m_consumers[j].size() == 1 && input.rows == s.rows && input.cols == s.cols;
+                        };
+                        if (s.kernel == Kernel::Elementwise) {
+                            for (int j : m_inputs[i]) {
+                                if (reusable(j)) {
+                                    m_steal[i] = j;
+                                    break;
+                                }
+                            }
+                        } else if (s.kernel == Kernel::Gemm && s.inputs.size() == 3) {
+                            const int base = m_index[s.inputs[2].get()];
+                            if (reusable(base) && s.inputs[2] != s.inputs[0] && s.inputs[2] != s.inputs[1]) {
+                                m_steal[i] = base;
+                            }
+                        }
+                    }
+                    m_priority.assign(count, 0.0);
+                    for (int i = count - 1; i >= 0; --i) {
+                        double below = 0.0;
+                        for (int c : m_consumers[i]) {
+                            below = std::max(below, m_priority[c]);
+                        }
+                        m_priority[i] = work(*order[i]) + below;
+                    }
+                    m_results.resize(count);
+                    m_factors.resize(count);
+                    m_pending.resize(count);
+                    m_remaining.resize(count);
+                    m_stolen.assign(count, false);
+                    for (int i = 0; i < count; ++i) {
+                        m_pending[i] = int(m_inputs[i].size());
+                        m_remaining[i] = int(m_consumers[i].size());
+                    }
+                }
+
+                /**
+                 * @brief Runs every step; the first exception thrown by a step is rethrown
+                 * once the running steps have finished.
+                 */
+                void run() {
+                    const int count = int(m_order.size());
+                    int kernels = 0;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        for (int i = 0; i < count; ++i) {
+                            if (m_order[i]->kernel == Kernel::Input) {
+                                complete(i);
+                            } else {
+                                ++kernels;
+                            }
+                        }
+                    }
+                    parallel::ThreadPool& workers = parallel::pool();
+                    // Nested in another parallel region, steps run one at a time here.
+                    const int helpers = parallel::detail::inParallelRegion() ? 0 : workers.size() - 1;
+                    // Worker tasks run under the caller's context and memory budget.
+                    const exec::detail::State context = exec::detail::state();
+                    const size_t budget = memory::budget();
+
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    for (int started = 0; started < kernels && !m_error; ++started) {
+                        m_changed.wait(lock, [&] { return m_error || !m_ready.empty(); });
+                        if (m_error) {
+                            break;
+                        }
+                        auto next = std::max_element(m_ready.begin(), m_ready.end(),
+                                                     [&](int a, int b) { return m_priority[a] < m_priority[b]; });
+                        const int i = *next;
+                        m_ready.erase(next);
+                        const bool alone = m_running == 0 && m_ready.empty();
+                        if (!alone && m_running < helpers) {
+                            ++m_running;
+                            workers.enqueue([this, i, context, budget] {
+                                exec::detail::StateGuard guard(context);
+                                memory::ScopedBudget limit(budget);
+                                attempt(i);
+                                std::lock_guard<std::mutex> lock(m_mutex);
+                                --m_running;
+                                m_changed.notify_all();
+                            });
+                            continue;
+                        }
+                        // Alone, the step gets the whole pool; otherwise every helper is busy
+                        // and the caller runs it single-threaded.
+                        ++m_running;
+                        lock.unlock();
+                        bool& region = parallel::detail::inParallelRegion();
+                        const bool previous = region;
+                        region = previous || !alone;
+                        attempt(i);
+                        region = previous;
+                        lock.lock();
+                        --m_running;
+                    }
+                    m_changed.wait(lock, [&] { return m_running == 0; });
+                    if (m_error) {
+                        std::rethrow_exception(m_error);
+                    }
+                }
+
+                /**
+                 * @brief The result of step i, moved out unless it is an input.
+                 */
+                Matrix<T> take(int i) {
+                    const Step<T>& s = *m_order[i];
+                    return s.kernel == Kernel::Input ? *s.matrix : std::move(m_results[i]);
+                }
+
+                int indexOf(const Step<T>* s) const { return m_index.at(s); }
+
+            private:
+                static double work(const Step<T>& s) {
+                    const double size = double(s.rows) * s.cols;
+                    switch (s.kernel) {
+                        case Kernel::Gemm: return 2.0 * size * s.inputs[0]->cols;
+                        case Kernel::Elementwise: return size * s.program.size();
+                        case Kernel::Factor: return 2.0 / 3.0 * size * s.rows;
+                        case Kernel::Solve: return 2.0 * s.rows * size;
+                        case Kernel::Transpose: return size;
+                        default: return 0.0;
+                    }
+                }
+
+                // Runs step i and records its completion or its error; called unlocked.
+                void attempt(int i) {
+                    try {
+                        if (!m_error) {
+                            exec::checkpoint();
+                            execute(i);
+                        }
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        if (!m_error) {
+                            m_error = std::current_exception();
+                        }
+                        m_changed.notify_all();
+                        return;
+                    }
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    complete(i);
+                    m_changed.notify_all();
+                }
+
+                // Marks step i done: releases inputs it was the last consumer of and readies
+                // the consumers whose inputs are all done. Called with m_mutex held.
+                void complete(int i) {
+                    for (int j : m_inputs[i]) {
+                        if (--m_remaining[j] == 0 && !m_stolen[j] && !m_order[j]->output) {
+                            release(j);
+                        }
+                    }
+                    for (int c : m_consumers[i]) {
+                        if (--m_pending[c] == 0) {
+                            m_ready.push_back(c);
+                        }
+                    }
+                }
+
+                void release(int i) {
+                    m_factors[i].reset();
+                    if (m_order[i]->kernel == Kernel::Input || m_order[i]->kernel == Kernel::Factor) {
+                        return;
+                    }
+                    std::lock_guard<std::mutex> lock(m_poolMutex);
+                    m_pool[{m_results[i].getRows(), m_results[i].getCols()}].push_back(std::move(m_results[i]));
+                    m_results[i] = Matrix<T>();
+                }
+
+                // A rows x cols buffer with unspecified contents.
+                Matrix<T> acquire(int rows, int cols) {
+                    {
+                        std::lock_guard<std::mutex> lock(m_poolMutex);
+                        auto found = m_pool.find({rows, cols});
+                        if (found != m_pool.end() && !found->second.empty()) {
+                            Matrix<T> buffer = std::move(found->second.back());
+                            found->second.pop_back();
+                            ++m_stats.buffersReused;
+                            return buffer;
+                        }
+                        ++m_stats.buffersAllocated;
+                    }
+                    return Matrix<T>(rows, cols);
+                }
+
+                // The buffer step i writes over: its stolen input, or a pooled one.
+                Matrix<T> target(int i) {
+                    const int j = m_steal[i];
+                    if (j < 0) {
+                        return acquire(m_order[i]->rows, m_order[i]->cols);
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(m_poolMutex);
+                        ++m_stats.buffersReused;
+                    }
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stolen[j] = true;
+                    return std::move(m_results[j]);
+                }
+
+                const Matrix<T>& valueOf(const StepPtr<T>& s) const {
+                    const int j = m_index.at(s.get());
+                    return s->kernel == Kernel::Input ? *s->matrix : m_results[j];
+                }
+
+                void execute(int i) {
+                    const Step<T>& s = *m_order[i];
+                    switch (s.kernel) {
+                        case Kernel::Transpose: runTranspose(i, s); break;
+                        case Kernel::Gemm: runGemm(i, s); break;
+                        case Kernel::Elementwise: runElementwise(i, s); break;
+                        case Kernel::Factor: runFactor(i, s); break;
+                        case Kernel::Solve: runSolve(i, s); break;
+                        default: break;
+                    }
+                }
+
+                void runTranspose(int i, const Step<T>& s) {
+                    LINEARCPP_TRACE_SCOPE("lazy_transpose", "lazy", s.rows);
+                    const Matrix<T>& source = valueOf(s.inputs[0]);
+                    Matrix<T> result = acquire(s.rows, s.cols);
+                    constexpr int tile = 32;
+                    const int sourceRows = source.getRows(), sourceCols = source.getCols();
+                    const T* in = source.data();
+                    T* out = result.data();
+                    parallel::parallelFor(0, (sourceRows + tile - 1) / tile, parallel::grainFor(2LL * tile * sourceCols),
+                                          [&](int blockBegin, int blockEnd) {
+                        for (int ib = blockBegin * tile; ib < std::min(sourceRows, blockEnd * tile); ib += tile) {
+                            for (int jb = 0; jb < sourceCols; jb += tile) {
+                                for (int r = ib; r < std::min(sourceRows, ib + tile); ++r) {
+                                    for (int c = jb; c < std::min(sourceCols, jb + tile); ++c) {
+                                        out[size_t(c) * sourceRows + r] = in[size_t(r) * sourceCols + c];
+                                    }
+                                }
+                            }
+                        }
+                    });
+                    m_results[i] = std::move(result);
+                }
+
+                void runGemm(int i, const Step<T>& s) {
+                    LINEARCPP_TRACE_SCOPE("lazy_gemm", "lazy", s.rows);
+                    const Matrix<T>& A = valueOf(s.inputs[0]);
+                    const Matrix<T>& B = valueOf(s.inputs[1]);
+                    const int k = A.getCols();
+                    if (s.inputs.size() == 2 && s.alpha == T(1)) {
+                        // The plain product takes the eager path: Strassen, BLAS or the budget plan.
+                        {
+                            std::lock_guard<std::mutex> lock(m_poolMutex);
+                            ++m_stats.buffersAllocated;
+                        }
+                        m_results[i] = A * B;
+                        return;
+                    }
+                    Matrix<T> C = s.inputs.size() == 3 ? target(i) : acquire(s.rows, s.cols);
+                    T* c = C.data();
+                    const size_t size = size_t(s.rows) * s.cols;
+                    if (s.inputs.size() == 2) {
+                        std::fill(c, c + size, T(0));
+                    } else if (m_steal[i] < 0) {
+                        const T* base = valueOf(s.inputs[2]).data();
+                        std::transform(base, base + size, c, [&](const T& x) { return s.beta * x; });
+                    } else if (s.beta != T(1)) {
+                        std::transform(c, c + size, c, [&](const T& x) { return s.beta * x; });
+                    }
+                    gemm::multiplyAdd(s.rows, s.cols, k, s.alpha, A.data(), k, B.data(), s.cols, c, s.cols);
+                    m_results[i] = std::move(C);
+                }
+
+                void runElementwise(int i, const Step<T>& s) {
+                    LINEARCPP_TRACE_SCOPE("lazy_elementwise", "lazy", int(s.program.size()));
+                    std::vector<const T*> inputs;
+                    for (const auto& input : s.inputs) {
+                        inputs.push_back(valueOf(input).data());
+                    }
+                    Matrix<T> result = target(i);
+                    T* out = result.data();
+                    const long long size = (long long)s.rows * s.cols;
+                    // The program runs on tiles of elements held in a small stack, so each
+                    // instruction is one tight loop; the tile is written last, which makes
+                    // writing over an input safe.
+                    constexpr int tile = 256;
+                    const int tiles = int((size + tile - 1) / tile);
+                    parallel::parallelFor(0, tiles, parallel::grainFor((long long)tile * s.program.size()),
+                                          [&](int tileBegin, int tileEnd) {
+                        std::vector<T> stack(size_t(s.depth) * tile);
+                        for (int t = tileBegin; t < tileEnd; ++t) {
+                            const long long first = (long long)t * tile;
+                            const int length = int(std::min<long long>(tile, size - first));
+                            T* top = stack.data();  // one past the top tile
+                            for (const Instruction<T>& instruction : s.program) {
+                                switch (instruction.code) {
+                                    case Code::Load: {
+                                        const T* in = inputs[instruction.input] + first;
+                                        std::copy(in, in + length, top);
+                                        top += tile;
+                                        break;
+                                    }
+                                    case Code::Scale: {
+                                        T* x = top - tile;
+                                        for (int e = 0; e < length; ++e) x[e] *= instruction.scalar;
+                                        break;
+                                    }
+                                    default: {
+                                        top -= tile;
+                                        T* x = top - tile;
+                                        const T* y = top;
+                                        if (instruction.code == Code::Add) {
+                                            for (int e = 0; e < length; ++e) x[e] += y[e];
+                                        } else if (instruction.code == Code::Sub) {
+                                            for (int e = 0; e < length; ++e) x[e] -= y[e];
+                                        } else {
+                                            for (int e = 0; e < length; ++e) x[e] *= y[e];
+                                        }
+                                    }
+                                }
+                            }
+                            std::copy(stack.data(), stack.data() + length, out + first);
+                        }
+                    });
+                    m_results[i] = std::move(result);
+                }
+
+                void runFactor(int i, const Step<T>& s) {
+                    LINEARCPP_TRACE_SCOPE("lazy_factor", "lazy", s.rows);
+                    if constexpr (std::is_floating_point<T>::value || gemm::IsComplex<T>::value || PivotTraits<T>::exact) {
+                        m_factors[i] = std::make_shared<LUResult<T>>(decomposeLU(valueOf(s.inputs[0])));
+                    } else {
+                        (void)i;
+                        (void)s;
+                    }
+                }
+
+                void runSolve(int i, const Step<T>& s) {
+                    LINEARCPP_TRACE_SCOPE("lazy_solve", "lazy", s.cols);
+                    if constexpr (std::is_floating_point<T>::value || gemm::IsComplex<T>::value || PivotTraits<T>::exact) {
+                        const LUResult<T>& lu = *m_factors[m_index.at(s.inputs[0].get())];
+                        const Matrix<T>& B = valueOf(s.inputs[1]);
+                        Matrix<T> X = acquire(s.rows, s.cols);
+                        parallel::parallelFor(0, s.cols, parallel::grainFor(2LL * s.rows * s.rows),
+                                              [&](int colBegin, int colEnd) {
+                            std::vector<T> b(s.rows);
+                            for (int c = colBegin; c < colEnd; ++c) {
+                                for (int r = 0; r < s.rows; ++r) {
+                                    b[r] = B(r, c);
+                                }
+                                std::vector<T> x = ::solve(lu, b);
+                                for (int r = 0; r < s.rows; ++r) {
+                                    X(r, c) = x[r];
+                                }
+                            }
+                        });
+                        m_results[i] = std::move(X);
+                    } else {
+                        (void)i;
+                        (void)s;
+                    }
+                }
+        };
+
+    } // namespace detail
+
+    /**
+     * @brief Plans and runs several expressions as one graph, so their common
+     * subexpressions (equal kernels on the same operands, see Planner::intern) are computed
+     * once and their independent parts run concurrently.
+     * @param stats Receives what the planner did, if not null.
+     * @return The values of `outputs`, in order.
+     */
+    template <typename T>
+    std::vector<Matrix<T>> evaluate(const std::vector<Expr<T>>& outputs, Stats* stats = nullptr) {
+        Stats local;
+        Stats& record = stats ? *stats : local;
+        record = Stats();
+        std::vector<detail::StepPtr<T>> roots;
+        std::vector<detail::StepPtr<T>> order;
+        {
+            LINEARCPP_TRACE_SCOPE("lazy_plan", "lazy", int(outputs.size()));
+            detail::Planner<T> planner(record);
+            order = planner.plan(outputs, roots);
+        }
+        LINEARCPP_TRACE_SCOPE("lazy_run", "lazy", int(order.size()));
+        detail::Executor<T> executor(order, record);
+        executor.run();
+
+        std::vector<Matrix<T>> results;
+        for (size_t r = 0; r < roots.size(); ++r) {
+            const size_t first = std::find(roots.begin(), roots.end(), roots[r]) - roots.begin();
+            results.push_back(first < r ? results[first] : executor.take(executor.indexOf(roots[r].get())));
+        }
+        return results;
+    }
+
+    template <typename T>
+    Matrix<T> Expr<T>::eval() const {
+        return evaluate<T>({*this}).front();
+    }
+
+} // namespace lazy
+
+#endif // LAZY_HPP
@@ -1,8 +1,45 @@
+#ifndef LINEAR_SOLVER_HPP
+#define LINEAR_SOLVER_HPP
+
 #include "Matrix.hpp"
+#include "Blas.hpp"
+#include "Context.hpp"
+#include "Trace.hpp"
+#include "Metrics.hpp"
+#include "Parallel.hpp"
+#include "Gemm.hpp"
+#include "Tuning.hpp"
+#include "Instantiations.hpp"
 #include <vector>
 #include <cmath>
+#include <limits>
 #include <stdexcept>
 #include<type_traits>
+#include<algorithm>
+
+/**
+ * @brief Pivot selection policy of decomposeLU for element type T.
+ * * Floating-point types pick the entry of largest magnitude and treat magnitudes below 1e-15
+ * as null. Exact types (e.g. ModInt in Exact.hpp) specialize it with `exact = true`: any
+ * nonzero entry is a valid pivot and only an exact zero is null.
+ */
+template <typename T, typename = void>
+struct PivotTraits {
+    static constexpr bool exact = false;
+    static auto score(const T& x) { return std::abs(x); }
+    static bool isNull(const T& x) { return std::abs(x) < 1e-15; }
+};
+
+/**
+ * @brief Complex pivots are ranked by |re| + |im|, as in LAPACK's IZAMAX, which avoids a
+ * square root per candidate.
+ */
+template <typename T>
+struct PivotTraits<T, std::enable_if_t<gemm::IsComplex<T>::value>> {
+    static constexpr bool exact = false;
+    static auto score(const T& x) { return std::abs(x.real()) + std::abs(x.imag()); }
+    static bool isNull(const T& x) { return score(x) < 1e-15; }
+};
 
 /**
  * @brief Structure to store the results of an LU Decomposition with Partial Pivoting.
@@ -22,10 +59,13 @@ template <typename T>
      * * This function decomposes a square matrix into a lower triangular matrix (L)
      * and an upper triangular matrix (U). Partial pivoting is used to ensure
      * numerical stability by swapping rows to bring the largest absolute value
-     * to the pivot position.
+     * to the pivot position. Columns are processed in panels whose width comes from
+     * the host tuning profile, so the trailing updates run through the blocked GEMM.
+     * With an external LAPACK active (see Blas.hpp), the factorization is done by GETRF.
      * * @note This implementation requires floating-point types (float, double) to
-     * handle division and precision.
-     * * @tparam T Must be a floating-point type.
+     * handle division and precision, or an exact field type with a PivotTraits
+     * specialization such as ModInt<P>, for which the factorization is exact.
+     * * @tparam T A floating-point type or an exact field type.
      * @param A The square matrix to decompose.
      * @return An LUResult structure containing the packed LU matrix and permutation data.
      * @throws std::runtime_error If the matrix is singular (zero pivot encountered).
@@ -33,11 +73,14 @@ template <typename T>
     template <typename T>
 
     LUResult<T> decomposeLU(const Matrix<T>& A){
+        LINEARCPP_TRACE_SCOPE("decomposeLU", "solver", A.getRows());
+        LINEARCPP_METRICS_SCOPE(opMetrics, metrics::Op::Factor,
+            2.0 / 3.0 * A.getRows() * A.getRows() * A.getRows(), sizeof(T) * double(A.getRows()) * A.getRows());
         LUResult<T> result;
 
         static_assert(
-            std::is_floating_point<T>::value,
-            "LU decomposition requires floating-point types");
+            std::is_floating_point<T>::value || gemm::IsComplex<T>::value || PivotTraits<T>::exact,
+            "LU decomposition requires floating-point, complex or exact field types");
 
         int dim = A.getRows();
         result.LU = A;
@@ -48,41 +91,119 @@ template <typename T>
             result.P[i] = i;
         }
 
-        for(int i = 0; i < dim; ++i){
-            int maxIndex = i;
-            T maxVal = std::abs(result.LU(i,i));
-            for(int j = i + 1; j < dim; ++j){
-                if(std::abs(result.LU(j,i)) > maxVal){
-                    maxVal = std::abs(result.LU(j,i));
-                    maxIndex = j;
+        if(blas::active<T>()){
+            // LAPACK works on column-major storage: factor a transposed copy, then convert the
+            // sequential 1-based row interchanges into the permutation vector.
+            std::vector<T> colMajor(size_t(dim) * dim);
+            for(int i = 0; i < dim; ++i){
+                for(int j = 0; j < dim; ++j){
+                    colMajor[size_t(j) * dim + i] = A(i, j);
                 }
             }
-            if(maxIndex != i){
-                for(int j = i; j < dim; ++j){
-                    T tmp = result.LU(i,j);
-                    result.LU(i,j) = result.LU(maxIndex,j);
-                    result.LU(maxIndex,j) = tmp;
+            std::vector<blas::Int> pivots;
+            blas::getrf(dim, colMajor.data(), std::max(1, dim), pivots);
+            for(int i = 0; i < dim; ++i){
+                for(int j = 0; j < dim; ++j){
+                    result.LU(i, j) = colMajor[size_t(j) * dim + i];
+                }
+                int p = int(pivots[i]) - 1;
+                if(p != i){
+                    std::swap(result.P[i], result.P[p]);
+                    result.toggleSign *= -1;
                 }
-                
-                int tmp = result.P[i];
-                result.P[i] = result.P[maxIndex];
-                result.P[maxIndex] = tmp;
-                result.toggleSign *= -1;
             }
-            if (std::abs(result.LU(i, i)) < 1e-15)
+            for(int i = 0; i < dim; ++i){
+                if (PivotTraits<T>::isNull(result.LU(i, i)))
+                {
+                    throw std::runtime_error("Error: Singular matrix. Null pivot at index " + std::to_string(i));
+                }
+            }
+            return result;
+        }
+
+        // Right-looking blocked LU: factor a panel of columns with the unblocked algorithm,
+        // solve for the matching block row of U, then update the trailing submatrix with a
+        // single GEMM call, which is where almost all of the O(n^3) work happens.
+        int panel = std::max(1, tuning::profile().luPanel);
+        T* lu = result.LU.data();
+        // Progress counts the O(n^3) work: a panel at column k retires the part of
+        // dim^3 between (dim - k)^3 and (dim - k - kb)^3.
+        exec::Stage stage("lu", double(dim) * dim * dim);
+        double retired = 0.0;
+        for(int k = 0; k < dim; k += panel){
+            int kb = std::min(panel, dim - k);
+            stage.advance(retired);
+            retired = std::pow(double(dim - k), 3) - std::pow(double(dim - k - kb), 3);
             {
-                throw std::runtime_error("Error: Singular matrix. Null pivot at index " + std::to_string(i));
+                LINEARCPP_TRACE_SCOPE("lu_panel", "solver", k);
+                for(int i = k; i < k + kb; ++i){
+                    int maxIndex = i;
+                    auto maxVal = PivotTraits<T>::score(result.LU(i,i));
+                    for(int j = i + 1; j < dim; ++j){
+                        if(PivotTraits<T>::score(result.LU(j,i)) > maxVal){
+                            maxVal = PivotTraits<T>::score(result.LU(j,i));
+                            maxIndex = j;
+                        }
+                    }
+                    if(maxIndex != i){
+                        // Whole rows are swapped so the stored multipliers of L follow their row.
+                        for(int j = 0; j < dim; ++j){
+                            T tmp = result.LU(i,j);
+                            result.LU(i,j) = result.LU(maxIndex,j);
+                            result.LU(maxIndex,j) = tmp;
+                        }
+
+                        int tmp = result.P[i];
+                        result.P[i] = result.P[maxIndex];
+                        result.P[maxIndex] = tmp;
+                        result.toggleSign *= -1;
+                    }
+                    if (PivotTraits<T>::isNull(result.LU(i, i)))
+                    {
+                        throw std::runtime_error("Error: Singular matrix. Null pivot at index " + std::to_string(i));
+                    }
+                    // Rows below the pivot are updated independently, within the panel only.
+                    int grain = parallel::grainFor(2LL * (k + kb - i));
+                    parallel::parallelFor(i + 1, dim, grain, [&](int rowBegin, int rowEnd) {
+                        for (auto j = rowBegin; j < rowEnd; ++j)
+                        {
+                            T mult = result.LU(j, i) / result.LU(i, i);
+                            result.LU(j, i) = mult;
+                            for (auto c = i + 1; c < k + kb; ++c)
+                            {
+                                result.LU(j, c) -= mult * result.LU(i, c);
+                            }
+                        }
+                    });
+                }
+            }
+
+            int rest = dim - k - kb;
+            if(rest == 0){
+                break;
             }
-            for (auto j = i + 1; j < dim; ++j)
             {
-                T mult = result.LU(j, i) / result.LU(i, i);
-                result.LU(j, i) = mult;
-                for (auto k = i + 1; k < dim; ++k)
-                {
-                    result.LU(j, k) -= mult * result.LU(i, k);
+                LINEARCPP_TRACE_SCOPE("lu_trsm", "solver", k);
+                // U12 = L11^-1 * A12 by forward substitution (L11 is unit lower triangular).
+                for(int i = k + 1; i < k + kb; ++i){
+                    for(int p = k; p < i; ++p){
+                        T l = result.LU(i, p);
+                        for(int c = k + kb; c < dim; ++c){
+                            result.LU(i, c) -= l * result.LU(p, c);
+                        }
+                    }
                 }
             }
+            {
+                LINEARCPP_TRACE_SCOPE("lu_update", "solver", rest);
+                // A22 -= L21 * U12
+                gemm::multiplyAdd(rest, rest, kb, T(-1),
+                                  lu + (k + kb) * dim + k, dim,
+                                  lu + k * dim + k + kb, dim,
+                                  lu + (k + kb) * dim + k + kb, dim);
+            }
         }
+        stage.advance(retired);
 
         return result;
     }
@@ -101,6 +222,9 @@ template <typename T>
     template<typename T>
     std::vector<T> solve(const LUResult<T> &m_LU, const std::vector<T> &b){
         int dim = m_LU.LU.getRows();
+        LINEARCPP_TRACE_SCOPE("solve", "solver", dim);
+        LINEARCPP_METRICS_SCOPE(opMetrics, metrics::Op::Solve,
+            2.0 * dim * dim, sizeof(T) * (double(dim) * dim + 2.0 * dim));
 
         // Apply permutation to the vector b
         std::vector<T> pb(dim);
@@ -109,6 +233,13 @@ template <typename T>
             pb[i] = b[m_LU.P[i]];
         }
 
+        if(blas::active<T>()){
+            // The row-major LU read column-major holds L^T above and U^T below the diagonal.
+            blas::trsm('U', 'T', 'U', dim, 1, m_LU.LU.data(), std::max(1, dim), pb.data(), std::max(1, dim));
+            blas::trsm('L', 'T', 'N', dim, 1, m_LU.LU.data(), std::max(1, dim), pb.data(), std::max(1, dim));
+            return pb;
+        }
+
         // Forward Substitution (Ly = Pb)
         // L is unit lower triangular (diagonal is implicitly 1)
         std::vector<T> y(dim);
@@ -135,4 +266,254 @@ template <typename T>
             x[i] = (y[i] - sum) / m_LU.LU(i, i);
         }
         return x;
-    }
\ No newline at end of file
+    }
+
+    /**
+     * @brief Structure to store the result of a Cholesky Decomposition (A = L L^T).
+     * * Only the lower triangle of L is meaningful; the strict upper triangle is zero.
+     */
+    template <typename T>
+    struct CholeskyResult {
+    Matrix<T> L; //< Lower triangular factor.
+    };
+
+    /**
+     * @brief Performs the Cholesky Decomposition of a symmetric positive definite matrix.
+     * * Computes L row by row (Cholesky-Crout), so every inner product runs over two
+     * contiguous rows of L; the entries below each diagonal element are computed in
+     * parallel. Needs half the work of LU and no pivoting. With an external LAPACK active
+     * (see Blas.hpp), the factorization is done by POTRF.
+     * * @tparam T Must be a floating-point type.
+     * @param A The symmetric positive definite matrix; only its lower triangle is read.
+     * @return A CholeskyResult holding the lower triangular factor.
+     * @throws std::invalid_argument If the matrix is not square.
+     * @throws std::runtime_error If the matrix is not positive definite.
+     */
+    template <typename T>
+    CholeskyResult<T> decomposeCholesky(const Matrix<T>& A){
+        static_assert(
+            std::is_floating_point<T>::value,
+            "Cholesky decomposition requires floating-point types");
+        if (A.getRows() != A.getCols())
+        {
+            throw std::invalid_argument("Error: Cholesky decomposition requires a square matrix.");
+        }
+        int dim = A.getRows();
+        LINEARCPP_TRACE_SCOPE("decomposeCholesky", "solver", dim);
+        LINEARCPP_METRICS_SCOPE(opMetrics, metrics::Op::Factor,
+            1.0 / 3.0 * dim * dim * dim, sizeof(T) * double(dim) * dim);
+
+        CholeskyResult<T> result;
+        result.L = Matrix<T>(dim, dim);
+        T* l = result.L.data();
+
+        if(blas::active<T>()){
+            // The row-major lower triangle is the column-major upper triangle, which POTRF
+            // overwrites with U; read row-major, U is L = U^T. The rest stays zero.
+            for(int i = 0; i < dim; ++i){
+                for(int j = 0; j <= i; ++j){
+                    result.L(i, j) = A(i, j);
+                }
+            }
+            blas::Int info = blas::potrf(dim, l, std::max(1, dim));
+            if(info != 0){
+                throw std::runtime_error("Error: Matrix is not positive definite. Failure at index " +
+                                         std::to_string(int(info) - 1));
+            }
+            return result;
+        }
+
+        for(int j = 0; j < dim; ++j){
+            const T* rowJ = l + size_t(j) * dim;
+            T diagonal = A(j, j);
+            for(int k = 0; k < j; ++k){
+                diagonal -= rowJ[k] * rowJ[k];
+            }
+            if(!(diagonal > T(0))){
+                throw std::runtime_error("Error: Matrix is not positive definite. Failure at index " + std::to_string(j));
+            }
+            T pivot = std::sqrt(diagonal);
+            l[size_t(j) * dim + j] = pivot;
+            parallel::parallelFor(j + 1, dim, parallel::grainFor(2LL * j + 1), [&](int rowBegin, int rowEnd) {
+                for(int i = rowBegin; i < rowEnd; ++i){
+                    const T* rowI = l + size_t(i) * dim;
+                    T sum = A(i, j);
+                    for(int k = 0; k < j; ++k){
+                        sum -= rowI[k] * rowJ[k];
+                    }
+                    l[size_t(i) * dim + j] = sum / pivot;
+                }
+            });
+        }
+        return result;
+    }
+
+    /**
+     * @brief Solves the linear system Ax = b using a previously computed Cholesky decomposition.
+     * * Forward substitution solves Ly = b, backward substitution solves L^T x = y.
+     * * @tparam T Floating-point type of the elements.
+     * @param chol The CholeskyResult structure containing the factor L.
+     * @param b The right-hand side constant vector.
+     * @return A vector containing the solution x.
+     */
+    template<typename T>
+    std::vector<T> solve(const CholeskyResult<T> &chol, const std::vector<T> &b){
+        int dim = chol.L.getRows();
+        LINEARCPP_TRACE_SCOPE("solve", "solver", dim);
+        LINEARCPP_METRICS_SCOPE(opMetrics, metrics::Op::Solve,
+            2.0 * dim * dim, sizeof(T) * (double(dim) * dim / 2.0 + 2.0 * dim));
+        if (static_cast<int>(b.size()) != dim)
+        {
+            throw std::invalid_argument("Error: Right-hand side size does not match the matrix.");
+        }
+
+        std::vector<T> x(b);
+        if(blas::active<T>()){
+            // The row-major L read column-major is L^T (upper triangular).
+            blas::trsm('U', 'T', 'N', dim, 1, chol.L.data(), std::max(1, dim), x.data(), std::max(1, dim));
+            blas::trsm('U', 'N', 'N', dim, 1, chol.L.data(), std::max(1, dim), x.data(), std::max(1, dim));
+            return x;
+        }
+
+        for (auto i = 0; i < dim; ++i)
+        {
+            T sum = x[i];
+            for (auto j = 0; j < i; ++j)
+            {
+                sum -= chol.L(i, j) * x[j];
+            }
+            x[i] = sum / chol.L(i, i);
+        }
+        for (auto i = dim - 1; i >= 0; --i)
+        {
+            T sum = x[i];
+            for (auto j = i + 1; j < dim; ++j)
+            {
+                sum -= chol.L(j, i) * x[j];
+            }
+            x[i] = sum / chol.L(i, i);
+        }
+        return x;
+    }
+
+    /**
+     * @brief Solves Ax = b to double accuracy with a single-precision LU and iterative refinement.
+     * * A is factored once in float. Each step computes the residual r = b - Ax in double against
+     * A exactly as stored, solves for the correction with the float factors and updates x, until
+     * the normwise backward error falls below sqrt(n) * eps(double), as in LAPACK's DSGESV. This
+     * converges whenever cond(A) is well below 1 / eps(float); if the corrections stop
+     * shrinking, the system is solved again with a double LU instead.
+     * * S can be any real element type convertible to float, including the 16-bit bfloat16 and
+     * float16 of Half.hpp, so matrices kept in reduced precision are solved without widening
+     * them to double.
+     * @param A The square system matrix.
+     * @param b The right-hand side.
+     * @param maxIterations The refinement steps allowed before falling back to a double LU.
+     * @return The solution x.
+     * @throws std::invalid_argument If A is not square or b does not match it.
+     * @throws std::runtime_error If the matrix is singular.
+     */
+    template <typename S>
+    std::vector<double> solveRefined(const Matrix<S>& A, const std::vector<double>& b, int maxIterations = 30){
+        const int dim = A.getRows();
+        if (A.getCols() != dim)
+        {
+            throw std::invalid_argument("Error: Iterative refinement requires a square matrix.");
+        }
+        if (static_cast<int>(b.size()) != dim)
+        {
+            throw std::invalid_argument("Error: Right-hand side size does not match the matrix.");
+        }
+        LINEARCPP_TRACE_SCOPE("solveRefined", "solver", dim);
+
+        Matrix<float> lowA(dim, dim);
+        std::vector<double> rowNorms(dim, 0.0);
+        parallel::parallelFor(0, dim, parallel::grainFor(dim), [&](int rowBegin, int rowEnd){
+            for (int i = rowBegin; i < rowEnd; ++i)
+            {
+                for (int j = 0; j < dim; ++j)
+                {
+                    lowA(i, j) = static_cast<float>(A(i, j));
+                    rowNorms[i] += std::abs(static_cast<double>(A(i, j)));
+                }
+            }
+        });
+        const double normA = dim > 0 ? *std::max_element(rowNorms.begin(), rowNorms.end()) : 0.0;
+        LUResult<float> lu = decomposeLU(lowA);
+
+        auto normInf = [](const std::vector<double>& v){
+            double result = 0.0;
+            for (double value : v) result = std::max(result, std::abs(value));
+            return result;
+        };
+
+        std::vector<float> lowRhs(b.begin(), b.end());
+        std::vector<float> lowX = solve(lu, lowRhs);
+        std::vector<double> x(lowX.begin(), lowX.end());
+        std::vector<double> r(dim);
+        const double tolerance = std::sqrt(static_cast<double>(dim)) * std::numeric_limits<double>::epsilon();
+        double previousCorrection = std::numeric_limits<double>::infinity();
+
+        for (int iteration = 0; iteration <= maxIterations; ++iteration)
+        {
+            parallel::parallelFor(0, dim, parallel::grainFor(2LL * dim), [&](int rowBegin, int rowEnd){
+                for (int i = rowBegin; i < rowEnd; ++i)
+                {
+                    double sum = b[i];
+                    for (int j = 0; j < dim; ++j)
+                    {
+                        sum -= static_cast<double>(A(i, j)) * x[j];
+                    }
+                    r[i] = sum;
+                }
+            });
+            const double residual = normInf(r);
+            if (residual <= tolerance * normA * normInf(x))
+            {
+                return x;
+            }
+            if (iteration == maxIterations) break;
+
+            // Scale the residual so tiny corrections do not underflow in float.
+            for (int i = 0; i < dim; ++i) lowRhs[i] = static_cast<float>(r[i] / residual);
+            std::vector<float> correction = solve(lu, lowRhs);
+            double correctionNorm = 0.0;
+            for (int i = 0; i < dim; ++i)
+            {
+                double step = residual * correction[i];
+                x[i] += step;
+                correctionNorm = std::max(correctionNorm, std::abs(step));
+            }
+            if (!(correctionNorm < 0.5 * previousCorrection)) break;
+            previousCorrection = correctionNorm;
+        }
+
+        LINEARCPP_TRACE_SCOPE("solveRefinedFallback", "solver", dim);
+        Matrix<double> highA(dim, dim);
+        parallel::parallelFor(0, dim, parallel::grainFor(dim), [&](int rowBegin, int rowEnd){
+            for (int i = rowBegin; i < rowEnd; ++i)
+            {
+                for (int j = 0; j < dim; ++j)
+                {
+                    highA(i, j) = static_cast<double>(A(i, j));
+                }
+            }
+        });
+        return solve(decomposeLU(highA), b);
+    }
+
+#ifdef LINEARCPP_TEMPLATE
+#define LINEARCPP_LU_INSTANCE(T) \
+    LINEARCPP_TEMPLATE LUResult<T> decomposeLU<T>(const Matrix<T>&); \
+    LINEARCPP_TEMPLATE std::vector<T> solve<T>(const LUResult<T>&, const std::vector<T>&);
+LINEARCPP_ELEMENT_TYPES(LINEARCPP_LU_INSTANCE)
+#undef LINEARCPP_LU_INSTANCE
+#define LINEARCPP_SOLVER_INSTANCE(T) \
+    LINEARCPP_TEMPLATE CholeskyResult<T> decomposeCholesky<T>(const Matrix<T>&); \
+    LINEARCPP_TEMPLATE std::vector<T> solve<T>(const CholeskyResult<T>&, const std::vector<T>&); \
+    LINEARCPP_TEMPLATE std::vector<double> solveRefined<T>(const Matrix<T>&, const std::vector<double>&, int);
+LINEARCPP_REAL_TYPES(LINEARCPP_SOLVER_INSTANCE)
+#undef LINEARCPP_SOLVER_INSTANCE
+#endif
+
+#endif // LINEAR_SOLVER_HPP
@@ -4,8 +4,23 @@
 #include<vector>
 #include<iostream>
 #include<fstream>
+#include<iomanip>
+#include<charconv>
+#include<cctype>
+#include<cstdlib>
+#include<sstream>
+#include<type_traits>
+#include<limits>
 #include"Product.hpp"
 #include"Helper.hpp"
+#include"Trace.hpp"
+#include"Metrics.hpp"
+#include"Parallel.hpp"
+#include"Tuning.hpp"
+#include"Blas.hpp"
+#include"Context.hpp"
+#include"Plan.hpp"
+#include"Instantiations.hpp"
 
 /**
  * @brief A template-based Matrix class providing fundamental linear algebra operations.
@@ -21,6 +36,8 @@ class Matrix {
         int m_rows;
         int m_cols;
         std::vector<T> m_data; 
+
+        static constexpr int ioCheckpointRows = 256; //< Rows read or written between context checkpoints.
     public:
         /**
          * @brief Constructs a new Matrix with specified dimensions initialized to zero.
@@ -51,6 +68,17 @@ class Matrix {
             return m_cols;
         }
 
+        /**
+         * @brief Raw access to the row-major storage (leading dimension getCols()).
+         */
+        T* data() {
+            return m_data.data();
+        }
+
+        const T* data() const {
+            return m_data.data();
+        }
+
         /**
          * @brief Accesses the element at (row, col) for read/write operations.
          * @note Maps 2D coordinates to 1D vector index: [row * m_cols + col].
@@ -77,11 +105,13 @@ class Matrix {
                 throw std::invalid_argument("Matrix dimensions must agree for addition.");
             }
             Matrix<T> result(m_rows, m_cols);
-            for(auto i = 0; i < m_rows; ++i){
-                for(auto j = 0; j < m_cols; ++j){
-                    result(i,j) = (*this)(i,j) + other(i,j);
+            parallel::parallelFor(0, m_rows, parallel::grainFor(m_cols), [&](int rowBegin, int rowEnd){
+                for(auto i = rowBegin; i < rowEnd; ++i){
+                    for(auto j = 0; j < m_cols; ++j){
+                        result(i,j) = (*this)(i,j) + other(i,j);
+                    }
                 }
-            }
+            });
             return result;
         }
 
@@ -94,11 +124,13 @@ class Matrix {
                 throw std::invalid_argument("Matrix dimensions must agree for subtraction.");
             }
             Matrix<T> result(m_rows, m_cols);
-            for(auto i = 0; i < m_rows; ++i){
-                for(auto j = 0; j < m_cols; ++j){
-                    result(i,j) = (*this)(i,j) - other(i,j);
+            parallel::parallelFor(0, m_rows, parallel::grainFor(m_cols), [&](int rowBegin, int rowEnd){
+                for(auto i = rowBegin; i < rowEnd; ++i){
+                    for(auto j = 0; j < m_cols; ++j){
+                        result(i,j) = (*this)(i,j) - other(i,j);
+                    }
                 }
-            }
+            });
             return result;
         }
 
@@ -107,6 +139,9 @@ class Matrix {
          * * If the matrix size is below a specific threshold, it defaults to the
          * cache-optimized classical multiplication. Otherwise, it pads the matrices
          * to the nearest power of two and applies Strassen's algorithm.
+         * * Under a memory budget (see Memory.hpp) the schedule comes from planMultiply: the
+         * recursion may be cut short, run its products one at a time, or give way to the fused
+         * Strassen, which needs no padded copies or temporaries.
          * * @param other The right-hand side matrix.
          * @return The resulting product matrix, unpadded to original dimensions.
          */
@@ -114,29 +149,50 @@ class Matrix {
             if (m_cols != other.m_rows){
                 throw std::invalid_argument("Incompatible matrix dimensions for multiplication.");
             }
-            int treshold = 64; //soglia per passare al metodo classico
-            if(m_cols * m_rows < treshold || other.m_cols * other.m_rows < treshold){
-                //uso il metodo classico
+            LINEARCPP_TRACE_SCOPE("multiply", "matrix", m_rows);
+            LINEARCPP_METRICS_SCOPE(opMetrics, metrics::Op::Multiply,
+                2.0 * m_rows * m_cols * other.m_cols,
+                sizeof(T) * (double(m_rows) * m_cols + double(other.m_rows) * other.m_cols + double(m_rows) * other.m_cols));
+            if(blas::active<T>()){
+                // A vendor GEMM beats Strassen over it at practical sizes and keeps classical accuracy.
+                LINEARCPP_METRICS_ALGORITHM(opMetrics, metrics::Algorithm::Blas);
                 return matrixMultiply(*this, other);
             }
-            int maxDim = std::max({m_rows, m_cols, other.m_rows, other.m_cols});
-            int paddedSize = nextPowerOfTwo(maxDim);
-
-            Matrix<T> APadded = matrixPadding(*this, paddedSize);
-            Matrix<T> BPadded = matrixPadding(other, paddedSize);
-
-            Matrix<T> CPadded = strassenMultiply(APadded, BPadded);
-
-            return CPadded.matrixUnpadding(m_rows, other.m_cols);
+            // Reduced-precision storage types (bfloat16, float16) accumulate in float in the classical
+            // kernel, while Strassen would round every intermediate sum back to 16 bits. The
+            // branch is discarded at compile time: the Strassen kernels do not accept them.
+            constexpr bool storageOnly = std::numeric_limits<T>::is_specialized &&
+                !std::numeric_limits<T>::is_exact && !std::is_floating_point<T>::value;
+            if constexpr (storageOnly){
+                LINEARCPP_METRICS_ALGORITHM(opMetrics, metrics::Algorithm::Classical);
+                return matrixMultiply(*this, other);
+            } else {
+                int maxDim = std::max({m_rows, m_cols, other.m_rows, other.m_cols});
+                int treshold = tuning::profile().strassenCutoff; //soglia per passare al metodo classico
+                if(maxDim <= treshold){
+                    //uso il metodo classico
+                    LINEARCPP_METRICS_ALGORITHM(opMetrics, metrics::Algorithm::Classical);
+                    return matrixMultiply(*this, other);
+                }
+                MultiplyPlan plan = planMultiply<T>(m_rows, other.m_cols, m_cols);
+                if(plan.schedule == MultiplyPlan::Schedule::Classical){
+                    LINEARCPP_METRICS_ALGORITHM(opMetrics, metrics::Algorithm::Classical);
+                    return matrixMultiply(*this, other);
+                }
+                LINEARCPP_METRICS_ALGORITHM(opMetrics, metrics::Algorithm::Strassen);
+                return multiplyPlanned(*this, other, plan);
+            }
         }
 
         Matrix<T> operator* (T scalar) const{
             Matrix<T> result(m_rows, m_cols);
-            for(int i = 0; i < m_rows; ++i){
-                for(int j = 0; j < m_cols; ++j){
-                    result(i,j) = (*this)(i,j) * scalar;
+            parallel::parallelFor(0, m_rows, parallel::grainFor(m_cols), [&](int rowBegin, int rowEnd){
+                for(int i = rowBegin; i < rowEnd; ++i){
+                    for(int j = 0; j < m_cols; ++j){
+                        result(i,j) = (*this)(i,j) * scalar;
+                    }
                 }
-            }
+            });
             return result;
         }
         // algoritmo estrazione sottomatrici
@@ -210,6 +266,7 @@ class Matrix {
          * @throws std::runtime_error If file cannot be opened or data is missing.
          */
         static Matrix<T> fromFile(const std::string& filename){
+            LINEARCPP_TRACE_SCOPE("fromFile", "io");
             std::ifstream file(filename);
 
             if(!file.is_open()){
@@ -218,19 +275,125 @@ class Matrix {
 
             int rows, cols;
             file >> rows >> cols; 
+            LINEARCPP_METRICS_SCOPE(opMetrics, metrics::Op::Read, 0, sizeof(T) * double(rows) * cols);
             
             Matrix<T> res(rows,cols);
+            if constexpr (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value) {
+                // Read the body at once and parse it in parallel chunks split at whitespace.
+                std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+                exec::checkpoint();
+                size_t parsed = parseValues(text, res.m_data.data(), res.m_data.size());
+                if(parsed < res.m_data.size()){
+                    throw std::runtime_error("Error: Insufficient data in file " + filename);
+                }
+                return res;
+            }
+            exec::Stage stage("read", rows);
+            int reported = 0;
             for(int i = 0 ; i < rows; ++i){
                 for(int j = 0; j < cols; ++j){
                     if(!(file >> res(i,j))){
                         throw std::runtime_error("Error: Insufficient data in file " + filename);
                     }
                 }
+                if(i + 1 - reported == ioCheckpointRows || i + 1 == rows){
+                    stage.advance(i + 1 - reported);
+                    reported = i + 1;
+                }
             }
             return res;
         }
 
+        // strtod-family for floating point (portable to libc++), from_chars for integers,
+        // stream extraction for any other element type.
+        static bool parseToken(const char* begin, const char* end, T& value){
+            if constexpr (std::is_floating_point<T>::value) {
+                char* stop = nullptr;
+                if constexpr (std::is_same<T, float>::value) value = std::strtof(begin, &stop);
+                else if constexpr (std::is_same<T, double>::value) value = std::strtod(begin, &stop);
+                else value = std::strtold(begin, &stop);
+                return stop == end;
+            } else if constexpr (std::is_integral<T>::value) {
+                if(*begin == '+') ++begin;
+                auto parsed = std::from_chars(begin, end, value);
+                return parsed.ec == std::errc() && parsed.ptr == end;
+            } else {
+                std::istringstream stream(std::string(begin, end));
+                return static_cast<bool>(stream >> value) && stream.peek() == EOF;
+            }
+        }
+
+        /**
+         * @brief Parses up to `count` whitespace-separated numbers from `text` into `out`.
+         * * The text is cut into one chunk per thread at whitespace boundaries. A first
+         * parallel pass counts the tokens of each chunk, a prefix sum turns the counts into
+         * output offsets, and a second parallel pass converts the tokens in place.
+         * @return The number of values stored, stopping early at the first malformed token.
+         */
+        static size_t parseValues(const std::string& text, T* out, size_t count){
+            LINEARCPP_TRACE_SCOPE("parseValues", "io", static_cast<int64_t>(text.size()));
+            const char* data = text.data();
+            size_t length = text.size();
+            int chunks = std::max(1, std::min(parallel::numThreads(), static_cast<int>(length >> 16)));
+
+            std::vector<size_t> bounds(chunks + 1, length);
+            bounds[0] = 0;
+            for(int c = 1; c < chunks; ++c){
+                size_t pos = std::max(bounds[c - 1], length / chunks * c);
+                while(pos < length && !std::isspace(static_cast<unsigned char>(data[pos]))) ++pos;
+                bounds[c] = pos;
+            }
+
+            auto forEachToken = [&](int c, auto&& visit){
+                size_t pos = bounds[c];
+                size_t end = bounds[c + 1];
+                while(true){
+                    while(pos < end && std::isspace(static_cast<unsigned char>(data[pos]))) ++pos;
+                    if(pos >= end) return;
+                    size_t start = pos;
+                    while(pos < end && !std::isspace(static_cast<unsigned char>(data[pos]))) ++pos;
+                    if(!visit(data + start, data + pos)) return;
+                }
+            };
+
+            std::vector<size_t> offsets(chunks + 1, 0);
+            parallel::parallelFor(0, chunks, 1, [&](int first, int last){
+                for(int c = first; c < last; ++c){
+                    forEachToken(c, [&](const char*, const char*){ ++offsets[c + 1]; return true; });
+                }
+            });
+            for(int c = 0; c < chunks; ++c){
+                offsets[c + 1] += offsets[c];
+            }
+
+            std::vector<size_t> stored(chunks, 0);
+            exec::Stage stage("read", chunks);
+            parallel::parallelFor(0, chunks, 1, [&](int first, int last){
+                for(int c = first; c < last; ++c){
+                    size_t index = offsets[c];
+                    forEachToken(c, [&](const char* begin, const char* end){
+                        if(index >= count) return false;
+                        if(!parseToken(begin, end, out[index])) return false;
+                        ++index;
+                        ++stored[c];
+                        return true;
+                    });
+                    stage.advance();
+                }
+            });
+
+            // Values count only up to the first chunk that stopped early.
+            size_t total = 0;
+            for(int c = 0; c < chunks; ++c){
+                total += stored[c];
+                if(offsets[c] + stored[c] < std::min(offsets[c + 1], count)) break;
+            }
+            return std::min(total, count);
+        }
+
         void toFile(const std::string& filename) const{
+            LINEARCPP_TRACE_SCOPE("toFile", "io", m_rows);
+            LINEARCPP_METRICS_SCOPE(opMetrics, metrics::Op::Write, 0, sizeof(T) * double(m_rows) * m_cols);
             std::ofstream file(filename);
             if(!file.is_open()){
                 throw std::runtime_error("Error: Could not create output file.");
@@ -238,11 +401,17 @@ class Matrix {
 
             file << std::fixed << std::setprecision(2);
 
+            exec::Stage stage("write", m_rows);
+            int reported = 0;
             for(int i = 0; i < m_rows; i++){
                 for(int j = 0; j < m_cols; j++){
                     file << (*this)(i,j) << " "; //prende quello a destra di << e lo mette nello stream a sinistra
                 }
                 file << "\n";
+                if(i + 1 - reported == ioCheckpointRows || i + 1 == m_rows){
+                    stage.advance(i + 1 - reported);
+                    reported = i + 1;
+                }
             }
             file.close();
         }
@@ -260,8 +429,11 @@ class Matrix {
             if (m_rows != other.m_rows || m_cols != other.m_cols)
                 throw std::invalid_argument("Dimensions must match for Hadamard product");
             Matrix<T> result(m_rows, m_cols);
-            for (int i = 0; i < m_data.size(); ++i)
-                result.m_data[i] = m_data[i] * other.m_data[i];
+            int size = static_cast<int>(m_data.size());
+            parallel::parallelFor(0, size, parallel::grainFor(1), [&](int begin, int end){
+                for (int i = begin; i < end; ++i)
+                    result.m_data[i] = m_data[i] * other.m_data[i];
+            });
             return result;
         }
 
@@ -278,4 +450,10 @@ class Matrix {
 
 };
 
-#endif // MATRIX_HPP
\ No newline at end of file
+#ifdef LINEARCPP_TEMPLATE
+#define LINEARCPP_MATRIX_INSTANCE(T) LINEARCPP_TEMPLATE class Matrix<T>;
+LINEARCPP_ELEMENT_TYPES(LINEARCPP_MATRIX_INSTANCE)
+#undef LINEARCPP_MATRIX_INSTANCE
+#endif
+
+#endif // MATRIX_HPP
@@ -0,0 +1,129 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <cctype>
+#include <cstddef>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief Workspace budget of the multiply engine.
+ * * The budget bounds the temporary memory an operation may allocate on top of its operands
+ * and its result: padded copies, Strassen quadrants, operand sums and intermediate products,
+ * and GEMM packing buffers. Within it, operator* runs as much of the fast algorithm as fits
+ * (see planMultiply in Product.hpp): the full Strassen recursion, fewer explicit levels, the
+ * fused Strassen that only needs packing buffers, or the classical GEMM.
+ *
+ * The process-wide budget is read once from LINEARCPP_MEMORY_BUDGET ("512M", "2G", a plain
+ * byte count, or "0" / unset for unlimited) and can be replaced with setBudget(). A
+ * ScopedBudget overrides it for the operations the current thread runs in its scope.
+ */
+namespace memory {
+
+    constexpr size_t unlimited = 0; //< Budget value meaning "no limit".
+
+    /**
+     * @brief Parses a byte count with an optional K, M, G or T suffix (powers of 1024).
+     * @throws std::invalid_argument If the text is not a byte count.
+     */
+    inline size_t parseBytes(const std::string& text) {
+        size_t end = 0;
+        unsigned long long value = 0;
+        // std::stoull accepts a sign and wraps a negative count around to a huge budget.
+        const size_t first = text.find_first_not_of(" \t\n\v\f\r");
+        if (first != std::string::npos && text[first] == '-') {
+            throw std::invalid_argument("Error: Invalid memory size '" + text + "'.");
+        }
+        try {
+            value = std::stoull(text, &end);
+        } catch (const std::exception&) {
+            throw std::invalid_argument("Error: Invalid memory size '" + text + "'.");
+        }
+        std::string suffix = text.substr(end);
+        if (!suffix.empty() && (suffix.back() == 'B' || suffix.back() == 'b')) suffix.pop_back();
+        if (suffix.size() > 1) {
+            throw std::invalid_argument("Error: Invalid memory size '" + text + "'.");
+        }
+        int shift = 0;
+        if (!suffix.empty()) {
+            switch (std::toupper(static_cast<unsigned char>(suffix[0]))) {
+                case 'T': shift = 40; break;
+                case 'G': shift = 30; break;
+                case 'M': shift = 20; break;
+                case 'K': shift = 10; break;
+                default: throw std::invalid_argument("Error: Invalid memory size '" + text + "'.");
+            }
+        }
+        // Sizes that do not fit in size_t are rejected rather than wrapped around.
+        if (value > (std::numeric_limits<size_t>::max() >> shift)) {
+            throw std::invalid_argument("Error: Invalid memory size '" + text + "'.");
+        }
+        return static_cast<size_t>(value) << shift;
+    }
+
+    namespace detail {
+
+        inline size_t& globalBudget() {
+            static size_t budget = [] {
+                const char* env = std::getenv("LINEARCPP_MEMORY_BUDGET");
+                return env && *env ? parseBytes(env) : unlimited;
+            }();
+            return budget;
+        }
+
+        // Innermost ScopedBudget of the calling thread, or nullptr.
+        inline const size_t*& scopedBudget() {
+            thread_local const size_t* budget = nullptr;
+            return budget;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief The budget in effect on the calling thread, in bytes (unlimited if 0).
+     */
+    inline size_t budget() {
+        const size_t* scoped = detail::scopedBudget();
+        return scoped ? *scoped : detail::globalBudget();
+    }
+
+    /**
+     * @brief Replaces the process-wide budget. Must not be called while other threads run
+     * library operations.
+     */
+    inline void setBudget(size_t bytes) {
+        detail::globalBudget() = bytes;
+    }
+
+    /**
+     * @brief Sets the budget of the calling thread for the lifetime of the object, e.g.
+     * around a single product: { memory::ScopedBudget limit(256 << 20); C = A * B; }
+     */
+    class ScopedBudget {
+        private:
+            size_t m_bytes;
+            const size_t* m_previous;
+
+        public:
+            explicit ScopedBudget(size_t bytes) : m_bytes(bytes), m_previous(detail::scopedBudget()) {
+                detail::scopedBudget() = &m_bytes;
+            }
+            ~ScopedBudget() { detail::scopedBudget() = m_previous; }
+
+            ScopedBudget(const ScopedBudget&) = delete;
+            ScopedBudget& operator=(const ScopedBudget&) = delete;
+    };
+
+    /**
+     * @brief True if `bytes` of workspace fit in the current budget.
+     */
+    inline bool fits(double bytes) {
+        const size_t limit = budget();
+        return limit == unlimited || bytes <= static_cast<double>(limit);
+    }
+
+} // namespace memory
+
+#endif // MEMORY_HPP
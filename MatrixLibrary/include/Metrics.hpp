@@ -0,0 +1,349 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Cumulative per-operation statistics: call counts, FLOPs, bytes, chosen algorithm
+ * and log-linear (HDR-style) latency histograms.
+ * * Metrics are compiled in only when LINEARCPP_ENABLE_METRICS is defined (CMake option
+ * LINEARCPP_ENABLE_METRICS); otherwise the recording macros expand to nothing while
+ * metrics::snapshot() and metrics::writePrometheus() remain available and report zeros.
+ *
+ * Every thread updates its own shard of counters, so concurrent operations never touch
+ * the same cache lines. A snapshot sums all shards, including those of exited threads.
+ *
+ * Usage:
+ *   metrics::Snapshot s = metrics::snapshot();
+ *   double p99 = s.of(metrics::Op::Multiply).latencyQuantile(0.99);
+ *   metrics::writePrometheus("/var/lib/node_exporter/linearcpp.prom");
+ */
+
+namespace metrics {
+
+    enum class Op { Multiply, Factor, Solve, Read, Write, Count };
+
+    enum class Algorithm { None, Classical, Strassen, Blas, Count };
+
+    constexpr int kOpCount = static_cast<int>(Op::Count);
+    constexpr int kAlgorithmCount = static_cast<int>(Algorithm::Count);
+
+    inline const char* opName(Op op) {
+        static const char* names[kOpCount] = {"multiply", "factor", "solve", "read", "write"};
+        return names[static_cast<int>(op)];
+    }
+
+    inline const char* algorithmName(Algorithm algorithm) {
+        static const char* names[kAlgorithmCount] = {"none", "classical", "strassen", "blas"};
+        return names[static_cast<int>(algorithm)];
+    }
+
+    /**
+     * @brief Log-linear bucketing of nanosecond latencies.
+     * * Values below 2^kSubBits are counted exactly; above that, every power of two is
+     * split into 2^kSubBits equal sub-buckets, bounding the relative error of any
+     * reported quantile by 1/2^kSubBits (12.5%) over the whole 1 ns .. ~18 min range.
+     */
+    struct Histogram {
+        static constexpr int kSubBits = 3;
+        static constexpr int kSubBuckets = 1 << kSubBits;
+        static constexpr int kMaxExponent = 40;
+        static constexpr int kBuckets = (kMaxExponent - kSubBits + 2) * kSubBuckets;
+
+        static int bucketOf(uint64_t ns) {
+            if (ns < static_cast<uint64_t>(kSubBuckets)) {
+                return static_cast<int>(ns);
+            }
+            int exponent = 63 - __builtin_clzll(ns);
+            if (exponent > kMaxExponent) {
+                return kBuckets - 1;
+            }
+            int sub = static_cast<int>((ns >> (exponent - kSubBits)) & (kSubBuckets - 1));
+            return (exponent - kSubBits + 1) * kSubBuckets + sub;
+        }
+
+        // Upper bound (exclusive) of a bucket, in nanoseconds.
+        static uint64_t upperBoundOf(int bucket) {
+            if (bucket < kSubBuckets) {
+                return static_cast<uint64_t>(bucket) + 1;
+            }
+            int exponent = bucket / kSubBuckets + kSubBits - 1;
+            uint64_t sub = static_cast<uint64_t>(bucket % kSubBuckets);
+            return (uint64_t(1) << exponent) + ((sub + 1) << (exponent - kSubBits));
+        }
+    };
+
+    /**
+     * @brief Aggregated statistics of one operation at snapshot time.
+     */
+    struct OpStats {
+        uint64_t calls = 0;
+        uint64_t flops = 0;
+        uint64_t bytes = 0;
+        uint64_t latencySumNs = 0;
+        std::array<uint64_t, kAlgorithmCount> algorithmCalls{};
+        std::array<uint64_t, Histogram::kBuckets> latencyBuckets{};
+
+        /**
+         * @brief Estimated latency quantile in seconds (upper bound of the bucket).
+         * @param q Quantile in [0, 1], e.g. 0.99 for p99.
+         */
+        double latencyQuantile(double q) const {
+            uint64_t completed = 0;
+            for (uint64_t c : latencyBuckets) completed += c;
+            if (completed == 0) return 0.0;
+            uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(completed - 1)) + 1;
+            uint64_t seen = 0;
+            for (int b = 0; b < Histogram::kBuckets; ++b) {
+                seen += latencyBuckets[b];
+                if (seen >= rank) {
+                    return static_cast<double>(Histogram::upperBoundOf(b)) * 1e-9;
+                }
+            }
+            return static_cast<double>(Histogram::upperBoundOf(Histogram::kBuckets - 1)) * 1e-9;
+        }
+    };
+
+    struct Snapshot {
+        std::array<OpStats, kOpCount> ops{};
+
+        const OpStats& of(Op op) const { return ops[static_cast<int>(op)]; }
+    };
+
+} // namespace metrics
+
+#ifdef LINEARCPP_ENABLE_METRICS
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace metrics {
+
+    namespace detail {
+
+        /**
+         * @brief Counters owned by one thread. Only the owner increments them; readers
+         * take relaxed loads, which is enough for monotonically growing totals.
+         */
+        struct alignas(64) Shard {
+            struct PerOp {
+                std::atomic<uint64_t> calls{0};
+                std::atomic<uint64_t> flops{0};
+                std::atomic<uint64_t> bytes{0};
+                std::atomic<uint64_t> latencySumNs{0};
+                std::atomic<uint64_t> algorithmCalls[kAlgorithmCount] = {};
+                std::atomic<uint64_t> latencyBuckets[Histogram::kBuckets] = {};
+            };
+            PerOp ops[kOpCount];
+        };
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<Shard>> shards;
+        };
+
+        inline Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        inline Shard& localShard() {
+            thread_local std::shared_ptr<Shard> shard = [] {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                reg.shards.push_back(std::make_shared<Shard>());
+                return reg.shards.back();
+            }();
+            return *shard;
+        }
+
+        inline void add(std::atomic<uint64_t> &counter, uint64_t value) {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief RAII recorder for one operation: counts the call, its FLOPs and bytes on
+     * construction and its latency on destruction.
+     */
+    class OpTimer {
+        public:
+            OpTimer(Op op, uint64_t flops, uint64_t bytes)
+                : m_op(op), m_algorithm(Algorithm::None),
+                  m_start(std::chrono::steady_clock::now()) {
+                detail::Shard::PerOp &slot = detail::localShard().ops[static_cast<int>(op)];
+                detail::add(slot.calls, 1);
+                detail::add(slot.flops, flops);
+                detail::add(slot.bytes, bytes);
+            }
+
+            ~OpTimer() {
+                uint64_t ns = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - m_start).count());
+                detail::Shard::PerOp &slot = detail::localShard().ops[static_cast<int>(m_op)];
+                detail::add(slot.latencySumNs, ns);
+                detail::add(slot.latencyBuckets[Histogram::bucketOf(ns)], 1);
+                detail::add(slot.algorithmCalls[static_cast<int>(m_algorithm)], 1);
+            }
+
+            void setAlgorithm(Algorithm algorithm) { m_algorithm = algorithm; }
+
+            OpTimer(const OpTimer&) = delete;
+            OpTimer& operator=(const OpTimer&) = delete;
+
+        private:
+            Op m_op;
+            Algorithm m_algorithm;
+            std::chrono::steady_clock::time_point m_start;
+    };
+
+    inline Snapshot snapshot() {
+        Snapshot result;
+        std::lock_guard<std::mutex> lock(detail::registry().mutex);
+        for (const auto &shard : detail::registry().shards) {
+            for (int op = 0; op < kOpCount; ++op) {
+                const detail::Shard::PerOp &src = shard->ops[op];
+                OpStats &dst = result.ops[op];
+                dst.calls += src.calls.load(std::memory_order_relaxed);
+                dst.flops += src.flops.load(std::memory_order_relaxed);
+                dst.bytes += src.bytes.load(std::memory_order_relaxed);
+                dst.latencySumNs += src.latencySumNs.load(std::memory_order_relaxed);
+                for (int a = 0; a < kAlgorithmCount; ++a) {
+                    dst.algorithmCalls[a] += src.algorithmCalls[a].load(std::memory_order_relaxed);
+                }
+                for (int b = 0; b < Histogram::kBuckets; ++b) {
+                    dst.latencyBuckets[b] += src.latencyBuckets[b].load(std::memory_order_relaxed);
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Zeroes all counters. Operations still running may be partially counted.
+     */
+    inline void reset() {
+        std::lock_guard<std::mutex> lock(detail::registry().mutex);
+        for (auto &shard : detail::registry().shards) {
+            for (auto &slot : shard->ops) {
+                slot.calls.store(0, std::memory_order_relaxed);
+                slot.flops.store(0, std::memory_order_relaxed);
+                slot.bytes.store(0, std::memory_order_relaxed);
+                slot.latencySumNs.store(0, std::memory_order_relaxed);
+                for (auto &c : slot.algorithmCalls) c.store(0, std::memory_order_relaxed);
+                for (auto &c : slot.latencyBuckets) c.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+} // namespace metrics
+
+#define LINEARCPP_METRICS_SCOPE(name, op, flops, bytes) \
+    metrics::OpTimer name(op, static_cast<uint64_t>(flops), static_cast<uint64_t>(bytes))
+#define LINEARCPP_METRICS_ALGORITHM(name, algorithm) name.setAlgorithm(algorithm)
+
+#else // !LINEARCPP_ENABLE_METRICS
+
+namespace metrics {
+    inline Snapshot snapshot() { return Snapshot(); }
+    inline void reset() {}
+} // namespace metrics
+
+#define LINEARCPP_METRICS_SCOPE(name, op, flops, bytes) ((void)0)
+#define LINEARCPP_METRICS_ALGORITHM(name, algorithm) ((void)0)
+
+#endif // LINEARCPP_ENABLE_METRICS
+
+#include <fstream>
+#include <stdexcept>
+
+namespace metrics {
+
+    /**
+     * @brief Writes the current snapshot in the Prometheus text exposition format.
+     * * Suitable for the node_exporter textfile collector. Latency histograms are exported
+     * with power-of-two second boundaries plus precomputed p50/p90/p99 gauges.
+     * @throws std::runtime_error If the output file cannot be created.
+     */
+    inline void writePrometheus(const std::string& filename) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error: Could not create metrics file " + filename);
+        }
+
+        Snapshot s = snapshot();
+
+        file << "# HELP linearcpp_op_calls_total Completed and running operations.\n"
+             << "# TYPE linearcpp_op_calls_total counter\n";
+        for (int op = 0; op < kOpCount; ++op) {
+            file << "linearcpp_op_calls_total{op=\"" << opName(static_cast<Op>(op)) << "\"} "
+                 << s.ops[op].calls << "\n";
+        }
+        file << "# HELP linearcpp_op_flops_total Floating-point operations performed.\n"
+             << "# TYPE linearcpp_op_flops_total counter\n";
+        for (int op = 0; op < kOpCount; ++op) {
+            file << "linearcpp_op_flops_total{op=\"" << opName(static_cast<Op>(op)) << "\"} "
+                 << s.ops[op].flops << "\n";
+        }
+        file << "# HELP linearcpp_op_bytes_total Bytes of operands read and results written.\n"
+             << "# TYPE linearcpp_op_bytes_total counter\n";
+        for (int op = 0; op < kOpCount; ++op) {
+            file << "linearcpp_op_bytes_total{op=\"" << opName(static_cast<Op>(op)) << "\"} "
+                 << s.ops[op].bytes << "\n";
+        }
+        file << "# HELP linearcpp_op_algorithm_total Completed operations by chosen algorithm.\n"
+             << "# TYPE linearcpp_op_algorithm_total counter\n";
+        for (int op = 0; op < kOpCount; ++op) {
+            for (int a = 0; a < kAlgorithmCount; ++a) {
+                if (s.ops[op].algorithmCalls[a] == 0) continue;
+                file << "linearcpp_op_algorithm_total{op=\"" << opName(static_cast<Op>(op))
+                     << "\",algorithm=\"" << algorithmName(static_cast<Algorithm>(a)) << "\"} "
+                     << s.ops[op].algorithmCalls[a] << "\n";
+            }
+        }
+
+        file << "# HELP linearcpp_op_latency_seconds Operation latency.\n"
+             << "# TYPE linearcpp_op_latency_seconds histogram\n";
+        for (int op = 0; op < kOpCount; ++op) {
+            const OpStats &stats = s.ops[op];
+            const char* name = opName(static_cast<Op>(op));
+            uint64_t completed = 0;
+            for (uint64_t c : stats.latencyBuckets) completed += c;
+
+            // Re-bucket at power-of-two boundaries: all sub-buckets of an exponent share le.
+            uint64_t cumulative = 0;
+            int bucket = 0;
+            for (int exponent = 0; exponent <= Histogram::kMaxExponent; ++exponent) {
+                uint64_t bound = uint64_t(1) << exponent;
+                while (bucket < Histogram::kBuckets && Histogram::upperBoundOf(bucket) <= bound) {
+                    cumulative += stats.latencyBuckets[bucket++];
+                }
+                file << "linearcpp_op_latency_seconds_bucket{op=\"" << name << "\",le=\""
+                     << static_cast<double>(bound) * 1e-9 << "\"} " << cumulative << "\n";
+            }
+            file << "linearcpp_op_latency_seconds_bucket{op=\"" << name << "\",le=\"+Inf\"} "
+                 << completed << "\n"
+                 << "linearcpp_op_latency_seconds_sum{op=\"" << name << "\"} "
+                 << static_cast<double>(stats.latencySumNs) * 1e-9 << "\n"
+                 << "linearcpp_op_latency_seconds_count{op=\"" << name << "\"} " << completed << "\n";
+        }
+
+        file << "# HELP linearcpp_op_latency_quantile_seconds Latency quantiles from the HDR histogram.\n"
+             << "# TYPE linearcpp_op_latency_quantile_seconds gauge\n";
+        for (int op = 0; op < kOpCount; ++op) {
+            for (double q : {0.5, 0.9, 0.99}) {
+                file << "linearcpp_op_latency_quantile_seconds{op=\"" << opName(static_cast<Op>(op))
+                     << "\",quantile=\"" << q << "\"} " << s.ops[op].latencyQuantile(q) << "\n";
+            }
+        }
+    }
+
+} // namespace metrics
+
+#endif // METRICS_HPP
@@ -0,0 +1,335 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Context.hpp"
+#include "Trace.hpp"
+#include "Tuning.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief Shared thread pool and fork-join helpers used by the parallel kernels.
+ * * The library owns one global pool. Its size defaults to the LINEARCPP_NUM_THREADS
+ * environment variable, or to std::thread::hardware_concurrency() when unset, and can be
+ * changed with parallel::configure(). The calling thread always takes part in the work,
+ * so a pool of N threads runs N - 1 workers.
+ *
+ * Parallel regions do not nest: a parallelFor issued from inside another parallel region
+ * runs serially on the current thread. This keeps the outer level (e.g. the seven Strassen
+ * products) parallel without oversubscribing the machine or risking pool deadlock.
+ */
+namespace parallel {
+
+    /**
+     * @brief Worker thread placement.
+     * - None:    leave placement to the OS scheduler.
+     * - Compact: pin workers to consecutive allowed CPUs (shares caches, one socket first).
+     * - Scatter: pin workers round-robin across NUMA nodes (maximizes memory bandwidth).
+     */
+    enum class Affinity { None, Compact, Scatter };
+
+    inline const char* affinityName(Affinity affinity) {
+        switch (affinity) {
+            case Affinity::Compact: return "compact";
+            case Affinity::Scatter: return "scatter";
+            default: return "none";
+        }
+    }
+
+    namespace detail {
+
+        inline bool& inParallelRegion() {
+            thread_local bool flag = false;
+            return flag;
+        }
+
+        inline std::vector<int> parseCpuList(const std::string& list) {
+            std::vector<int> cpus;
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t end = list.find(',', pos);
+                if (end == std::string::npos) end = list.size();
+                std::string range = list.substr(pos, end - pos);
+                size_t dash = range.find('-');
+                if (!range.empty() && range[0] >= '0' && range[0] <= '9') {
+                    int lo = std::stoi(range.substr(0, dash));
+                    int hi = dash == std::string::npos ? lo : std::stoi(range.substr(dash + 1));
+                    for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+                }
+                pos = end + 1;
+            }
+            return cpus;
+        }
+
+        /**
+         * @brief CPUs this process may run on, ordered according to the placement policy.
+         * * Honors restrictions imposed by taskset or numactl, so policies compose with
+         * external NUMA binding.
+         */
+        inline std::vector<int> cpuOrder(Affinity affinity) {
+            std::vector<int> allowed;
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+                for (int c = 0; c < CPU_SETSIZE; ++c) {
+                    if (CPU_ISSET(c, &set)) allowed.push_back(c);
+                }
+            }
+#endif
+            if (affinity != Affinity::Scatter || allowed.empty()) {
+                return allowed;
+            }
+
+            // Group allowed CPUs by NUMA node, then interleave the nodes.
+            std::vector<std::vector<int>> nodes;
+            for (int node = 0;; ++node) {
+                std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                if (!file.is_open()) break;
+                std::string list;
+                std::getline(file, list);
+                std::vector<int> cpus;
+                for (int c : parseCpuList(list)) {
+                    if (std::find(allowed.begin(), allowed.end(), c) != allowed.end()) cpus.push_back(c);
+                }
+                if (!cpus.empty()) nodes.push_back(cpus);
+            }
+            if (nodes.size() < 2) {
+                return allowed;
+            }
+            std::vector<int> order;
+            for (size_t i = 0; order.size() < allowed.size(); ++i) {
+                for (const auto &node : nodes) {
+                    if (i < node.size()) order.push_back(node[i]);
+                }
+            }
+            return order;
+        }
+
+        inline void pinCurrentThread(int cpu) {
+#ifdef __linux__
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+            (void)cpu;
+#endif
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Fixed-size pool of worker threads executing queued tasks in FIFO order.
+     */
+    class ThreadPool {
+        public:
+            /**
+             * @param threads Total parallelism including the calling thread (>= 1).
+             * @param affinity Placement policy applied to the worker threads.
+             */
+            explicit ThreadPool(int threads, Affinity affinity = Affinity::None)
+                : m_threads(std::max(1, threads)), m_affinity(affinity), m_stop(false) {
+                std::vector<int> cpus = affinity == Affinity::None
+                    ? std::vector<int>() : detail::cpuOrder(affinity);
+                for (int w = 1; w < m_threads; ++w) {
+                    int cpu = cpus.empty() ? -1 : cpus[w % cpus.size()];
+                    m_workers.emplace_back([this, cpu] {
+                        if (cpu >= 0) detail::pinCurrentThread(cpu);
+                        workerLoop();
+                    });
+                }
+            }
+
+            ~ThreadPool() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+                m_cv.notify_all();
+                for (auto &worker : m_workers) {
+                    worker.join();
+                }
+            }
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            int size() const { return m_threads; }
+
+            Affinity affinity() const { return m_affinity; }
+
+            void enqueue(std::function<void()> task) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_tasks.push_back(std::move(task));
+                }
+                m_cv.notify_one();
+            }
+
+        private:
+            void workerLoop() {
+                detail::inParallelRegion() = true;
+                for (;;) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(m_mutex);
+                        m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                        if (m_stop && m_tasks.empty()) return;
+                        task = std::move(m_tasks.front());
+                        m_tasks.pop_front();
+                    }
+                    LINEARCPP_TRACE_SCOPE("task", "pool");
+                    task();
+                }
+            }
+
+            int m_threads;
+            Affinity m_affinity;
+            bool m_stop;
+            std::mutex m_mutex;
+            std::condition_variable m_cv;
+            std::deque<std::function<void()>> m_tasks;
+            std::vector<std::thread> m_workers;
+    };
+
+    namespace detail {
+
+        inline int defaultThreadCount() {
+            if (const char* env = std::getenv("LINEARCPP_NUM_THREADS")) {
+                int n = std::atoi(env);
+                if (n > 0) return n;
+            }
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        inline std::unique_ptr<ThreadPool>& poolSlot() {
+            static std::unique_ptr<ThreadPool> slot;
+            return slot;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Returns the global pool, creating it with the default size on first use.
+     */
+    inline ThreadPool& pool() {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            if (!detail::poolSlot()) {
+                detail::poolSlot().reset(new ThreadPool(detail::defaultThreadCount()));
+            }
+        });
+        return *detail::poolSlot();
+    }
+
+    /**
+     * @brief Replaces the global pool. Must not be called while library operations run.
+     * @param threads Total parallelism including the caller; 0 selects the default.
+     */
+    inline void configure(int threads, Affinity affinity = Affinity::None) {
+        pool();
+        detail::poolSlot().reset();
+        detail::poolSlot().reset(new ThreadPool(threads > 0 ? threads : detail::defaultThreadCount(), affinity));
+    }
+
+    inline int numThreads() {
+        return pool().size();
+    }
+
+    /**
+     * @brief Runs body(lo, hi) over [begin, end) split into chunks of at least `grain`.
+     * * Chunks are claimed dynamically from a shared counter by the caller and up to
+     * numThreads() - 1 workers, which balances uneven chunk costs. The first exception
+     * thrown by any chunk is rethrown in the caller after all chunks have stopped.
+     */
+    template <typename Body>
+    void parallelFor(int begin, int end, int grain, Body&& body) {
+        if (end <= begin) return;
+        grain = std::max(1, grain);
+        int chunks = (end - begin + grain - 1) / grain;
+        ThreadPool &workers = pool();
+        if (chunks == 1 || workers.size() == 1 || detail::inParallelRegion()) {
+            body(begin, end);
+            return;
+        }
+
+        struct State {
+            std::atomic<int> next{0};
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable done;
+            int running = 0;
+        };
+        auto state = std::make_shared<State>();
+
+        auto run = [state, begin, end, grain, chunks, &body] {
+            for (;;) {
+                int chunk = state->next.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= chunks || state->failed.load(std::memory_order_relaxed)) break;
+                int lo = begin + chunk * grain;
+                try {
+                    body(lo, std::min(end, lo + grain));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (!state->error) state->error = std::current_exception();
+                    state->failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        int helpers = std::min(workers.size() - 1, chunks - 1);
+        state->running = helpers;
+        // Helpers run under the caller's execution context (see Context.hpp).
+        const exec::detail::State context = exec::detail::state();
+        for (int h = 0; h < helpers; ++h) {
+            workers.enqueue([state, run, context] {
+                {
+                    exec::detail::StateGuard guard(context);
+                    run();
+                }
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (--state->running == 0) state->done.notify_one();
+            });
+        }
+
+        detail::inParallelRegion() = true;
+        run();
+        detail::inParallelRegion() = false;
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state] { return state->running == 0; });
+        if (state->error) std::rethrow_exception(state->error);
+    }
+
+    /**
+     * @brief Grain (in rows) giving each chunk roughly `minWork` units of work when a row
+     * costs `workPerRow`; used to avoid forking for small problems.
+     * @param minWork Minimum work per chunk; non-positive selects the tuned parallel grain.
+     */
+    inline int grainFor(long long workPerRow, long long minWork = 0) {
+        if (minWork <= 0) minWork = tuning::profile().parallelGrain;
+        if (workPerRow <= 0) return 1 << 30;
+        return static_cast<int>(std::max<long long>(1, minWork / workPerRow));
+    }
+
+} // namespace parallel
+
+#endif // PARALLEL_HPP
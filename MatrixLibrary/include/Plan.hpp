@@ -0,0 +1,34 @@
+#ifndef PLAN_HPP
+#define PLAN_HPP
+
+template<typename T> class Matrix;
+
+/**
+ * @brief How operator* computes a product within the memory budget (see Memory.hpp).
+ */
+struct MultiplyPlan {
+    enum class Schedule {
+        Classical, //< Blocked GEMM.
+        Fused,     //< strassenFusedMultiply: only packing buffers, no padding.
+        Recursive  //< Padded Strassen recursion (strassenBlocks).
+    };
+    Schedule schedule = Schedule::Classical;
+    int depth = 0;                //< Recursive: explicit Strassen levels (-1 unlimited); Fused: 1 or 2.
+    bool parallelProducts = true; //< Recursive: outermost products run as concurrent tasks.
+    double workspaceBytes = 0.0;  //< Estimated peak workspace beyond the operands and result.
+};
+
+/**
+ * @brief Chooses the schedule of an m x k by k x n product from the current memory budget.
+ * Defined in Product.hpp.
+ */
+template <typename T>
+MultiplyPlan planMultiply(int m, int n, int k);
+
+/**
+ * @brief Computes A * B with the schedule of `plan`. Defined in Product.hpp.
+ */
+template <typename T>
+Matrix<T> multiplyPlanned(const Matrix<T>& A, const Matrix<T>& B, const MultiplyPlan& plan);
+
+#endif // PLAN_HPP
@@ -2,18 +2,34 @@
 #define PRODUCT_HPP
 
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <vector>
 #include "Matrix.hpp"
+#include "Trace.hpp"
+#include "Parallel.hpp"
+#include "Gemm.hpp"
+#include "Helper.hpp"
+#include "Instantiations.hpp"
+#include "Context.hpp"
+#include "Memory.hpp"
+#include "Plan.hpp"
+#include "Tuning.hpp"
 
 //prodotto classico tra matrici 
 template<typename T> class Matrix;
 template <typename T>
 
 /**
- * @brief Performs standard matrix multiplication using a cache-friendly approach.
+ * @brief Performs standard matrix multiplication using a cache-blocked, packed kernel.
  * * This function implements the classical O(n^3) matrix multiplication algorithm.
- * It utilizes an "ikj" loop ordering instead of the traditional "ijk" to optimize
- * CPU cache performance by ensuring row-major contiguous memory access in the
- * innermost loop.
+ * The operands are split into blocks sized for the L1/L2/L3 caches and packed into
+ * contiguous slivers consumed by a register-tiled micro-kernel (see Gemm.hpp); the
+ * block sizes come from the host tuning profile. Row blocks of the result are computed
+ * in parallel on the thread pool.
  * * @tparam T The numeric type of the matrix elements.
  * @param A The left-hand side matrix of dimensions (rowsA x colsA).
  * @param B The right-hand side matrix of dimensions (colsA x colsB).
@@ -22,17 +38,538 @@ template <typename T>
 
 Matrix<T> matrixMultiply(const Matrix<T> &A, const Matrix<T> &B)
 {
+    LINEARCPP_TRACE_SCOPE("gemm", "kernel", A.getRows());
 
     Matrix<T> result(A.getRows(), B.getCols());
-    for (int i = 0; i < A.getRows(); ++i) {
-        for (int k = 0; k < A.getCols(); ++k) {
-            T tmp = A(i,k);
-            for (int j = 0; j < B.getCols(); ++j) {
-                result(i,j) += tmp * B(k,j);
+    gemm::multiplyAdd(A.getRows(), B.getCols(), A.getCols(), T(1),
+                      A.data(), A.getCols(), B.data(), B.getCols(), result.data(), result.getCols());
+    return result;
+}
+
+template <typename T>
+Matrix<T> strassenFusedMultiply(const Matrix<T>& A, const Matrix<T>& B, int levels = 1);
+
+namespace detail {
+
+    /**
+     * @brief Largest dense block that the Strassen recursion hands to the fused one- or
+     * two-level Strassen; above it, the cache-blocked operand sums no longer pay off against
+     * the temporaries of an explicit level.
+     */
+    constexpr int fusedStrassenLimit = 2048;
+
+    /**
+     * @brief Number of levels the Strassen recursion runs on an n x n block before reaching
+     * treshold or maxDepth (negative means unlimited).
+     */
+    inline int strassenLevels(int n, int treshold, int maxDepth) {
+        int levels = 0;
+        for (int size = n; size > treshold && (maxDepth < 0 || levels < maxDepth); size /= 2) {
+            ++levels;
+        }
+        return levels;
+    }
+
+    /**
+     * @brief Leading rows x cols corner of a block outside which all entries are known to be zero.
+     */
+    struct Extent {
+        int rows;
+        int cols;
+        bool zero() const { return rows <= 0 || cols <= 0; }
+    };
+
+    /**
+     * @brief Whether a block of the recursion can be handed to the fused Strassen: dense
+     * operands within fusedStrassenLimit whose remaining levels are ones the fused kernel runs
+     * itself, so the leaves, the depth and the result are those of the explicit recursion.
+     */
+    template <typename T>
+    bool fusedRemainder(int n, Extent ea, Extent eb, int treshold, int maxDepth) {
+        const bool dense = ea.rows == n && ea.cols == n && eb.rows == n && eb.cols == n;
+        const int levels = strassenLevels(n, treshold, maxDepth);
+        return dense && n <= fusedStrassenLimit && !blas::active<T>() && levels >= 1 && levels <= 2;
+    }
+
+    /**
+     * @brief Smallest extent holding both x and y.
+     */
+    inline Extent joinExtents(Extent x, Extent y) {
+        if (x.zero()) return y;
+        if (y.zero()) return x;
+        return Extent{std::max(x.rows, y.rows), std::max(x.cols, y.cols)};
+    }
+
+    /**
+     * @brief A Strassen operand: a quadrant, or a sum of quadrants, with its nonzero extent.
+     * `value` is left empty when the block is zero. `planned` is the extent strassenWorkspace
+     * counts, in which only the padding is known to be zero.
+     */
+    template <typename T>
+    struct StrassenBlock {
+        Matrix<T> value;
+        Extent extent{0, 0};
+        Extent planned{0, 0};
+        bool zero() const { return extent.zero(); }
+    };
+
+    /**
+     * @brief Operand extents of a block as strassenWorkspace counted them.
+     */
+    struct PlannedExtents {
+        Extent a;
+        Extent b;
+    };
+
+    /**
+     * @brief Whether the extent.rows x extent.cols block of M at (row, col) is all zero,
+     * stopping at the first nonzero entry.
+     */
+    template <typename T>
+    bool allZero(const Matrix<T>& M, int row, int col, Extent extent) {
+        for (int i = 0; i < extent.rows; ++i) {
+            const T* entries = M.data() + size_t(row + i) * M.getCols() + col;
+            for (int j = 0; j < extent.cols; ++j) {
+                if (entries[j] != T(0)) {
+                    return false;
+                }
             }
         }
+        return true;
     }
-    return result;
+
+    /**
+     * @brief Quadrant (x, y) of the n x n matrix M whose nonzeros lie in `extent`.
+     * * Quadrants beyond the extent (padding) are zero without being read; the others are
+     * scanned for structural zeros (e.g. the off-diagonal block of a block-triangular
+     * operand), stopping at the first nonzero entry.
+     */
+    template <typename T>
+    StrassenBlock<T> quadrant(const Matrix<T>& M, Extent extent, int x, int y) {
+        const int half = M.getRows() / 2;
+        StrassenBlock<T> block;
+        block.extent = {std::min(half, extent.rows - x * half), std::min(half, extent.cols - y * half)};
+        if (block.zero()) {
+            return block;
+        }
+        block.planned = block.extent;
+        if (allZero(M, x * half, y * half, block.extent)) {
+            block.extent = {0, 0};
+            return block;
+        }
+        block.value = M.getSubMatrix(x * half, y * half, half);
+        return block;
+    }
+
+    /**
+     * @brief Whether no quadrant of the n x n matrix M is a structural zero, i.e. whether the
+     * recursion would find nothing to skip at this level.
+     */
+    template <typename T>
+    bool denseQuadrants(const Matrix<T>& M) {
+        const int half = M.getRows() / 2;
+        for (int x = 0; x < 2; ++x) {
+            for (int y = 0; y < 2; ++y) {
+                if (allZero(M, x * half, y * half, Extent{half, half})) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief X + sign * Y, skipping the addition when either side is zero.
+     */
+    template <typename T>
+    StrassenBlock<T> combine(const StrassenBlock<T>& X, const StrassenBlock<T>& Y, int sign) {
+        if (Y.zero()) {
+            StrassenBlock<T> result = X;
+            result.planned = joinExtents(X.planned, Y.planned);
+            return result;
+        }
+        StrassenBlock<T> result;
+        result.extent = joinExtents(X.extent, Y.extent);
+        result.planned = joinExtents(X.planned, Y.planned);
+        result.value = X.zero() ? (sign > 0 ? Y.value : Y.value * T(-1))
+                                : (sign > 0 ? X.value + Y.value : X.value - Y.value);
+        return result;
+    }
+
+    /**
+     * @brief Strassen recursion on n x n power-of-two operands whose nonzeros lie in the
+     * extents ea and eb. Products with a zero operand are skipped, sums with a zero term are
+     * not formed, and the classical leaves multiply only the nonzero corners.
+     * * At each level the work of Strassen's seven products and of the eight block products
+     * of the classical split is estimated from the extents, and the cheaper split is taken:
+     * for dense quadrants that is Strassen (7 vs 8), while a block-triangular pair or a corner
+     * left with thin padding strips needs fewer than seven full-size products classically.
+     * * With parallelProducts, the products of the outermost level run as concurrent tasks,
+     * each holding its own operand sums and sub-recursion; otherwise they run one at a time,
+     * each with the whole pool, which keeps a single product's temporaries alive at once.
+     * * Dense blocks within reach of the fused Strassen run fused unless a quadrant turns out
+     * to be zero. With `planned` (the operand extents strassenWorkspace counted for this
+     * block), the choice follows the plan instead: a block counted as fused runs fused
+     * whatever zeros its operands hold, so the workspace stays within the estimate the
+     * product was planned under.
+     */
+    template <typename T>
+    Matrix<T> strassenBlocks(const Matrix<T>& A, Extent ea, const Matrix<T>& B, Extent eb,
+                             int treshold, int maxDepth, bool parallelProducts = true,
+                             const PlannedExtents* planned = nullptr) {
+        const int n = A.getRows();
+        if (ea.zero() || eb.zero()) {
+            return Matrix<T>(n, n);
+        }
+        if (n <= treshold || maxDepth == 0) {
+            Matrix<T> C(n, n);
+            gemm::multiplyAdd(ea.rows, eb.cols, std::min(ea.cols, eb.rows), T(1),
+                              A.data(), n, B.data(), n, C.data(), n);
+            return C;
+        }
+        const bool fused = planned ? fusedRemainder<T>(n, planned->a, planned->b, treshold, maxDepth)
+                                   : fusedRemainder<T>(n, ea, eb, treshold, maxDepth) && denseQuadrants(A) &&
+                                         denseQuadrants(B);
+        if (fused) {
+            // Dense operands with one or two levels left: run them with no temporaries (the
+            // fused kernel is the built-in one, so not when a vendor GEMM serves the leaves).
+            return strassenFusedMultiply(A, B, strassenLevels(n, treshold, maxDepth));
+        }
+        const int half = n / 2;
+        LINEARCPP_TRACE_SCOPE("strassen", "kernel", n);
+        const int depth = maxDepth < 0 ? maxDepth : maxDepth - 1;
+
+        StrassenBlock<T> a[2][2], b[2][2];
+        for (int x = 0; x < 2; ++x) {
+            for (int y = 0; y < 2; ++y) {
+                a[x][y] = quadrant(A, ea, x, y);
+                b[x][y] = quadrant(B, eb, x, y);
+            }
+        }
+
+        auto join = [](const StrassenBlock<T>& X, const StrassenBlock<T>& Y) {
+            return joinExtents(X.extent, Y.extent);
+        };
+        auto cost = [](Extent x, Extent y) {
+            return x.zero() || y.zero() ? 0.0 : double(x.rows) * std::min(x.cols, y.rows) * y.cols;
+        };
+        const double strassenCost =
+            cost(join(a[0][0], a[1][1]), join(b[0][0], b[1][1])) + cost(join(a[1][0], a[1][1]), b[0][0].extent) +
+            cost(a[0][0].extent, join(b[0][1], b[1][1])) + cost(a[1][1].extent, join(b[1][0], b[0][0])) +
+            cost(join(a[0][0], a[0][1]), b[1][1].extent) + cost(join(a[1][0], a[0][0]), join(b[0][0], b[0][1])) +
+            cost(join(a[0][1], a[1][1]), join(b[1][0], b[1][1]));
+        double classicalCost = 0.0;
+        for (int x = 0; x < 2; ++x) {
+            for (int y = 0; y < 2; ++y) {
+                for (int z = 0; z < 2; ++z) {
+                    classicalCost += cost(a[x][z].extent, b[z][y].extent);
+                }
+            }
+        }
+        const bool classical = classicalCost < strassenCost;
+
+        // The products are independent: at the outermost level they run as
+        // parallel tasks, deeper levels run serially inside each task.
+        StrassenBlock<T> M[8];
+        exec::Stage stage("strassen", classical ? 8 : 7);
+        auto product = [&](int index, const StrassenBlock<T>& X, const StrassenBlock<T>& Y) {
+            if (!X.zero() && !Y.zero()) {
+                const PlannedExtents sub{X.planned, Y.planned};
+                M[index].value = strassenBlocks(X.value, X.extent, Y.value, Y.extent, treshold, depth, true,
+                                                planned ? &sub : nullptr);
+                M[index].extent = {X.extent.rows, Y.extent.cols};
+            }
+            stage.advance();
+        };
+        struct Term { int product; int sign; };
+        std::vector<std::function<void()>> products;
+        std::vector<Term> terms[2][2];
+        if (classical) {
+            // C(x, y) = A(x, 0) B(0, y) + A(x, 1) B(1, y)
+            for (int x = 0; x < 2; ++x) {
+                for (int y = 0; y < 2; ++y) {
+                    for (int z = 0; z < 2; ++z) {
+                        const int index = 4 * x + 2 * y + z;
+                        products.push_back([&, x, y, z, index] { product(index, a[x][z], b[z][y]); });
+                        terms[x][y].push_back({index, 1});
+                    }
+                }
+            }
+        } else {
+            products = {
+                [&] { product(0, combine(a[0][0], a[1][1], 1), combine(b[0][0], b[1][1], 1)); },
+                [&] { product(1, combine(a[1][0], a[1][1], 1), b[0][0]); },
+                [&] { product(2, a[0][0], combine(b[0][1], b[1][1], -1)); },
+                [&] { product(3, a[1][1], combine(b[1][0], b[0][0], -1)); },
+                [&] { product(4, combine(a[0][0], a[0][1], 1), b[1][1]); },
+                [&] { product(5, combine(a[1][0], a[0][0], -1), combine(b[0][0], b[0][1], 1)); },
+                [&] { product(6, combine(a[0][1], a[1][1], -1), combine(b[1][0], b[1][1], 1)); },
+            };
+            // C11 = M1 + M4 - M5 + M7, C12 = M3 + M5, C21 = M2 + M4, C22 = M1 - M2 + M3 + M6
+            terms[0][0] = {{0, 1}, {3, 1}, {4, -1}, {6, 1}};
+            terms[0][1] = {{2, 1}, {4, 1}};
+            terms[1][0] = {{1, 1}, {3, 1}};
+            terms[1][1] = {{0, 1}, {1, -1}, {2, 1}, {5, 1}};
+        }
+        const int count = static_cast<int>(products.size());
+        parallel::parallelFor(0, count, parallelProducts ? 1 : count, [&](int first, int last) {
+            for (int p = first; p < last; ++p) {
+                products[p]();
+            }
+        });
+
+        // Each quadrant of C accumulates its products in place over their nonzero extents.
+        // C is allocated only now, so it is not held during the products' recursion.
+        Matrix<T> C(n, n);
+        parallel::parallelFor(0, 4, 1, [&](int first, int last) {
+            for (int q = first; q < last; ++q) {
+                const int x = q / 2, y = q % 2;
+                for (const Term& term : terms[x][y]) {
+                    const StrassenBlock<T>& P = M[term.product];
+                    for (int i = 0; i < P.extent.rows; ++i) {
+                        T* row = C.data() + size_t(x * half + i) * n + y * half;
+                        for (int j = 0; j < P.extent.cols; ++j) {
+                            if (term.sign > 0) row[j] += P.value(i, j);
+                            else row[j] -= P.value(i, j);
+                        }
+                    }
+                }
+            }
+        });
+        return C;
+    }
+
+    /**
+     * @brief A block of the 2^levels x 2^levels block grid with its sign in a Strassen sum.
+     */
+    struct GridTerm {
+        int row;
+        int col;
+        int sign;
+    };
+
+    /**
+     * @brief One product of a multi-level Strassen scheme: (sum a)(sum b), added to sum c.
+     */
+    struct StrassenProduct {
+        std::vector<GridTerm> a;
+        std::vector<GridTerm> b;
+        std::vector<GridTerm> c;
+    };
+
+    /**
+     * @brief The 7^levels products of Strassen's scheme applied `levels` times, as the
+     * Kronecker power of the one-level scheme: block (x, y) of level-l product t and block
+     * (x', y') of a product s one level down combine into block (2^l x + x', 2^l y + y').
+     */
+    inline std::vector<StrassenProduct> strassenProducts(int levels) {
+        // M1 = (A11 + A22)(B11 + B22), M2 = (A21 + A22) B11, M3 = A11 (B12 - B22),
+        // M4 = A22 (B21 - B11), M5 = (A11 + A12) B22, M6 = (A21 - A11)(B11 + B12),
+        // M7 = (A12 - A22)(B21 + B22); C11 = M1 + M4 - M5 + M7, C12 = M3 + M5,
+        // C21 = M2 + M4, C22 = M1 - M2 + M3 + M6.
+        const std::vector<StrassenProduct> strassen = {
+            {{{0, 0, 1}, {1, 1, 1}}, {{0, 0, 1}, {1, 1, 1}}, {{0, 0, 1}, {1, 1, 1}}},
+            {{{1, 0, 1}, {1, 1, 1}}, {{0, 0, 1}}, {{1, 0, 1}, {1, 1, -1}}},
+            {{{0, 0, 1}}, {{0, 1, 1}, {1, 1, -1}}, {{0, 1, 1}, {1, 1, 1}}},
+            {{{1, 1, 1}}, {{1, 0, 1}, {0, 0, -1}}, {{0, 0, 1}, {1, 0, 1}}},
+            {{{0, 0, 1}, {0, 1, 1}}, {{1, 1, 1}}, {{0, 0, -1}, {0, 1, 1}}},
+            {{{1, 0, 1}, {0, 0, -1}}, {{0, 0, 1}, {0, 1, 1}}, {{1, 1, 1}}},
+            {{{0, 1, 1}, {1, 1, -1}}, {{1, 0, 1}, {1, 1, 1}}, {{0, 0, 1}}},
+        };
+        std::vector<StrassenProduct> products = {{{{0, 0, 1}}, {{0, 0, 1}}, {{0, 0, 1}}}};
+        for (int level = 0; level < levels; ++level) {
+            const int scale = 1 << level;
+            auto kron = [scale](const std::vector<GridTerm>& outer, const std::vector<GridTerm>& inner) {
+                std::vector<GridTerm> terms;
+                for (const GridTerm& o : outer) {
+                    for (const GridTerm& i : inner) {
+                        terms.push_back({o.row * scale + i.row, o.col * scale + i.col, o.sign * i.sign});
+                    }
+                }
+                return terms;
+            };
+            std::vector<StrassenProduct> next;
+            for (const StrassenProduct& outer : strassen) {
+                for (const StrassenProduct& inner : products) {
+                    next.push_back({kron(outer.a, inner.a), kron(outer.b, inner.b), kron(outer.c, inner.c)});
+                }
+            }
+            products = std::move(next);
+        }
+        return products;
+    }
+
+    /**
+     * @brief Bytes of the GEMM packing buffers for products n columns wide: one B panel
+     * and one A block per thread.
+     */
+    inline double gemmWorkspace(size_t elementSize, int n) {
+        const tuning::Profile& profile = tuning::profile();
+        const double panel = std::min(profile.gemmNC, n + gemm::NR);
+        return double(elementSize) * (double(profile.gemmKC) * panel +
+                                      double(parallel::numThreads()) * (profile.gemmMC + gemm::MR) * profile.gemmKC);
+    }
+
+    /**
+     * @brief Upper bound, in elements, of the memory strassenBlocks holds for an n x n
+     * product with operand extents ea and eb, including its own n x n result.
+     * * It follows the recursion: a level holds C, its nonzero quadrants and the block
+     * products, and every product in flight adds its two operand copies and its
+     * sub-recursion (whose result is the block product). `concurrent` products run at once
+     * at this level, deeper ones inside one task. Both the Strassen and the classical split
+     * are costed and the larger is kept, since the split is chosen later from the data.
+     * Dense levels handed to the fused Strassen hold only C.
+     */
+    template <typename T>
+    double strassenWorkspace(int n, Extent ea, Extent eb, int treshold, int maxDepth, int concurrent,
+                             std::map<std::array<int, 7>, double>& memo) {
+        if (ea.zero() || eb.zero() || n <= treshold || maxDepth == 0) {
+            return double(n) * n;
+        }
+        if (fusedRemainder<T>(n, ea, eb, treshold, maxDepth)) {
+            return double(n) * n;
+        }
+        const std::array<int, 7> key = {n, ea.rows, ea.cols, eb.rows, eb.cols, maxDepth, concurrent};
+        auto found = memo.find(key);
+        if (found != memo.end()) {
+            return found->second;
+        }
+        const int half = n / 2;
+        const double q = double(half) * half;
+        const int depth = maxDepth < 0 ? maxDepth : maxDepth - 1;
+        auto quadrantOf = [half](Extent e, int x, int y) {
+            Extent block{std::min(half, e.rows - x * half), std::min(half, e.cols - y * half)};
+            return block.zero() ? Extent{0, 0} : block;
+        };
+        auto sumOf = [&](Extent e, const std::vector<GridTerm>& terms) {
+            Extent sum{0, 0};
+            for (const GridTerm& t : terms) {
+                Extent block = quadrantOf(e, t.row, t.col);
+                if (block.zero()) continue;
+                sum = sum.zero() ? block : Extent{std::max(sum.rows, block.rows), std::max(sum.cols, block.cols)};
+            }
+            return sum;
+        };
+        double quadrants = 0.0;
+        for (int x = 0; x < 2; ++x) {
+            for (int y = 0; y < 2; ++y) {
+                quadrants += (quadrantOf(ea, x, y).zero() ? 0.0 : q) + (quadrantOf(eb, x, y).zero() ? 0.0 : q);
+            }
+        }
+        auto total = [&](const std::vector<std::pair<Extent, Extent>>& operands) {
+            std::vector<double> inFlight;
+            for (const auto& operand : operands) {
+                if (operand.first.zero() || operand.second.zero()) continue;
+                inFlight.push_back(2 * q + strassenWorkspace<T>(half, operand.first, operand.second,
+                                                                treshold, depth, 1, memo));
+            }
+            std::sort(inFlight.begin(), inFlight.end(), std::greater<double>());
+            double bytes = double(n) * n + quadrants;
+            for (size_t p = 0; p < inFlight.size(); ++p) {
+                bytes += p < size_t(concurrent) ? inFlight[p] - q : q;
+            }
+            return bytes;
+        };
+        std::vector<std::pair<Extent, Extent>> strassen, classical;
+        for (const StrassenProduct& product : strassenProducts(1)) {
+            strassen.push_back({sumOf(ea, product.a), sumOf(eb, product.b)});
+        }
+        for (int x = 0; x < 2; ++x) {
+            for (int y = 0; y < 2; ++y) {
+                for (int z = 0; z < 2; ++z) {
+                    classical.push_back({quadrantOf(ea, x, z), quadrantOf(eb, z, y)});
+                }
+            }
+        }
+        const double bytes = std::max(total(strassen), total(classical));
+        memo[key] = bytes;
+        return bytes;
+    }
+
+} // namespace detail
+
+/**
+ * @brief Chooses the schedule of an m x k by k x n product from the current memory budget.
+ * * Candidates, in order: the full padded Strassen recursion with concurrent products, the
+ * same with products run one at a time, then fewer explicit levels; the first whose
+ * estimated workspace fits is taken, so an unlimited budget keeps the full recursion.
+ * Otherwise the fused one- or two-level Strassen runs on the unpadded operands with only
+ * the GEMM packing buffers, which every schedule needs and which are the floor of any
+ * budget; the classical GEMM is left for sizes where Strassen does not pay.
+ */
+template <typename T>
+MultiplyPlan planMultiply(int m, int n, int k) {
+    const int treshold = tuning::profile().strassenCutoff;
+    const int maxDim = std::max({m, n, k});
+    const double gemmBytes = detail::gemmWorkspace(sizeof(T), n);
+    MultiplyPlan plan;
+    plan.workspaceBytes = gemmBytes;
+    if (maxDim <= treshold) {
+        return plan;
+    }
+    const int padded = int(nextPowerOfTwo(maxDim));
+    const double square = double(padded) * padded;
+    // Padded copies of the operands; the padded result is counted by strassenWorkspace and
+    // is the output itself only when no padding is cut off.
+    const double padding = (m != padded || k != padded ? square : 0.0) + (k != padded || n != padded ? square : 0.0) -
+                           (m == padded && n == padded ? square : 0.0);
+    const int levels = detail::strassenLevels(padded, treshold, -1);
+    const int concurrent = std::min(parallel::numThreads(), 8);
+    std::map<std::array<int, 7>, double> memo;
+    for (int depth = levels; depth >= 1; --depth) {
+        for (int running : {concurrent, 1}) {
+            const double bytes = gemmBytes + sizeof(T) *
+                (padding + detail::strassenWorkspace<T>(padded, detail::Extent{m, k}, detail::Extent{k, n}, treshold,
+                                                        depth == levels ? -1 : depth, running, memo));
+            if (memory::fits(bytes)) {
+                plan.schedule = MultiplyPlan::Schedule::Recursive;
+                plan.depth = depth == levels ? -1 : depth;
+                plan.parallelProducts = running == concurrent;
+                plan.workspaceBytes = bytes;
+                return plan;
+            }
+            if (concurrent == 1) break;
+        }
+    }
+    const int minDim = std::min({m, n, k});
+    if (minDim / 2 > treshold) {
+        plan.schedule = MultiplyPlan::Schedule::Fused;
+        plan.depth = minDim / 4 > treshold ? 2 : 1;
+    }
+    return plan;
+}
+
+/**
+ * @brief Computes A * B with the schedule chosen by planMultiply.
+ * * Fused runs strassenFusedMultiply on the operands as they are. Recursive pads them to the
+ * next power of two (operands already of that size are used in place) and runs the Strassen
+ * recursion to the plan's depth; the padding is known to be zero, so the recursion skips
+ * the products that only see it. Under a memory budget the recursion keeps to the fused
+ * levels the plan's workspace estimate counted (see detail::strassenBlocks).
+ */
+template <typename T>
+Matrix<T> multiplyPlanned(const Matrix<T>& A, const Matrix<T>& B, const MultiplyPlan& plan) {
+    if (plan.schedule == MultiplyPlan::Schedule::Classical) {
+        return matrixMultiply(A, B);
+    }
+    if (plan.schedule == MultiplyPlan::Schedule::Fused) {
+        return strassenFusedMultiply(A, B, plan.depth);
+    }
+    const int m = A.getRows(), k = A.getCols(), n = B.getCols();
+    const int paddedSize = int(nextPowerOfTwo(std::max({m, n, k})));
+    const bool padA = m != paddedSize || k != paddedSize;
+    const bool padB = k != paddedSize || n != paddedSize;
+    Matrix<T> APadded = padA ? A.matrixPadding(A, paddedSize) : Matrix<T>();
+    Matrix<T> BPadded = padB ? B.matrixPadding(B, paddedSize) : Matrix<T>();
+
+    const detail::PlannedExtents planned{detail::Extent{m, k}, detail::Extent{k, n}};
+    Matrix<T> CPadded = detail::strassenBlocks(padA ? APadded : A, planned.a, padB ? BPadded : B, planned.b,
+                                               tuning::profile().strassenCutoff, plan.depth, plan.parallelProducts,
+                                               memory::budget() != memory::unlimited ? &planned : nullptr);
+    if (m == paddedSize && n == paddedSize) {
+        return CPadded;
+    }
+    return CPadded.matrixUnpadding(m, n);
 }
 
 /**
@@ -40,57 +577,95 @@ Matrix<T> matrixMultiply(const Matrix<T> &A, const Matrix<T> &B)
  * * Strassen's algorithm reduces the asymptotic complexity of matrix multiplication
  * from O(n^3) to approximately O(n^2.807). It works by recursively partitioning
  * the matrices into four sub-blocks and calculating seven specific products (M1-M7).
+ * * The recursion tracks which quadrants are zero, whether from padding or from the
+ * structure of the input (e.g. block-triangular matrices): products with a zero operand are
+ * skipped, sums with a zero term are not formed, and levels where the classical block split
+ * needs less work than Strassen's seven products use it instead.
  * * @note This implementation uses a hybrid approach: when the matrix size falls
  * below a predefined threshold, it switches to the classical ikj multiplication
  * to avoid the overhead of recursive calls and temporary matrix allocations.
  * * @tparam T The numeric type of the matrix elements.
  * @param A The left-hand side square matrix.
  * @param B The right-hand side square matrix.
+ * @param treshold Size at or below which the classical multiplication is used
+ * (defaults to the tuned cutoff of the host profile).
+ * @param maxDepth Maximum number of recursion levels; negative means unlimited.
  * @return A new Matrix object containing the product A * B.
  */
 template<typename T>
 
-Matrix<T> strassenMultiply(const Matrix<T>& A, const Matrix<T>& B) {
+Matrix<T> strassenMultiply(const Matrix<T>& A, const Matrix<T>& B,
+                           int treshold = tuning::profile().strassenCutoff, int maxDepth = -1) {
     int n = A.getRows();
-
-    // Base case: switch to classical multiplication for small matrices to improve performance
-    int treshold = 64;
-    int newSize = n / 2;
-    if (n <= treshold) {
+    if (n <= treshold || maxDepth == 0) {
         return matrixMultiply(A, B);
-    }else{
-
-        Matrix<T> A11 = A.getSubMatrix(0, 0, newSize);
-        Matrix<T> A12 = A.getSubMatrix(0, newSize, newSize);
-        Matrix<T> A21 = A.getSubMatrix(newSize, 0, newSize);
-        Matrix<T> A22 = A.getSubMatrix(newSize, newSize, newSize);
-
-        Matrix<T> B11 = B.getSubMatrix(0, 0, newSize);
-        Matrix<T> B12 = B.getSubMatrix(0, newSize, newSize);
-        Matrix<T> B21 = B.getSubMatrix(newSize, 0, newSize);
-        Matrix<T> B22 = B.getSubMatrix(newSize, newSize, newSize);
-
-        Matrix<T> M1 = strassenMultiply(A11 + A22, B11 + B22);
-        Matrix<T> M2 = strassenMultiply(A21 + A22, B11);
-        Matrix<T> M3 = strassenMultiply(A11, B12 - B22);
-        Matrix<T> M4 = strassenMultiply(A22, B21 - B11);
-        Matrix<T> M5 = strassenMultiply(A11 + A12, B22);
-        Matrix<T> M6 = strassenMultiply(A21 - A11, B11 + B12);
-        Matrix<T> M7 = strassenMultiply(A12 - A22, B21 + B22);
-
-        Matrix<T> C11 = M1 + M4 - M5 + M7;
-        Matrix<T> C12 = M3 + M5;
-        Matrix<T> C21 = M2 + M4;
-        Matrix<T> C22 = M1 - M2 + M3 + M6;
+    }
+    return detail::strassenBlocks(A, detail::Extent{n, n}, B, detail::Extent{n, n}, treshold, maxDepth);
+}
 
-        Matrix<T> C(n, n);
-        C.setSubMatrix(0, 0, C11);
-        C.setSubMatrix(0, newSize, C12);
-        C.setSubMatrix(newSize, 0, C21);
-        C.setSubMatrix(newSize, newSize, C22);
-        return C;
+/**
+ * @brief Strassen's algorithm with the operand additions fused into the GEMM packing.
+ * * Instead of forming A11 + A22 and the other sums as temporary matrices, each of the 7
+ * (one level) or 49 (two levels) products reads its A and B blocks straight from the
+ * operands and sums them while packing the panels, and the micro-kernel adds its tile to
+ * every C block the product contributes to (see gemm::multiplyAddFused). The only extra
+ * memory is the GEMM's packing buffers, and the savings start at sizes where the
+ * temporaries of strassenMultiply would still cost more than the multiplication saved.
+ * * Any shape is accepted: the leading 2^levels-divisible part runs through the scheme and
+ * the remaining rows, columns and shared-dimension strip are added with the classical GEMM.
+ * @param levels Number of Strassen levels, 0 (classical), 1 or 2 (1 when omitted).
+ * @throws std::invalid_argument If the dimensions do not agree or levels is out of range.
+ */
+template <typename T>
+Matrix<T> strassenFusedMultiply(const Matrix<T>& A, const Matrix<T>& B, int levels) {
+    if (A.getCols() != B.getRows()) {
+        throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+    }
+    if (levels < 0 || (1 << (2 * levels)) > gemm::maxFusedTerms * gemm::maxFusedTerms) {
+        throw std::invalid_argument("Error: Fused Strassen supports zero, one or two levels.");
     }
-    
+    const int m = A.getRows(), n = B.getCols(), k = A.getCols();
+    const int grid = 1 << levels;
+    const int mb = m / grid, nb = n / grid, kb = k / grid;
+    if (levels == 0 || mb == 0 || nb == 0 || kb == 0) {
+        return matrixMultiply(A, B);
+    }
+    LINEARCPP_TRACE_SCOPE("strassen_fused", "kernel", m);
+    Matrix<T> C(m, n);
+    const int core = grid * mb, coreN = grid * nb, coreK = grid * kb;
+    const std::vector<detail::StrassenProduct> products = detail::strassenProducts(levels);
+    exec::Stage stage("strassen", double(products.size()));
+    for (const detail::StrassenProduct& product : products) {
+        gemm::Combination<const T*, T> a, b;
+        gemm::Combination<T*, T> c;
+        for (const detail::GridTerm& t : product.a) {
+            a.add(A.data() + size_t(t.row) * mb * k + size_t(t.col) * kb, T(t.sign));
+        }
+        for (const detail::GridTerm& t : product.b) {
+            b.add(B.data() + size_t(t.row) * kb * n + size_t(t.col) * nb, T(t.sign));
+        }
+        for (const detail::GridTerm& t : product.c) {
+            c.add(C.data() + size_t(t.row) * mb * n + size_t(t.col) * nb, T(t.sign));
+        }
+        gemm::multiplyAddFused(mb, nb, kb, T(1), a, k, b, n, c, n);
+        stage.advance();
+    }
+    // Fringes: the shared-dimension strip of the core, then the last rows and columns of C.
+    gemm::multiplyAdd(core, coreN, k - coreK, T(1), A.data() + coreK, k, B.data() + size_t(coreK) * n, n,
+                      C.data(), n);
+    gemm::multiplyAdd(core, n - coreN, k, T(1), A.data(), k, B.data() + coreN, n, C.data() + coreN, n);
+    gemm::multiplyAdd(m - core, n, k, T(1), A.data() + size_t(core) * k, k, B.data(), n,
+                      C.data() + size_t(core) * n, n);
+    return C;
 }
 
-#endif // PRODUCT_HPP
\ No newline at end of file
+#ifdef LINEARCPP_TEMPLATE
+#define LINEARCPP_PRODUCT_INSTANCE(T) \
+    LINEARCPP_TEMPLATE Matrix<T> matrixMultiply<T>(const Matrix<T>&, const Matrix<T>&); \
+    LINEARCPP_TEMPLATE Matrix<T> strassenMultiply<T>(const Matrix<T>&, const Matrix<T>&, int, int); \
+    LINEARCPP_TEMPLATE Matrix<T> strassenFusedMultiply<T>(const Matrix<T>&, const Matrix<T>&, int);
+LINEARCPP_ELEMENT_TYPES(LINEARCPP_PRODUCT_INSTANCE)
+#undef LINEARCPP_PRODUCT_INSTANCE
+#endif
+
+#endif // PRODUCT_HPP
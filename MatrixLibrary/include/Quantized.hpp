@@ -0,0 +1,465 @@
+#ifndef QUANTIZED_HPP
+#define QUANTIZED_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Matrix.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+#include "Tuning.hpp"
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Quantized GEMM: u8 x s8 and s16 x s16 products with int32 accumulation.
+ * * A real matrix is represented as scale * (q - zeroPoint) with integer q; scales and zero
+ * points are per tensor, per row (left operand) or per column (right operand). The product
+ * of two quantized matrices is accumulated exactly in integers on the raw q values, and
+ * the zero points are removed afterwards with row and column sums:
+ *   sum_p (a - za)(b - zb) = sum_p a b - za colsum(b) - zb rowsum(a) + k za zb.
+ * An epilogue then returns the int32 result, dequantizes it to float (with optional bias)
+ * or requantizes it to 8 bits, tile by tile while the accumulators are in cache.
+ *
+ * The right operand (typically the weights) is packed once into a PackedB and reused across
+ * calls: 16-column panels in which every group of 4 (8-bit) or 2 (16-bit) consecutive k
+ * values of a column is contiguous, one 64-byte vector per k group. The micro-kernel is
+ * chosen at compile time: AVX512-VNNI (vpdpbusd / vpdpwssd), AVX2 (pmaddwd; 8-bit values
+ * are widened first, since pmaddubsw saturates its 16-bit pair sums) or portable C++.
+ * Configure with -march=native (or a matching -m flag) to enable the SIMD kernels.
+ */
+namespace quant {
+
+    /**
+     * @brief Scales and zero points: one entry for a whole tensor, or one per row / column.
+     */
+    struct Params {
+        std::vector<float> scales{1.0f};
+        std::vector<int32_t> zeroPoints{0};
+
+        float scale(int i) const { return scales.size() == 1 ? scales[0] : scales[i]; }
+        int32_t zeroPoint(int i) const { return zeroPoints.size() == 1 ? zeroPoints[0] : zeroPoints[i]; }
+    };
+
+    enum class Granularity { PerTensor, PerRow, PerColumn };
+
+    template <typename T>
+    struct Quantized {
+        Matrix<T> values;
+        Params params;
+    };
+
+    /**
+     * @brief Name of the compiled micro-kernel ("avx512-vnni", "avx2" or "scalar").
+     */
+    inline const char* kernelName() {
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+        return "avx512-vnni";
+#elif defined(__AVX2__)
+        return "avx2";
+#else
+        return "scalar";
+#endif
+    }
+
+    /**
+     * @brief Quantizes X with min/max calibration: asymmetric (with zero point) for unsigned
+     * T, symmetric for signed T.
+     * @param bits Value bits to use, at most those of T; 16-bit GEMMs run fastest with
+     * about 12 bits, since fewer bits allow longer int32 accumulation runs.
+     */
+    template <typename T>
+    Quantized<T> quantize(const Matrix<float>& X, Granularity granularity = Granularity::PerTensor,
+                          int bits = 8 * sizeof(T)) {
+        static_assert(std::is_integral<T>::value, "Quantized type must be an integer type.");
+        const int rows = X.getRows(), cols = X.getCols();
+        const int groups = granularity == Granularity::PerTensor ? 1 : granularity == Granularity::PerRow ? rows : cols;
+        auto groupOf = [&](int i, int j) {
+            return granularity == Granularity::PerTensor ? 0 : granularity == Granularity::PerRow ? i : j;
+        };
+        std::vector<float> lo(groups, 0.0f), hi(groups, 0.0f);
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                int g = groupOf(i, j);
+                lo[g] = std::min(lo[g], X(i, j));
+                hi[g] = std::max(hi[g], X(i, j));
+            }
+        }
+        bits = std::max(2, std::min<int>(bits, 8 * sizeof(T)));
+        Quantized<T> result;
+        result.params.scales.assign(groups, 1.0f);
+        result.params.zeroPoints.assign(groups, 0);
+        double qmin, qmax;
+        if (std::is_signed<T>::value) {
+            qmax = std::ldexp(1.0, bits - 1) - 1;
+            qmin = -qmax;
+        } else {
+            qmin = 0;
+            qmax = std::ldexp(1.0, bits) - 1;
+        }
+        for (int g = 0; g < groups; ++g) {
+            if (std::is_signed<T>::value) {
+                double range = std::max(std::abs(lo[g]), std::abs(hi[g]));
+                result.params.scales[g] = range > 0 ? static_cast<float>(range / qmax) : 1.0f;
+            } else {
+                double range = double(hi[g]) - lo[g];
+                result.params.scales[g] = range > 0 ? static_cast<float>(range / qmax) : 1.0f;
+                result.params.zeroPoints[g] = static_cast<int32_t>(std::lround(qmin - lo[g] / result.params.scales[g]));
+            }
+        }
+        result.values = Matrix<T>(rows, cols);
+        for (int i = 0; i < rows; ++i) {
+            for (int j = 0; j < cols; ++j) {
+                int g = groupOf(i, j);
+                double q = std::nearbyint(X(i, j) / result.params.scales[g]) + result.params.zeroPoints[g];
+                result.values(i, j) = static_cast<T>(std::min(qmax, std::max(qmin, q)));
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Maps quantized values back to real numbers.
+     */
+    template <typename T>
+    Matrix<float> dequantize(const Quantized<T>& Q, Granularity granularity = Granularity::PerTensor) {
+        Matrix<float> X(Q.values.getRows(), Q.values.getCols());
+        for (int i = 0; i < X.getRows(); ++i) {
+            for (int j = 0; j < X.getCols(); ++j) {
+                int g = granularity == Granularity::PerTensor ? 0 : granularity == Granularity::PerRow ? i : j;
+                X(i, j) = Q.params.scale(g) * float(int32_t(Q.values(i, j)) - Q.params.zeroPoint(g));
+            }
+        }
+        return X;
+    }
+
+    namespace detail {
+
+        constexpr int MR = 8;  //< Rows of the register tile.
+        constexpr int NR = 16; //< Columns of a packed panel and of the register tile.
+
+        /**
+         * @brief Consecutive k values per packed group: one 32-bit lane holds a group.
+         */
+        template <typename T>
+        constexpr int groupSize() { return 4 / int(sizeof(T)); }
+
+        template <typename TA, typename TB>
+        constexpr bool supported() {
+            return (std::is_same<TA, uint8_t>::value && std::is_same<TB, int8_t>::value) ||
+                   (std::is_same<TA, int16_t>::value && std::is_same<TB, int16_t>::value);
+        }
+
+        template <typename T>
+        int32_t maxAbs(const T* data, size_t count) {
+            int32_t result = 0;
+            for (size_t i = 0; i < count; ++i) {
+                result = std::max(result, std::abs(int32_t(data[i])));
+            }
+            return result;
+        }
+
+        /**
+         * @brief c(MR x NR) = a(MR x 4 kq bytes, leading dimension lda) * b(kq packed groups),
+         * exact in int32 as long as the caller's run length respects the bound.
+         */
+        template <typename TA, typename TB>
+        void kernel(int kq, const TA* a, int lda, const TB* b, int32_t* c) {
+            constexpr int G = groupSize<TB>();
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+            __m512i acc[MR];
+            for (int r = 0; r < MR; ++r) acc[r] = _mm512_setzero_si512();
+            for (int q = 0; q < kq; ++q) {
+                __m512i bv = _mm512_loadu_si512(b + size_t(q) * NR * G);
+                for (int r = 0; r < MR; ++r) {
+                    int32_t group;
+                    std::memcpy(&group, a + size_t(r) * lda + q * G, sizeof(group));
+                    if constexpr (std::is_same<TB, int8_t>::value) {
+                        acc[r] = _mm512_dpbusd_epi32(acc[r], _mm512_set1_epi32(group), bv);
+                    } else {
+                        acc[r] = _mm512_dpwssd_epi32(acc[r], _mm512_set1_epi32(group), bv);
+                    }
+                }
+            }
+            for (int r = 0; r < MR; ++r) _mm512_storeu_si512(c + r * NR, acc[r]);
+#elif defined(__AVX2__)
+            if constexpr (std::is_same<TB, int16_t>::value) {
+                // Each 32-bit lane of b holds one column's k pair; pmaddwd yields its dot product.
+                for (int r0 = 0; r0 < MR; r0 += 4) {
+                    __m256i acc[4][2];
+                    for (int r = 0; r < 4; ++r) acc[r][0] = acc[r][1] = _mm256_setzero_si256();
+                    for (int q = 0; q < kq; ++q) {
+                        const __m256i* bp = reinterpret_cast<const __m256i*>(b + size_t(q) * NR * G);
+                        __m256i b0 = _mm256_loadu_si256(bp), b1 = _mm256_loadu_si256(bp + 1);
+                        for (int r = 0; r < 4; ++r) {
+                            int32_t pair;
+                            std::memcpy(&pair, a + size_t(r0 + r) * lda + q * G, sizeof(pair));
+                            __m256i av = _mm256_set1_epi32(pair);
+                            acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_madd_epi16(av, b0));
+                            acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_madd_epi16(av, b1));
+                        }
+                    }
+                    for (int r = 0; r < 4; ++r) {
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + (r0 + r) * NR), acc[r][0]);
+                        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + (r0 + r) * NR + 8), acc[r][1]);
+                    }
+                }
+            } else {
+                // Bytes are widened to 16 bits so pmaddwd stays exact; lane pairs hold the two
+                // halves of a column's 4-value group and are folded after the k loop.
+                for (int r0 = 0; r0 < MR; r0 += 2) {
+                    __m256i acc[2][4];
+                    for (int r = 0; r < 2; ++r)
+                        for (int v = 0; v < 4; ++v) acc[r][v] = _mm256_setzero_si256();
+                    for (int q = 0; q < kq; ++q) {
+                        const __m128i* bp = reinterpret_cast<const __m128i*>(b + size_t(q) * NR * G);
+                        __m256i bw[4];
+                        for (int v = 0; v < 4; ++v) bw[v] = _mm256_cvtepi8_epi16(_mm_loadu_si128(bp + v));
+                        for (int r = 0; r < 2; ++r) {
+                            const TA* ap = a + size_t(r0 + r) * lda + q * G;
+                            __m256i av = _mm256_set1_epi64x(int64_t(ap[0]) | int64_t(ap[1]) << 16 |
+                                                            int64_t(ap[2]) << 32 | int64_t(ap[3]) << 48);
+                            for (int v = 0; v < 4; ++v) {
+                                acc[r][v] = _mm256_add_epi32(acc[r][v], _mm256_madd_epi16(av, bw[v]));
+                            }
+                        }
+                    }
+                    for (int r = 0; r < 2; ++r) {
+                        alignas(32) int32_t halves[2 * NR];
+                        for (int v = 0; v < 4; ++v) {
+                            _mm256_store_si256(reinterpret_cast<__m256i*>(halves + 8 * v), acc[r][v]);
+                        }
+                        for (int j = 0; j < NR; ++j) c[(r0 + r) * NR + j] = halves[2 * j] + halves[2 * j + 1];
+                    }
+                }
+            }
+#else
+            for (int r = 0; r < MR; ++r) {
+                int32_t acc[NR] = {};
+                for (int q = 0; q < kq; ++q) {
+                    const TA* ap = a + size_t(r) * lda + q * G;
+                    const TB* bp = b + size_t(q) * NR * G;
+                    for (int j = 0; j < NR; ++j) {
+                        for (int g = 0; g < G; ++g) {
+                            acc[j] += int32_t(ap[g]) * int32_t(bp[j * G + g]);
+                        }
+                    }
+                }
+                std::memcpy(c + r * NR, acc, sizeof(acc));
+            }
+#endif
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Right-hand operand packed for the quantized micro-kernels, reusable across calls.
+     * @tparam TB int8_t (with uint8_t left operands) or int16_t (with int16_t left operands).
+     */
+    template <typename TB>
+    class PackedB {
+        private:
+            int m_rows;
+            int m_cols;
+            int m_groups;
+            int32_t m_maxAbs;
+            Params m_params;
+            std::vector<TB> m_data;
+            std::vector<int64_t> m_colSums;
+        public:
+            /**
+             * @param B The k x n quantized matrix.
+             * @param params Per-tensor or per-column scales and zero points of B.
+             */
+            explicit PackedB(const Matrix<TB>& B, Params params = Params())
+                : m_rows(B.getRows()), m_cols(B.getCols()), m_params(std::move(params)) {
+                constexpr int G = detail::groupSize<TB>();
+                constexpr int NR = detail::NR;
+                m_groups = (m_rows + G - 1) / G;
+                const int panels = (m_cols + NR - 1) / NR;
+                m_data.assign(size_t(panels) * m_groups * NR * G, TB(0));
+                m_colSums.assign(m_cols, 0);
+                m_maxAbs = detail::maxAbs(B.data(), size_t(m_rows) * m_cols);
+                for (int p = 0; p < m_rows; ++p) {
+                    for (int j = 0; j < m_cols; ++j) {
+                        size_t panel = j / NR;
+                        m_data[(panel * m_groups + p / G) * NR * G + (j % NR) * G + p % G] = B(p, j);
+                        m_colSums[j] += B(p, j);
+                    }
+                }
+            }
+
+            int getRows() const { return m_rows; }
+            int getCols() const { return m_cols; }
+            int groups() const { return m_groups; }
+            int32_t maxAbs() const { return m_maxAbs; }
+            const Params& params() const { return m_params; }
+            const std::vector<int64_t>& colSums() const { return m_colSums; }
+
+            /**
+             * @brief Packed k groups of the 16-column panel holding column j.
+             */
+            const TB* panel(int j) const {
+                return m_data.data() + size_t(j / detail::NR) * m_groups * detail::NR * detail::groupSize<TB>();
+            }
+    };
+
+    namespace detail {
+
+        /**
+         * @brief Blocked driver: column blocks of B sized to stay in L2, row tiles of A in
+         * parallel, k runs short enough to keep the int32 accumulators exact and folded into
+         * int64, then epilogue(i, j0, count, corrected) per row segment of the result.
+         * @throws std::overflow_error If even a single k group could overflow int32.
+         */
+        template <typename TA, typename TB, typename Epilogue>
+        void run(const Matrix<TA>& A, const Params& pa, const PackedB<TB>& B, const Epilogue& epilogue) {
+            static_assert(supported<TA, TB>(), "Supported quantized products: u8 x s8 and s16 x s16.");
+            if (A.getCols() != B.getRows()) {
+                throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+            }
+            constexpr int G = groupSize<TB>();
+            const int m = A.getRows(), n = B.getCols(), k = A.getCols();
+            if (m == 0 || n == 0) return;
+
+            // Longest run of k groups whose int32 sum cannot overflow.
+            const int64_t perGroup = int64_t(G) * maxAbs(A.data(), size_t(m) * k) * B.maxAbs();
+            if (perGroup > INT32_MAX) {
+                throw std::overflow_error("Error: Quantized values too large for int32 accumulation.");
+            }
+            const int runGroups = perGroup == 0 ? std::max(1, B.groups())
+                                                : int(std::min<int64_t>(INT32_MAX / perGroup, std::max(1, B.groups())));
+
+            std::vector<int64_t> rowSums(m, 0);
+            for (int i = 0; i < m; ++i) {
+                for (int p = 0; p < k; ++p) rowSums[i] += A(i, p);
+            }
+
+            const int kPadded = B.groups() * G;
+            const int bytesPerColumn = B.groups() * G * int(sizeof(TB));
+            const int NC = std::max(NR, (tuning::profile().gemmNC * 8 / std::max(1, bytesPerColumn)) / NR * NR);
+            const int tiles = (m + MR - 1) / MR;
+
+            for (int jc = 0; jc < n; jc += NC) {
+                const int nc = std::min(NC, n - jc);
+                const int panels = (nc + NR - 1) / NR;
+                int grain = parallel::grainFor(2LL * MR * k * nc);
+                parallel::parallelFor(0, tiles, grain, [&](int firstTile, int lastTile) {
+                    thread_local std::vector<TA> packedA;
+                    thread_local std::vector<int64_t> sums;
+                    thread_local std::vector<int32_t> corrected;
+                    packedA.assign(size_t(MR) * kPadded, TA(0));
+                    sums.resize(size_t(MR) * panels * NR);
+                    corrected.resize(size_t(panels) * NR);
+                    alignas(64) int32_t tile[MR * NR];
+                    for (int t = firstTile; t < lastTile; ++t) {
+                        LINEARCPP_TRACE_SCOPE("qgemm_tile", "kernel", t);
+                        const int i0 = t * MR, rows = std::min(MR, m - i0);
+                        std::fill(packedA.begin(), packedA.end(), TA(0));
+                        for (int r = 0; r < rows; ++r) {
+                            std::copy(A.data() + size_t(i0 + r) * k, A.data() + size_t(i0 + r + 1) * k,
+                                      packedA.begin() + size_t(r) * kPadded);
+                        }
+                        std::fill(sums.begin(), sums.end(), 0);
+                        for (int q0 = 0; q0 < B.groups(); q0 += runGroups) {
+                            const int kq = std::min(runGroups, B.groups() - q0);
+                            for (int panel = 0; panel < panels; ++panel) {
+                                const TB* b = B.panel(jc + panel * NR) + size_t(q0) * NR * G;
+                                kernel(kq, packedA.data() + size_t(q0) * G, kPadded, b, tile);
+                                for (int r = 0; r < MR; ++r) {
+                                    int64_t* s = sums.data() + (size_t(r) * panels + panel) * NR;
+                                    for (int j = 0; j < NR; ++j) s[j] += tile[r * NR + j];
+                                }
+                            }
+                        }
+                        for (int r = 0; r < rows; ++r) {
+                            const int i = i0 + r;
+                            const int64_t za = pa.zeroPoint(i);
+                            const int64_t* s = sums.data() + size_t(r) * panels * NR;
+                            for (int j = 0; j < nc; ++j) {
+                                const int64_t zb = B.params().zeroPoint(jc + j);
+                                int64_t value = s[j] - za * B.colSums()[jc + j] - zb * rowSums[i] + int64_t(k) * za * zb;
+                                corrected[j] = int32_t(std::min<int64_t>(INT32_MAX, std::max<int64_t>(INT32_MIN, value)));
+                            }
+                            epilogue(i, jc, nc, corrected.data());
+                        }
+                    }
+                });
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Zero-point-corrected integer product sum_p (a - za)(b - zb), saturated to int32.
+     * @param A The m x k left operand (uint8_t with PackedB<int8_t>, int16_t with PackedB<int16_t>).
+     * @param pa Per-tensor or per-row parameters of A (only zero points are used).
+     * @param B The packed k x n right operand.
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename TA, typename TB>
+    Matrix<int32_t> multiply(const Matrix<TA>& A, const Params& pa, const PackedB<TB>& B) {
+        LINEARCPP_TRACE_SCOPE("qgemm", "kernel", A.getRows());
+        Matrix<int32_t> C(A.getRows(), B.getCols());
+        detail::run(A, pa, B, [&](int i, int j0, int count, const int32_t* values) {
+            std::copy(values, values + count, C.data() + size_t(i) * C.getCols() + j0);
+        });
+        return C;
+    }
+
+    /**
+     * @brief Product dequantized to float: scaleA(i) scaleB(j) C(i, j) + bias(j).
+     * @param bias Optional per-column bias, empty for none.
+     */
+    template <typename TA, typename TB>
+    Matrix<float> multiplyDequantize(const Matrix<TA>& A, const Params& pa, const PackedB<TB>& B,
+                                     const std::vector<float>& bias = {}) {
+        LINEARCPP_TRACE_SCOPE("qgemm", "kernel", A.getRows());
+        Matrix<float> C(A.getRows(), B.getCols());
+        detail::run(A, pa, B, [&](int i, int j0, int count, const int32_t* values) {
+            float* out = C.data() + size_t(i) * C.getCols() + j0;
+            const float sa = pa.scale(i);
+            for (int j = 0; j < count; ++j) {
+                out[j] = sa * B.params().scale(j0 + j) * float(values[j]) + (bias.empty() ? 0.0f : bias[j0 + j]);
+            }
+        });
+        return C;
+    }
+
+    /**
+     * @brief Product requantized to TO (e.g. uint8_t as the next layer's input): the real
+     * result plus bias is divided by out.scale, rounded, offset by out.zeroPoint and saturated.
+     * @param out Per-tensor parameters of the result.
+     */
+    template <typename TO, typename TA, typename TB>
+    Quantized<TO> multiplyRequantize(const Matrix<TA>& A, const Params& pa, const PackedB<TB>& B, const Params& out,
+                                     const std::vector<float>& bias = {}) {
+        LINEARCPP_TRACE_SCOPE("qgemm", "kernel", A.getRows());
+        Quantized<TO> C{Matrix<TO>(A.getRows(), B.getCols()), out};
+        // Saturated in double: float(INT32_MAX) rounds up to 2^31, which int32_t cannot hold.
+        const double lo = double(std::numeric_limits<TO>::lowest()), hi = double(std::numeric_limits<TO>::max());
+        const float inverse = 1.0f / out.scale(0);
+        detail::run(A, pa, B, [&](int i, int j0, int count, const int32_t* values) {
+            TO* target = C.values.data() + size_t(i) * C.values.getCols() + j0;
+            const float sa = pa.scale(i);
+            for (int j = 0; j < count; ++j) {
+                float real = sa * B.params().scale(j0 + j) * float(values[j]) + (bias.empty() ? 0.0f : bias[j0 + j]);
+                float q = std::nearbyint(real * inverse) + float(out.zeroPoint(0));
+                target[j] = static_cast<TO>(std::min(hi, std::max(lo, double(q))));
+            }
+        });
+        return C;
+    }
+
+} // namespace quant
+
+#endif // QUANTIZED_HPP
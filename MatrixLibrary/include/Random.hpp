@@ -0,0 +1,351 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Matrix.hpp"
+#include "Parallel.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Counter-based random numbers and parallel random/structured matrix generators.
+ * * Values come from the Philox4x32-10 generator (Salmon et al., "Parallel random numbers:
+ * as easy as 1, 2, 3", SC'11), which maps a (counter, key) pair to random bits without any
+ * sequential state. Every element draws from the counter given by its position, so rows can
+ * be filled in parallel in any order and the result depends only on the seed: the same seed
+ * gives bit-identical matrices for any thread count.
+ *
+ * Streams keep generators apart: two matrices drawn with the same seed but different
+ * streams are independent.
+ */
+namespace rng {
+
+    /**
+     * @brief The Philox4x32-10 bijection: 128-bit counter and 64-bit key to 128 random bits.
+     */
+    struct Philox4x32 {
+        uint32_t key[2];
+
+        explicit Philox4x32(uint64_t seed) : key{uint32_t(seed), uint32_t(seed >> 32)} {}
+
+        void operator()(const uint32_t counter[4], uint32_t out[4]) const {
+            uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+            uint32_t k0 = key[0], k1 = key[1];
+            for (int round = 0; round < 10; ++round) {
+                uint64_t p0 = uint64_t(0xD2511F53u) * c0;
+                uint64_t p1 = uint64_t(0xCD9E8D57u) * c2;
+                uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+                uint32_t n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+                c1 = uint32_t(p1);
+                c3 = uint32_t(p0);
+                c0 = n0;
+                c2 = n2;
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+        }
+
+        /**
+         * @brief 128 random bits for element `index` of stream `stream`.
+         */
+        void draw(uint64_t index, uint64_t stream, uint32_t out[4]) const {
+            const uint32_t counter[4] = {uint32_t(index), uint32_t(index >> 32),
+                                         uint32_t(stream), uint32_t(stream >> 32)};
+            (*this)(counter, out);
+        }
+    };
+
+    /**
+     * @brief Uniform double in (0, 1] built from 53 random bits.
+     */
+    inline double toUnit(uint32_t hi, uint32_t lo) {
+        uint64_t bits = (uint64_t(hi) << 21) ^ (lo >> 11);
+        return (double(bits & ((uint64_t(1) << 53) - 1)) + 1.0) * 0x1.0p-53;
+    }
+
+    /**
+     * @brief Uniform value in (lo, hi] for element `index` of `stream`.
+     */
+    inline double uniformAt(const Philox4x32 &philox, uint64_t index, uint64_t stream, double lo, double hi) {
+        uint32_t bits[4];
+        philox.draw(index, stream, bits);
+        return lo + (hi - lo) * toUnit(bits[0], bits[1]);
+    }
+
+    /**
+     * @brief Standard normal value for element `index` of `stream` (Box-Muller).
+     */
+    inline double normalAt(const Philox4x32 &philox, uint64_t index, uint64_t stream) {
+        uint32_t bits[4];
+        philox.draw(index, stream, bits);
+        double radius = std::sqrt(-2.0 * std::log(toUnit(bits[0], bits[1])));
+        return radius * std::cos(6.283185307179586 * toUnit(bits[2], bits[3]));
+    }
+
+    namespace detail {
+
+        // Stream tags in the upper half of the stream word; generators own disjoint ranges.
+        constexpr uint64_t kUniform = 0;
+        constexpr uint64_t kNormal = uint64_t(1) << 32;
+        constexpr uint64_t kSparse = uint64_t(2) << 32;
+        constexpr uint64_t kReflector = uint64_t(3) << 32;
+
+        /**
+         * @brief Fills M(i, j) = value(i, j) with rows distributed over the thread pool.
+         */
+        template <typename T, typename Value>
+        void fill(Matrix<T> &M, Value value) {
+            LINEARCPP_TRACE_SCOPE("generate", "kernel", M.getRows());
+            const int cols = M.getCols();
+            T *data = M.data();
+            parallel::parallelFor(0, M.getRows(), parallel::grainFor(16LL * cols), [&](int lo, int hi) {
+                for (int i = lo; i < hi; ++i) {
+                    for (int j = 0; j < cols; ++j) {
+                        data[size_t(i) * cols + j] = static_cast<T>(value(i, j));
+                    }
+                }
+            });
+        }
+
+        /**
+         * @brief Fills M from one 128-bit draw per pair of adjacent row entries, where
+         * pair(bits) returns the two values. Halves the generator cost of per-element draws.
+         */
+        template <typename T, typename Pair>
+        void fillPairs(Matrix<T> &M, const Philox4x32 &philox, uint64_t stream, Pair pair) {
+            LINEARCPP_TRACE_SCOPE("generate", "kernel", M.getRows());
+            const int cols = M.getCols();
+            const uint64_t pairsPerRow = uint64_t(cols + 1) / 2;
+            T *data = M.data();
+            parallel::parallelFor(0, M.getRows(), parallel::grainFor(16LL * cols), [&](int lo, int hi) {
+                uint32_t bits[4];
+                for (int i = lo; i < hi; ++i) {
+                    T *row = data + size_t(i) * cols;
+                    for (int j = 0; j < cols; j += 2) {
+                        philox.draw(i * pairsPerRow + uint64_t(j / 2), stream, bits);
+                        auto values = pair(bits);
+                        row[j] = static_cast<T>(values.first);
+                        if (j + 1 < cols) row[j + 1] = static_cast<T>(values.second);
+                    }
+                }
+            });
+        }
+
+        /**
+         * @brief Replaces each diagonal entry by the absolute off-diagonal row sum plus `shift`.
+         */
+        template <typename T>
+        void dominateDiagonal(Matrix<T> &M, double shift) {
+            const int n = M.getRows();
+            T *data = M.data();
+            parallel::parallelFor(0, n, parallel::grainFor(2LL * n), [&](int lo, int hi) {
+                for (int i = lo; i < hi; ++i) {
+                    double sum = 0.0;
+                    for (int j = 0; j < n; ++j) {
+                        if (j != i) sum += std::abs(static_cast<double>(data[size_t(i) * n + j]));
+                    }
+                    data[size_t(i) * n + i] = static_cast<T>(sum + shift);
+                }
+            });
+        }
+
+        /**
+         * @brief Haar-distributed orthogonal matrix from the Householder reflectors of a
+         * Gaussian matrix (Stewart 1980), drawn from reflector streams tagged `variant`.
+         * * The QR factorization of an n x n standard normal matrix needs one fresh Gaussian
+         * vector of length n - k per step, so reflector k is drawn directly from its own stream
+         * and R is never formed. Q = H_0 ... H_{n-2} D is accumulated backwards, where each
+         * H_k touches only the trailing (n - k) x (n - k) block, and D holds the signs of
+         * diag(R) that make the distribution exactly Haar (Mezzadri 2007). Costs about
+         * 4n^3/3 flops, parallel over column chunks.
+         */
+        template <typename T>
+        Matrix<T> orthogonal(int n, uint64_t seed, uint64_t variant) {
+            LINEARCPP_TRACE_SCOPE("generate", "kernel", n);
+            Philox4x32 philox(seed);
+            std::vector<double> Q(size_t(n) * n, 0.0);
+            std::vector<double> signs(n, 1.0);
+            for (int i = 0; i < n; ++i) Q[size_t(i) * n + i] = 1.0;
+
+            std::vector<double> v(n);
+            for (int k = n - 2; k >= 0; --k) {
+                const int m = n - k;
+                const uint64_t stream = kReflector + (variant << 24) + uint64_t(k);
+                double norm = 0.0;
+                for (int i = 0; i < m; ++i) {
+                    v[i] = normalAt(philox, uint64_t(i), stream);
+                    norm += v[i] * v[i];
+                }
+                norm = std::sqrt(norm);
+                double alpha = v[0] >= 0.0 ? -norm : norm; // R(k, k)
+                signs[k] = alpha >= 0.0 ? 1.0 : -1.0;
+                v[0] -= alpha;
+                double vv = 0.0;
+                for (int i = 0; i < m; ++i) vv += v[i] * v[i];
+                if (vv == 0.0) continue;
+                const double beta = 2.0 / vv;
+
+                // Q(k:, k:) = (I - beta v v^T) Q(k:, k:), independently per column chunk.
+                parallel::parallelFor(k, n, parallel::grainFor(4LL * m), [&](int lo, int hi) {
+                    std::vector<double> s(hi - lo, 0.0);
+                    for (int i = 0; i < m; ++i) {
+                        const double *row = Q.data() + size_t(k + i) * n;
+                        for (int j = lo; j < hi; ++j) s[j - lo] += v[i] * row[j];
+                    }
+                    for (int i = 0; i < m; ++i) {
+                        double *row = Q.data() + size_t(k + i) * n;
+                        const double scale = beta * v[i];
+                        for (int j = lo; j < hi; ++j) row[j] -= scale * s[j - lo];
+                    }
+                });
+            }
+            if (n > 0) {
+                signs[n - 1] = normalAt(philox, 0, kReflector + (variant << 24) + uint64_t(n - 1)) >= 0.0 ? 1.0 : -1.0;
+            }
+
+            Matrix<T> result(n, n);
+            fill(result, [&](int i, int j) { return Q[size_t(i) * n + j] * signs[j]; });
+            return result;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Matrix with entries uniform in (lo, hi].
+     */
+    template <typename T>
+    Matrix<T> uniform(int rows, int cols, uint64_t seed, double lo = 0.0, double hi = 1.0, uint64_t stream = 0) {
+        static_assert(std::is_floating_point<T>::value, "Random generators require floating-point types.");
+        Philox4x32 philox(seed);
+        Matrix<T> M(rows, cols);
+        detail::fillPairs(M, philox, detail::kUniform + stream, [&](const uint32_t bits[4]) {
+            return std::make_pair(lo + (hi - lo) * toUnit(bits[0], bits[1]),
+                                  lo + (hi - lo) * toUnit(bits[2], bits[3]));
+        });
+        return M;
+    }
+
+    /**
+     * @brief Matrix with independent N(mean, stddev^2) entries.
+     */
+    template <typename T>
+    Matrix<T> normal(int rows, int cols, uint64_t seed, double mean = 0.0, double stddev = 1.0, uint64_t stream = 0) {
+        static_assert(std::is_floating_point<T>::value, "Random generators require floating-point types.");
+        Philox4x32 philox(seed);
+        Matrix<T> M(rows, cols);
+        detail::fillPairs(M, philox, detail::kNormal + stream, [&](const uint32_t bits[4]) {
+            double radius = stddev * std::sqrt(-2.0 * std::log(toUnit(bits[0], bits[1])));
+            double angle = 6.283185307179586 * toUnit(bits[2], bits[3]);
+            return std::make_pair(mean + radius * std::cos(angle), mean + radius * std::sin(angle));
+        });
+        return M;
+    }
+
+    /**
+     * @brief Strictly row diagonally dominant n x n matrix: off-diagonal entries uniform in
+     * (-1, 1], diagonal equal to the absolute off-diagonal row sum plus `margin`.
+     * * Nonsingular, and LU needs no pivoting; the usual input for solver benchmarks.
+     */
+    template <typename T>
+    Matrix<T> diagonallyDominant(int n, uint64_t seed, double margin = 1.0) {
+        Matrix<T> M = uniform<T>(n, n, seed, -1.0, 1.0);
+        detail::dominateDiagonal(M, margin);
+        return M;
+    }
+
+    /**
+     * @brief Symmetric positive definite n x n matrix in O(n^2).
+     * * Off-diagonal entries are symmetric and uniform in (-1, 1]; the diagonal dominates by
+     * `margin`, so all eigenvalues are at least `margin` (Gershgorin). For a prescribed
+     * spectrum use withCondition(), whose result is SPD when `symmetric` is set.
+     */
+    template <typename T>
+    Matrix<T> spd(int n, uint64_t seed, double margin = 1.0) {
+        static_assert(std::is_floating_point<T>::value, "Random generators require floating-point types.");
+        Philox4x32 philox(seed);
+        Matrix<T> M(n, n);
+        detail::fill(M, [&](int i, int j) {
+            uint64_t index = uint64_t(std::min(i, j)) * n + std::max(i, j);
+            return uniformAt(philox, index, detail::kUniform, -1.0, 1.0);
+        });
+        detail::dominateDiagonal(M, margin);
+        return M;
+    }
+
+    /**
+     * @brief Haar-distributed (uniformly random) n x n orthogonal matrix, O(n^3).
+     */
+    template <typename T>
+    Matrix<T> orthogonal(int n, uint64_t seed) {
+        static_assert(std::is_floating_point<T>::value, "Random generators require floating-point types.");
+        return detail::orthogonal<T>(n, seed, 0);
+    }
+
+    /**
+     * @brief n x n matrix with 2-norm condition number `condition`.
+     * * Forms U diag(s) V^T with Haar-random orthogonal U, V and singular values spaced
+     * geometrically from 1 down to 1 / condition (the "mode 3" spectrum of LAPACK's
+     * xLATMS). With `symmetric` set, V = U and the result is SPD with those eigenvalues.
+     * @throws std::invalid_argument If condition < 1.
+     */
+    template <typename T>
+    Matrix<T> withCondition(int n, double condition, uint64_t seed, bool symmetric = false) {
+        static_assert(std::is_floating_point<T>::value, "Random generators require floating-point types.");
+        if (!(condition >= 1.0)) {
+            throw std::invalid_argument("Error: Condition number must be at least 1.");
+        }
+        Matrix<double> U = detail::orthogonal<double>(n, seed, 1);
+        Matrix<double> Vt = symmetric ? U.transpose() : detail::orthogonal<double>(n, seed, 2).transpose();
+        Matrix<double> US(n, n);
+        detail::fill(US, [&](int i, int j) {
+            double exponent = n > 1 ? double(j) / (n - 1) : 0.0;
+            return U(i, j) * std::pow(condition, -exponent);
+        });
+        Matrix<double> A = matrixMultiply(US, Vt);
+        if (symmetric) {
+            // Remove the rounding asymmetry of the product.
+            for (int i = 0; i < n; ++i) {
+                for (int j = i + 1; j < n; ++j) {
+                    A(i, j) = A(j, i) = 0.5 * (A(i, j) + A(j, i));
+                }
+            }
+        }
+        if constexpr (std::is_same<T, double>::value) {
+            return A;
+        } else {
+            Matrix<T> result(n, n);
+            detail::fill(result, [&](int i, int j) { return A(i, j); });
+            return result;
+        }
+    }
+
+    /**
+     * @brief Matrix whose entries are nonzero with probability `density`, with nonzero values
+     * uniform in (lo, hi]. Stored densely, as Matrix has no sparse format.
+     * @throws std::invalid_argument If density is outside [0, 1].
+     */
+    template <typename T>
+    Matrix<T> sparse(int rows, int cols, double density, uint64_t seed, double lo = -1.0, double hi = 1.0) {
+        static_assert(std::is_floating_point<T>::value, "Random generators require floating-point types.");
+        if (!(density >= 0.0 && density <= 1.0)) {
+            throw std::invalid_argument("Error: Density must be in [0, 1].");
+        }
+        Philox4x32 philox(seed);
+        Matrix<T> M(rows, cols);
+        detail::fill(M, [&](int i, int j) {
+            uint32_t bits[4];
+            philox.draw(uint64_t(i) * cols + j, detail::kSparse, bits);
+            return toUnit(bits[0], bits[1]) <= density ? lo + (hi - lo) * toUnit(bits[2], bits[3]) : 0.0;
+        });
+        return M;
+    }
+
+} // namespace rng
+
+#endif // RANDOM_HPP
@@ -0,0 +1,113 @@
+#ifndef SEMIRING_HPP
+#define SEMIRING_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include "Matrix.hpp"
+#include "Gemm.hpp"
+#include "Trace.hpp"
+
+/**
+ * @brief Matrix products over semirings other than (+, *).
+ * * A semiring type names its value_type and provides static zero() (the identity of plus,
+ * which times absorbs), plus(a, b) and times(a, b). The products run through the blocked,
+ * packed GEMM of Gemm.hpp with a semiring micro-kernel, so all-pairs shortest paths
+ * ((min, +) squaring), Viterbi-style recurrences ((max, +)) and reachability ((or, and))
+ * get the same cache blocking, register tiling and threading as the arithmetic product.
+ *
+ * If plus and times are templates that also work element-wise on GCC/Clang vector types,
+ * `vectorizable = true` selects the explicitly vectorized micro-kernel.
+ */
+namespace semiring {
+
+    /**
+     * @brief The tropical (min, +) semiring; zero() is +infinity (max() for integers).
+     * * For integer types, times() saturates at zero() so "no path" stays absorbing; finite
+     * sums must stay within range. Integer instances use the scalar micro-kernel.
+     */
+    template <typename T>
+    struct MinPlus {
+        using value_type = T;
+        static constexpr bool vectorizable = std::is_floating_point<T>::value;
+        static constexpr T zero() {
+            return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity()
+                                                        : std::numeric_limits<T>::max();
+        }
+        template <typename V>
+        static V plus(V a, V b) { return b < a ? b : a; }
+        template <typename V>
+        static V times(V a, V b) {
+            if constexpr (std::is_floating_point<T>::value) {
+                return a + b;
+            } else {
+                return (a == zero() || b == zero()) ? zero() : T(a + b);
+            }
+        }
+    };
+
+    /**
+     * @brief The (max, +) semiring; zero() is -infinity (lowest() for integers).
+     */
+    template <typename T>
+    struct MaxPlus {
+        using value_type = T;
+        static constexpr bool vectorizable = std::is_floating_point<T>::value;
+        static constexpr T zero() {
+            return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity()
+                                                        : std::numeric_limits<T>::lowest();
+        }
+        template <typename V>
+        static V plus(V a, V b) { return a < b ? b : a; }
+        template <typename V>
+        static V times(V a, V b) {
+            if constexpr (std::is_floating_point<T>::value) {
+                return a + b;
+            } else {
+                return (a == zero() || b == zero()) ? zero() : T(a + b);
+            }
+        }
+    };
+
+    /**
+     * @brief The boolean (or, and) semiring on 0/1 entries of an integer type.
+     * * uint8_t is the natural choice (Matrix<bool> would sit on std::vector<bool>, which has
+     * no contiguous storage). Bitwise | and & do not tempt the compiler into reductions
+     * over the shared dimension, so the scalar micro-kernel auto-vectorizes well here.
+     */
+    template <typename T = uint8_t>
+    struct OrAnd {
+        static_assert(std::is_integral<T>::value, "OrAnd requires an integer element type.");
+        using value_type = T;
+        static constexpr T zero() { return T(0); }
+        static T plus(T a, T b) { return T(a | b); }
+        static T times(T a, T b) { return T(a & b); }
+    };
+
+    /**
+     * @brief Product A times B over the semiring SR.
+     * * @tparam SR A semiring such as MinPlus<double>, MaxPlus<float> or OrAnd<>.
+     * @param A The left-hand side matrix (m x k).
+     * @param B The right-hand side matrix (k x n).
+     * @return The m x n matrix C(i, j) = plus over p of times(A(i, p), B(p, j)).
+     * @throws std::invalid_argument If the dimensions do not agree.
+     */
+    template <typename SR>
+    Matrix<typename SR::value_type> multiply(const Matrix<typename SR::value_type>& A,
+                                             const Matrix<typename SR::value_type>& B) {
+        if (A.getCols() != B.getRows()) {
+            throw std::invalid_argument("Matrix dimensions must agree for multiplication.");
+        }
+        LINEARCPP_TRACE_SCOPE("semiring_gemm", "kernel", A.getRows());
+        Matrix<typename SR::value_type> C(A.getRows(), B.getCols());
+        std::fill(C.data(), C.data() + size_t(C.getRows()) * C.getCols(), SR::zero());
+        gemm::semiringMultiplyAdd<SR>(A.getRows(), B.getCols(), A.getCols(),
+                                      A.data(), A.getCols(), B.data(), B.getCols(), C.data(), C.getCols());
+        return C;
+    }
+
+} // namespace semiring
+
+#endif // SEMIRING_HPP
@@ -0,0 +1,245 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+
+/**
+ * @brief Scoped trace events exported in the Chrome trace / Perfetto JSON format.
+ * * Tracing is compiled in only when LINEARCPP_ENABLE_TRACE is defined (CMake option
+ * LINEARCPP_ENABLE_TRACE). Without it every LINEARCPP_TRACE_SCOPE expands to nothing and
+ * trace::flush() is an empty inline function, so instrumented kernels pay no cost.
+ *
+ * Each thread records into its own buffer: the owning thread is the only writer and
+ * publishes new events with a release store on the event counter, so recording never
+ * takes a lock. Buffers are registered once per thread and outlive the thread, so events
+ * from worker threads are still available at flush time.
+ *
+ * Usage:
+ *   LINEARCPP_TRACE_SCOPE("strassen", "kernel", n);   // arg is optional
+ *   ...
+ *   trace::flush("trace.json");                        // open in ui.perfetto.dev
+ */
+
+#ifdef LINEARCPP_ENABLE_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace trace {
+
+    struct Event {
+        const char* name;     //< Static string naming the scope.
+        const char* category; //< Static string grouping related scopes (kernel, io, ...).
+        int64_t startNs;      //< Start time relative to the process trace epoch.
+        int64_t durationNs;   //< Duration of the scope.
+        int64_t arg;          //< Optional numeric argument (size, index), -1 if unused.
+    };
+
+    /**
+     * @brief Append-only event storage owned by a single thread.
+     * * Events are stored in fixed-size chunks allocated lazily by the owner thread; the
+     * chunk table never moves, so a concurrent flush can read published events safely.
+     * Events beyond the capacity are counted as dropped instead of growing without bound.
+     */
+    class ThreadBuffer {
+        public:
+            static constexpr size_t kChunkSize = 4096;
+            static constexpr size_t kMaxChunks = 256;
+
+            explicit ThreadBuffer(int tid) : m_tid(tid), m_count(0), m_dropped(0) {
+                for (auto &chunk : m_chunks) {
+                    chunk.store(nullptr, std::memory_order_relaxed);
+                }
+            }
+
+            ~ThreadBuffer() {
+                for (auto &chunk : m_chunks) {
+                    delete[] chunk.load(std::memory_order_relaxed);
+                }
+            }
+
+            void record(const Event &event) {
+                size_t index = m_count.load(std::memory_order_relaxed);
+                size_t chunkIndex = index / kChunkSize;
+                if (chunkIndex >= kMaxChunks) {
+                    m_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                Event* chunk = m_chunks[chunkIndex].load(std::memory_order_relaxed);
+                if (chunk == nullptr) {
+                    chunk = new Event[kChunkSize];
+                    m_chunks[chunkIndex].store(chunk, std::memory_order_release);
+                }
+                chunk[index % kChunkSize] = event;
+                m_count.store(index + 1, std::memory_order_release);
+            }
+
+            size_t size() const { return m_count.load(std::memory_order_acquire); }
+
+            const Event& at(size_t index) const {
+                return m_chunks[index / kChunkSize].load(std::memory_order_acquire)[index % kChunkSize];
+            }
+
+            int tid() const { return m_tid; }
+
+            size_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+            // Only safe when no thread is recording; used by trace::clear().
+            void reset() {
+                m_count.store(0, std::memory_order_release);
+                m_dropped.store(0, std::memory_order_relaxed);
+            }
+
+        private:
+            int m_tid;
+            std::atomic<size_t> m_count;
+            std::atomic<size_t> m_dropped;
+            std::atomic<Event*> m_chunks[kMaxChunks];
+    };
+
+    namespace detail {
+
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+            std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        };
+
+        inline Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        inline int64_t nowNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - registry().epoch).count();
+        }
+
+        // Registration is the only locked operation and happens once per thread.
+        inline ThreadBuffer& localBuffer() {
+            thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+                Registry &reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                auto created = std::make_shared<ThreadBuffer>(static_cast<int>(reg.buffers.size()));
+                reg.buffers.push_back(created);
+                return created;
+            }();
+            return *buffer;
+        }
+
+        inline void writeEscaped(std::ostream &out, const char* text) {
+            for (const char* c = text; *c != '\0'; ++c) {
+                if (*c == '"' || *c == '\\') out << '\\';
+                out << *c;
+            }
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief RAII scope recording one complete ("ph":"X") event on destruction.
+     */
+    class Scope {
+        public:
+            Scope(const char* name, const char* category, int64_t arg = -1)
+                : m_name(name), m_category(category), m_arg(arg), m_start(detail::nowNs()) {}
+
+            ~Scope() {
+                int64_t end = detail::nowNs();
+                detail::localBuffer().record({m_name, m_category, m_start, end - m_start, m_arg});
+            }
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            const char* m_name;
+            const char* m_category;
+            int64_t m_arg;
+            int64_t m_start;
+    };
+
+    /**
+     * @brief Writes all events recorded so far as Chrome trace JSON.
+     * * The file can be loaded in chrome://tracing or ui.perfetto.dev. Events are not
+     * removed from the buffers; call trace::clear() between runs if needed.
+     * @throws std::runtime_error If the output file cannot be created.
+     */
+    inline void flush(const std::string& filename) {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error: Could not create trace file " + filename);
+        }
+
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(detail::registry().mutex);
+            buffers = detail::registry().buffers;
+        }
+
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto &buffer : buffers) {
+            file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+                 << buffer->tid() << ",\"args\":{\"name\":\"linearcpp-" << buffer->tid() << "\"}}";
+            first = false;
+
+            size_t count = buffer->size();
+            for (size_t i = 0; i < count; ++i) {
+                const Event &e = buffer->at(i);
+                file << ",\n{\"name\":\"";
+                detail::writeEscaped(file, e.name);
+                file << "\",\"cat\":\"";
+                detail::writeEscaped(file, e.category);
+                // Chrome trace timestamps are in microseconds; keep sub-us precision.
+                file << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->tid()
+                     << ",\"ts\":" << e.startNs / 1000 << "." << (e.startNs % 1000) / 100
+                     << ",\"dur\":" << e.durationNs / 1000 << "." << (e.durationNs % 1000) / 100;
+                if (e.arg >= 0) {
+                    file << ",\"args\":{\"n\":" << e.arg << "}";
+                }
+                file << "}";
+            }
+            if (buffer->dropped() > 0) {
+                file << ",\n{\"name\":\"dropped_events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":"
+                     << buffer->tid() << ",\"ts\":0,\"args\":{\"count\":" << buffer->dropped() << "}}";
+            }
+        }
+        file << "\n]}\n";
+    }
+
+    /**
+     * @brief Discards all recorded events. Must not race with threads still recording.
+     */
+    inline void clear() {
+        std::lock_guard<std::mutex> lock(detail::registry().mutex);
+        for (auto &buffer : detail::registry().buffers) {
+            buffer->reset();
+        }
+    }
+
+} // namespace trace
+
+#define LINEARCPP_TRACE_CONCAT_IMPL(a, b) a##b
+#define LINEARCPP_TRACE_CONCAT(a, b) LINEARCPP_TRACE_CONCAT_IMPL(a, b)
+#define LINEARCPP_TRACE_SCOPE(...) \
+    trace::Scope LINEARCPP_TRACE_CONCAT(linearcppTraceScope, __LINE__)(__VA_ARGS__)
+
+#else // !LINEARCPP_ENABLE_TRACE
+
+namespace trace {
+    inline void flush(const std::string&) {}
+    inline void clear() {}
+} // namespace trace
+
+#define LINEARCPP_TRACE_SCOPE(...) ((void)0)
+
+#endif // LINEARCPP_ENABLE_TRACE
+
+#endif // TRACE_HPP
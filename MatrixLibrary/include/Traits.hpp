@@ -0,0 +1,20 @@
+#ifndef TRAITS_HPP
+#define TRAITS_HPP
+
+#include <complex>
+#include <type_traits>
+
+namespace gemm {
+
+    /**
+     * @brief True for std::complex<float> and std::complex<double>.
+     */
+    template <typename T>
+    struct IsComplex : std::false_type {};
+
+    template <typename R>
+    struct IsComplex<std::complex<R>> : std::is_floating_point<R> {};
+
+} // namespace gemm
+
+#endif // TRAITS_HPP
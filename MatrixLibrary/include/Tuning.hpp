@@ -0,0 +1,221 @@
+#ifndef TUNING_HPP
+#define TUNING_HPP
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#endif
+
+/**
+ * @brief Host-specific tuning parameters of the kernels.
+ * * The profile is loaded once, on first use, from the file named by the
+ * LINEARCPP_TUNING_PROFILE environment variable or, when unset, from
+ * $XDG_CONFIG_HOME/linearcpp/tuning.conf (~/.config/linearcpp/tuning.conf). When no file
+ * exists, block sizes are derived from the detected cache sizes and the remaining values
+ * use compiled-in defaults. Profiles are written by the linearcpp_autotune tool.
+ *
+ * File format: one "key=value" per line, '#' starts a comment, unknown keys are ignored.
+ */
+namespace tuning {
+
+    struct CacheSizes {
+        long l1d = 32 * 1024;   //< Per-core L1 data cache in bytes.
+        long l2 = 1024 * 1024;  //< Per-core (or per-cluster) L2 cache in bytes.
+        long l3 = 0;            //< Shared last-level cache in bytes, 0 if absent.
+    };
+
+    struct Profile {
+        int strassenCutoff = 64;     //< Size at or below which Strassen uses the classical GEMM.
+        int gemmMC = 128;            //< Rows of A packed per block (sized for L2).
+        int gemmKC = 256;            //< Shared dimension per packed panel (sized for L1).
+        int gemmNC = 4096;           //< Columns of B packed per panel (sized for L3).
+        int luPanel = 64;            //< Column panel width of the blocked LU.
+        long long parallelGrain = 1 << 15; //< Minimum work (flops) per parallel chunk.
+    };
+
+    namespace detail {
+
+        inline long parseCacheSize(const std::string& text) {
+            long value = std::atol(text.c_str());
+            if (text.find('K') != std::string::npos) value *= 1024;
+            if (text.find('M') != std::string::npos) value *= 1024 * 1024;
+            return value;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief Detects data cache sizes from sysfs (Linux), sysctl (macOS) or cpuid (x86).
+     * * Any level that cannot be detected keeps the conservative default of CacheSizes.
+     */
+    inline CacheSizes detectCaches() {
+        CacheSizes caches;
+        bool found = false;
+        for (int index = 0; index < 8; ++index) {
+            std::string base = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+            std::ifstream levelFile(base + "level"), typeFile(base + "type"), sizeFile(base + "size");
+            if (!levelFile || !typeFile || !sizeFile) break;
+            int level = 0;
+            std::string type, size;
+            levelFile >> level;
+            typeFile >> type;
+            sizeFile >> size;
+            if (type == "Instruction") continue;
+            long bytes = detail::parseCacheSize(size);
+            if (level == 1) caches.l1d = bytes;
+            else if (level == 2) caches.l2 = bytes;
+            else if (level == 3) caches.l3 = bytes;
+            found = true;
+        }
+        if (found) return caches;
+
+#ifdef __APPLE__
+        auto sysctlValue = [](const char* name, long fallback) {
+            long long value = 0;
+            size_t length = sizeof(value);
+            return sysctlbyname(name, &value, &length, nullptr, 0) == 0 && value > 0 ? long(value) : fallback;
+        };
+        caches.l1d = sysctlValue("hw.l1dcachesize", caches.l1d);
+        caches.l2 = sysctlValue("hw.l2cachesize", caches.l2);
+        caches.l3 = sysctlValue("hw.l3cachesize", caches.l3);
+#elif defined(__x86_64__) || defined(__i386__)
+        // Deterministic cache parameters (leaf 4), supported by Intel and recent AMD CPUs.
+        for (unsigned sub = 0; sub < 8; ++sub) {
+            unsigned eax, ebx, ecx, edx;
+            if (!__get_cpuid_count(4, sub, &eax, &ebx, &ecx, &edx)) break;
+            unsigned type = eax & 0x1f;
+            if (type == 0) break;
+            if (type == 2) continue; // instruction cache
+            unsigned level = (eax >> 5) & 0x7;
+            long bytes = long((ebx >> 22) + 1) * (((ebx >> 12) & 0x3ff) + 1) * ((ebx & 0xfff) + 1) * (ecx + 1);
+            if (level == 1) caches.l1d = bytes;
+            else if (level == 2) caches.l2 = bytes;
+            else if (level == 3) caches.l3 = bytes;
+        }
+#endif
+        return caches;
+    }
+
+    /**
+     * @brief Compiled-in defaults with GEMM block sizes derived from the cache sizes.
+     * * Follows the usual analytical model for double precision: a KC x NR sliver of B
+     * stays in half of L1, an MC x KC block of A in half of L2 and a KC x NC panel of B in
+     * half of L3 (or 4 x L2 without an L3).
+     */
+    inline Profile defaultProfile(const CacheSizes& caches = detectCaches()) {
+        Profile profile;
+        const long element = sizeof(double);
+        profile.gemmKC = std::clamp(int(caches.l1d / 2 / (element * 8)) / 16 * 16, 64, 1024);
+        profile.gemmMC = std::clamp(int(caches.l2 / 2 / (element * profile.gemmKC)) / 8 * 8, 32, 2048);
+        long l3 = caches.l3 > 0 ? caches.l3 : 4 * caches.l2;
+        profile.gemmNC = std::clamp(int(l3 / 2 / (element * profile.gemmKC)) / 16 * 16, 256, 16384);
+        return profile;
+    }
+
+    /**
+     * @brief Applies "key=value" lines to a profile.
+     * @throws std::runtime_error If a known key has a non-numeric or non-positive value.
+     */
+    inline void parseProfile(std::istream& in, Profile& profile, const std::string& source) {
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            ++lineNumber;
+            line = line.substr(0, line.find('#'));
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) continue;
+            std::string key = line.substr(0, eq);
+            key.erase(0, key.find_first_not_of(" \t"));
+            key.erase(key.find_last_not_of(" \t\r") + 1);
+            std::istringstream valueStream(line.substr(eq + 1));
+            long long value = 0;
+            if (!(valueStream >> value) || value <= 0) {
+                throw std::runtime_error("Error: Invalid value for '" + key + "' in tuning profile " +
+                                         source + " at line " + std::to_string(lineNumber));
+            }
+            if (key == "strassen_cutoff") profile.strassenCutoff = int(value);
+            else if (key == "gemm_mc") profile.gemmMC = int(value);
+            else if (key == "gemm_kc") profile.gemmKC = int(value);
+            else if (key == "gemm_nc") profile.gemmNC = int(value);
+            else if (key == "lu_panel") profile.luPanel = int(value);
+            else if (key == "parallel_grain") profile.parallelGrain = value;
+        }
+    }
+
+    inline std::string defaultProfilePath() {
+        if (const char* path = std::getenv("LINEARCPP_TUNING_PROFILE")) {
+            return path;
+        }
+        if (const char* config = std::getenv("XDG_CONFIG_HOME")) {
+            return std::string(config) + "/linearcpp/tuning.conf";
+        }
+        if (const char* home = std::getenv("HOME")) {
+            return std::string(home) + "/.config/linearcpp/tuning.conf";
+        }
+        return "";
+    }
+
+    /**
+     * @brief Loads a profile file on top of the cache-derived defaults.
+     * * A missing file is not an error and yields the defaults.
+     */
+    inline Profile loadProfile(const std::string& filename) {
+        Profile profile = defaultProfile();
+        std::ifstream file(filename);
+        if (file.is_open()) {
+            parseProfile(file, profile, filename);
+        }
+        return profile;
+    }
+
+    inline void saveProfile(const Profile& profile, const std::string& filename, const std::string& comment = "") {
+        std::ofstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error: Could not create tuning profile " + filename);
+        }
+        file << "# LinearCPP tuning profile\n";
+        if (!comment.empty()) file << "# " << comment << "\n";
+        file << "strassen_cutoff=" << profile.strassenCutoff << "\n"
+             << "gemm_mc=" << profile.gemmMC << "\n"
+             << "gemm_kc=" << profile.gemmKC << "\n"
+             << "gemm_nc=" << profile.gemmNC << "\n"
+             << "lu_panel=" << profile.luPanel << "\n"
+             << "parallel_grain=" << profile.parallelGrain << "\n";
+    }
+
+    namespace detail {
+
+        inline Profile& activeProfile() {
+            static Profile profile = loadProfile(defaultProfilePath());
+            return profile;
+        }
+
+    } // namespace detail
+
+    /**
+     * @brief The active profile, loaded on first use.
+     */
+    inline const Profile& profile() {
+        return detail::activeProfile();
+    }
+
+    /**
+     * @brief Replaces the active profile. Used by the autotuner while searching; must not be
+     * called while other threads run library operations.
+     */
+    inline void setProfile(const Profile& profile) {
+        detail::activeProfile() = profile;
+    }
+
+} // namespace tuning
+
+#endif // TUNING_HPP
@@ -0,0 +1,19 @@
+/**
+ * Compiled kernels of the linearcpp library.
+ *
+ * With LINEARCPP_INSTANTIATE defined (set by the linearcpp target), the instantiation lists
+ * at the end of each header become explicit instantiation definitions, so this translation
+ * unit compiles every kernel once for the element types in Instantiations.hpp.
+ */
+
+#include "Matrix.hpp"
+#include "Product.hpp"
+#include "Gemm.hpp"
+#include "LinearSolver.hpp"
+
+#include "Half.hpp"
+
+// Compile check: the 16-bit storage types take the classical path of operator*, and the
+// Strassen kernels it skips must not be instantiated for them.
+template Matrix<bfloat16> Matrix<bfloat16>::operator*(const Matrix<bfloat16>&) const;
+template Matrix<float16> Matrix<float16>::operator*(const Matrix<float16>&) const;
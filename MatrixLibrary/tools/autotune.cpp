@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "Matrix.hpp"
+#include "LinearSolver.hpp"
+#include "Product.hpp"
+#include "Random.hpp"
+#include "Tuning.hpp"
+
+/**
+ * Per-host autotuner for the kernel parameters in Tuning.hpp.
+ *
+ * Starting from the cache-derived defaults, it searches one parameter at a time
+ * (coordinate descent) and keeps the fastest value:
+ *   1. GEMM block sizes KC, MC, NC on an n x n product,
+ *   2. the Strassen cutoff on an n x n product (with the tuned GEMM as base case),
+ *   3. the LU panel width on an n x n factorization,
+ *   4. the parallel grain on element-wise additions and GEMM.
+ * The result is written to the profile path the library loads at startup.
+ *
+ * Usage: linearcpp_autotune [--size N] [--repeat R] [--output FILE]
+ */
+
+namespace {
+
+    /**
+     * @brief Best-of-`repeat` wall time of `work`, after one warm-up run.
+     */
+    double bestTime(const std::function<void()> &work, int repeat)
+    {
+        work();
+        double best = 1e300;
+        for (int r = 0; r < repeat; ++r)
+        {
+            auto start = std::chrono::steady_clock::now();
+            work();
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    /**
+     * @brief Tries every candidate for one profile field and keeps the fastest.
+     */
+    template <typename Field>
+    void searchParameter(const char *name, tuning::Profile &profile, Field tuning::Profile::*field,
+                         const std::vector<Field> &candidates, const std::function<void()> &work, int repeat)
+    {
+        Field best = profile.*field;
+        double bestSeconds = 1e300;
+        for (Field candidate : candidates)
+        {
+            profile.*field = candidate;
+            tuning::setProfile(profile);
+            double seconds = bestTime(work, repeat);
+            std::cout << "  " << name << "=" << candidate << ": " << seconds * 1e3 << " ms" << std::endl;
+            if (seconds < bestSeconds)
+            {
+                bestSeconds = seconds;
+                best = candidate;
+            }
+        }
+        profile.*field = best;
+        tuning::setProfile(profile);
+        std::cout << "  -> " << name << "=" << best << std::endl;
+    }
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    int n = 1024;
+    int repeat = 3;
+    std::string output = tuning::defaultProfilePath();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc)
+            n = std::atoi(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::atoi(argv[++i]);
+        else if (arg == "--output" && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            std::cout << "Usage: " << argv[0] << " [--size N] [--repeat R] [--output FILE]" << std::endl;
+            return 1;
+        }
+    }
+    if (output.empty())
+    {
+        std::cerr << "[ERROR]: No output path; pass --output or set HOME." << std::endl;
+        return 1;
+    }
+
+    try
+    {
+        tuning::CacheSizes caches = tuning::detectCaches();
+        std::cout << "Caches: L1d " << caches.l1d / 1024 << " KiB, L2 " << caches.l2 / 1024
+                  << " KiB, L3 " << caches.l3 / 1024 << " KiB" << std::endl;
+        tuning::Profile profile = tuning::defaultProfile(caches);
+        tuning::setProfile(profile);
+
+        Matrix<double> A = rng::uniform<double>(n, n, 1, -1.0), B = rng::uniform<double>(n, n, 2, -1.0);
+        Matrix<double> D = rng::diagonallyDominant<double>(n, 3);
+        auto gemmWork = [&] { Matrix<double> C = matrixMultiply(A, B); };
+
+        std::cout << "\n--- GEMM block sizes (n = " << n << ") ---" << std::endl;
+        searchParameter("gemm_kc", profile, &tuning::Profile::gemmKC, {128, 192, 256, 384, 512, 768}, gemmWork, repeat);
+        searchParameter("gemm_mc", profile, &tuning::Profile::gemmMC, {32, 64, 96, 128, 192, 256, 384, 512}, gemmWork, repeat);
+        searchParameter("gemm_nc", profile, &tuning::Profile::gemmNC, {512, 1024, 2048, 4096, 8192}, gemmWork, repeat);
+
+        // Strassen needs a power-of-two size; tune at the largest one not above n.
+        int strassenSize = int(nextPowerOfTwo(n));
+        if (strassenSize > n) strassenSize /= 2;
+        Matrix<double> As = rng::uniform<double>(strassenSize, strassenSize, 1, -1.0);
+        Matrix<double> Bs = rng::uniform<double>(strassenSize, strassenSize, 2, -1.0);
+        std::cout << "\n--- Strassen cutoff (n = " << strassenSize << ") ---" << std::endl;
+        std::vector<int> cutoffs;
+        for (int c = 32; c <= strassenSize; c *= 2) cutoffs.push_back(c);
+        searchParameter("strassen_cutoff", profile, &tuning::Profile::strassenCutoff, cutoffs,
+                        [&] { Matrix<double> C = strassenMultiply(As, Bs, tuning::profile().strassenCutoff); }, repeat);
+
+        std::cout << "\n--- LU panel width (n = " << n << ") ---" << std::endl;
+        searchParameter("lu_panel", profile, &tuning::Profile::luPanel, {16, 32, 48, 64, 96, 128, 192, 256},
+                        [&] { LUResult<double> lu = decomposeLU(D); }, repeat);
+
+        std::cout << "\n--- Parallel grain (" << parallel::numThreads() << " threads) ---" << std::endl;
+        searchParameter("parallel_grain", profile, &tuning::Profile::parallelGrain,
+                        {1LL << 12, 1LL << 14, 1LL << 15, 1LL << 16, 1LL << 18, 1LL << 20},
+                        [&] {
+                            for (int r = 0; r < 8; ++r) { Matrix<double> C = A + B; }
+                            Matrix<double> C = decomposeLU(D).LU;
+                        }, repeat);
+
+        std::filesystem::path path(output);
+        if (path.has_parent_path())
+            std::filesystem::create_directories(path.parent_path());
+        tuning::saveProfile(profile, output,
+                            "generated by linearcpp_autotune --size " + std::to_string(n) + " on " +
+                            std::to_string(parallel::numThreads()) + " threads");
+        std::cout << "\nProfile written to " << output << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "\n[ERROR]: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
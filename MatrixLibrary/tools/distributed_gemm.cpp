@@ -0,0 +1,123 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include "Distributed.hpp"
+#include "Matrix.hpp"
+#include "Product.hpp"
+
+/**
+ * Checks and times the distributed SUMMA / 2.5D product.
+ *
+ * Every process generates its blocks of two pseudo-random n x n matrices, the product is
+ * computed with dist::multiply, and process 0 reports the time, the aggregate GFLOP/s and,
+ * unless --no-check is given, the largest deviation from a local product of the gathered
+ * operands. The exit status is non-zero if that deviation exceeds the tolerance.
+ *
+ * Usage: mpirun -np P linearcpp_distributed_gemm [--size N] [--layers C] [--panel W]
+ *                                                [--repeat R] [--no-check]
+ */
+
+namespace {
+
+    // Deterministic entries in [-1, 1], identical on every process.
+    double entry(int i, int j, int seed)
+    {
+        unsigned long long x = (static_cast<unsigned long long>(i) * 2654435761ULL) ^
+                               (static_cast<unsigned long long>(j) * 40503ULL) ^
+                               (static_cast<unsigned long long>(seed) << 32);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return double(x % 2000001ULL) / 1000000.0 - 1.0;
+    }
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    int n = 1024;
+    int layers = 1;
+    int panel = dist::defaultPanel;
+    int repeat = 3;
+    bool check = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc)
+            n = std::atoi(argv[++i]);
+        else if (arg == "--layers" && i + 1 < argc)
+            layers = std::atoi(argv[++i]);
+        else if (arg == "--panel" && i + 1 < argc)
+            panel = std::atoi(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::atoi(argv[++i]);
+        else if (arg == "--no-check")
+            check = false;
+        else
+        {
+            if (rank == 0)
+                std::cout << "Usage: " << argv[0]
+                          << " [--size N] [--layers C] [--panel W] [--repeat R] [--no-check]" << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
+    }
+
+    int status = 0;
+    try
+    {
+        dist::Grid grid(MPI_COMM_WORLD, layers);
+        auto A = dist::DistMatrix<double>::generate(grid, n, n, [](int i, int j) { return entry(i, j, 1); });
+        auto B = dist::DistMatrix<double>::generate(grid, n, n, [](int i, int j) { return entry(i, j, 2); });
+
+        double best = 1e300;
+        dist::DistMatrix<double> C(grid, n, n);
+        for (int r = 0; r < std::max(1, repeat); ++r)
+        {
+            MPI_Barrier(grid.comm());
+            auto start = std::chrono::steady_clock::now();
+            C = dist::multiply(A, B, panel);
+            MPI_Barrier(grid.comm());
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        if (rank == 0)
+        {
+            std::cout << "Grid " << grid.layers() << " x " << grid.rows() << " x " << grid.cols()
+                      << ", n = " << n << ", panel = " << panel << ": " << best * 1e3 << " ms, "
+                      << 2.0 * n * n * n / best * 1e-9 << " GFLOP/s" << std::endl;
+        }
+
+        if (check)
+        {
+            Matrix<double> globalA = A.gather(), globalB = B.gather(), globalC = C.gather();
+            if (rank == 0)
+            {
+                Matrix<double> reference = matrixMultiply(globalA, globalB);
+                double error = 0.0;
+                for (int i = 0; i < n; ++i)
+                    for (int j = 0; j < n; ++j)
+                        error = std::max(error, std::abs(globalC(i, j) - reference(i, j)));
+                const double tolerance = 1e-12 * n;
+                std::cout << "Max deviation from the local product: " << error
+                          << (error <= tolerance ? " (ok)" : " (FAILED)") << std::endl;
+                status = error <= tolerance ? 0 : 1;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "[ERROR]: " << e.what() << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Finalize();
+    return status;
+}
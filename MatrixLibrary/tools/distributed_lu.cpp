@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "DistributedSolver.hpp"
+#include "Matrix.hpp"
+
+/**
+ * Checks and times the distributed block-cyclic LU decomposition and solve.
+ *
+ * Every process generates its tiles of a pseudo-random n x n matrix, which is factored with
+ * dist::decomposeLU and used to solve A x = b with dist::solve. Process 0 reports the time
+ * and aggregate GFLOP/s of the factorization and, unless --no-check is given, the relative
+ * residual |A x - b| / (|A| |x| n) computed from the gathered matrix. The exit status is
+ * non-zero if that residual exceeds the tolerance.
+ *
+ * Usage: mpirun -np P linearcpp_distributed_lu [--size N] [--block NB] [--repeat R]
+ *                                             [--no-lookahead] [--no-check]
+ */
+
+namespace {
+
+    // Deterministic entries in [-1, 1], identical on every process.
+    double entry(int i, int j, int seed)
+    {
+        unsigned long long x = (static_cast<unsigned long long>(i) * 2654435761ULL) ^
+                               (static_cast<unsigned long long>(j) * 40503ULL) ^
+                               (static_cast<unsigned long long>(seed) << 32);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return double(x % 2000001ULL) / 1000000.0 - 1.0;
+    }
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank = 0;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    int n = 1024;
+    int block = dist::defaultLUBlock;
+    int repeat = 3;
+    bool lookahead = true;
+    bool check = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--size" && i + 1 < argc)
+            n = std::atoi(argv[++i]);
+        else if (arg == "--block" && i + 1 < argc)
+            block = std::atoi(argv[++i]);
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::atoi(argv[++i]);
+        else if (arg == "--no-lookahead")
+            lookahead = false;
+        else if (arg == "--no-check")
+            check = false;
+        else
+        {
+            if (rank == 0)
+                std::cout << "Usage: " << argv[0]
+                          << " [--size N] [--block NB] [--repeat R] [--no-lookahead] [--no-check]" << std::endl;
+            MPI_Finalize();
+            return 1;
+        }
+    }
+    if (n < 1 || block < 1)
+    {
+        if (rank == 0)
+            std::cout << "Error: --size and --block must be positive." << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    int status = 0;
+    try
+    {
+        dist::Grid grid(MPI_COMM_WORLD);
+        auto A = dist::CyclicMatrix<double>::generate(grid, n, n, block, [](int i, int j) { return entry(i, j, 1); });
+        std::vector<double> b(n);
+        for (int i = 0; i < n; ++i)
+            b[i] = entry(i, 0, 2);
+
+        double best = 1e300;
+        dist::LUResult<double> lu{A, {}, 1};
+        for (int r = 0; r < std::max(1, repeat); ++r)
+        {
+            MPI_Barrier(grid.comm());
+            auto start = std::chrono::steady_clock::now();
+            lu = dist::decomposeLU(A, lookahead);
+            MPI_Barrier(grid.comm());
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> x = dist::solve(lu, b);
+        double solveTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (rank == 0)
+        {
+            std::cout << "Grid " << grid.rows() << " x " << grid.cols() << ", n = " << n << ", block = " << block
+                      << (lookahead ? "" : ", no lookahead") << ": LU " << best * 1e3 << " ms, "
+                      << 2.0 / 3.0 * n * n * n / best * 1e-9 << " GFLOP/s; solve " << solveTime * 1e3 << " ms"
+                      << std::endl;
+        }
+
+        if (check)
+        {
+            Matrix<double> global = A.gather();
+            if (rank == 0)
+            {
+                double residual = 0.0, normA = 0.0, normX = 0.0;
+                for (int i = 0; i < n; ++i)
+                {
+                    double sum = -b[i], rowNorm = 0.0;
+                    for (int j = 0; j < n; ++j)
+                    {
+                        sum += global(i, j) * x[j];
+                        rowNorm += std::abs(global(i, j));
+                    }
+                    residual = std::max(residual, std::abs(sum));
+                    normA = std::max(normA, rowNorm);
+                    normX = std::max(normX, std::abs(x[i]));
+                }
+                const double scale = normA * normX * n;
+                const double relative = scale > 0.0 ? residual / scale : residual;
+                const double tolerance = 1e-14;
+                std::cout << "Relative residual: " << relative << (relative <= tolerance ? " (ok)" : " (FAILED)")
+                          << std::endl;
+                status = relative <= tolerance ? 0 : 1;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "[ERROR]: " << e.what() << std::endl;
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    MPI_Bcast(&status, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Finalize();
+    return status;
+}